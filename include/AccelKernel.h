@@ -0,0 +1,200 @@
+#ifndef ACCELKERNEL_H
+#define ACCELKERNEL_H
+
+#include <Arduino.h>
+
+#ifdef ACCEL_KERNEL_DSP
+#include "esp_dsp.h"
+#endif
+
+/*
+  AccelKernel
+  -----------
+  Block kernel for the accelerometer batch (step / fall front end).
+  - Takes up to ACCEL_KERNEL_MAX_BLOCK int16 x / y / z samples and produces
+    squared magnitudes, threshold masks (1 bit per sample) and the block
+    energy, with no float and no sqrt
+  - Squared magnitude is in kernel units: each axis is squared and shifted
+    right by ACCEL_KERNEL_SHIFT before summing, so the result fits an
+    int16 (max 3 * 8192) for the esp-dsp path. Thresholds are converted to
+    the same units once (accelKernelUnits())
+  - The scalar path is the reference. Building with -D ACCEL_KERNEL_DSP
+    squares and sums with esp-dsp (dsps_mul_s16 / dsps_add_s16, PIE on the
+    S3); begin() checks it against the scalar path on fixed vectors and
+    falls back to scalar if any output differs. On the host the same
+    comparison runs against esp-dsp's ANSI reference (test/test_accel_kernel)
+  - benchmark() prints cycles per sample for both paths (esp32-s3-accelbench)
+*/
+
+#define ACCEL_KERNEL_MAX_BLOCK 64   // One bit per sample in a uint64_t mask
+#define ACCEL_KERNEL_SHIFT 17       // Per-axis square >> 17: 0..8192
+
+// Magnitude threshold (raw LSB) -> squared magnitude in kernel units
+static inline uint16_t accelKernelUnits(uint32_t magnitude) {
+    return (uint16_t)(((uint64_t)magnitude * magnitude) >> ACCEL_KERNEL_SHIFT);
+}
+
+// One timestamped accelerometer sample (raw, +-2 g = 16384 LSB/g)
+struct AccelSample {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    uint32_t timeMs;   // From the ODR sample clock
+};
+
+struct AccelBlock {
+    uint16_t mag2[ACCEL_KERNEL_MAX_BLOCK];  // Squared magnitude (kernel units)
+    uint64_t aboveStep = 0;                 // mag2 > step threshold
+    uint64_t belowLow = 0;                  // mag2 < free-fall threshold
+    uint64_t aboveHigh = 0;                 // mag2 > impact threshold
+    uint32_t energy = 0;                    // Sum of mag2 over the block
+    uint8_t count = 0;
+};
+
+class AccelKernel {
+  private:
+    uint16_t stepUnits = 0;
+    uint16_t lowUnits = 0;
+    uint16_t highUnits = 0;
+    bool useDsp = false;
+    uint64_t totalEnergy = 0;
+    uint32_t totalSamples = 0;
+
+    // --- SQUARED MAGNITUDE ---
+    static void squaresScalar(const int16_t *x, const int16_t *y, const int16_t *z, uint8_t n, uint16_t *out) {
+        for (uint8_t i = 0; i < n; i++) {
+            int32_t sx = ((int32_t)x[i] * x[i]) >> ACCEL_KERNEL_SHIFT;
+            int32_t sy = ((int32_t)y[i] * y[i]) >> ACCEL_KERNEL_SHIFT;
+            int32_t sz = ((int32_t)z[i] * z[i]) >> ACCEL_KERNEL_SHIFT;
+            out[i] = (uint16_t)(sx + sy + sz);
+        }
+    }
+
+#ifdef ACCEL_KERNEL_DSP
+    static void squaresDsp(const int16_t *x, const int16_t *y, const int16_t *z, uint8_t n, uint16_t *out) {
+        int16_t *sum = (int16_t *)out;
+        int16_t sy[ACCEL_KERNEL_MAX_BLOCK];
+        int16_t sz[ACCEL_KERNEL_MAX_BLOCK];
+        dsps_mul_s16(x, x, sum, n, 1, 1, 1, ACCEL_KERNEL_SHIFT);
+        dsps_mul_s16(y, y, sy, n, 1, 1, 1, ACCEL_KERNEL_SHIFT);
+        dsps_mul_s16(z, z, sz, n, 1, 1, 1, ACCEL_KERNEL_SHIFT);
+        dsps_add_s16(sum, sy, sum, n, 1, 1, 1, 0);
+        dsps_add_s16(sum, sz, sum, n, 1, 1, 1, 0);
+    }
+#endif
+
+    // --- MASKS + ENERGY (shared by both paths) ---
+    void classify(AccelBlock &out) {
+        uint64_t above = 0, low = 0, high = 0;
+        uint32_t energy = 0;
+        for (uint8_t i = 0; i < out.count; i++) {
+            uint16_t m = out.mag2[i];
+            uint64_t bit = (uint64_t)1 << i;
+            if (m > stepUnits) above |= bit;
+            if (m < lowUnits) low |= bit;
+            if (m > highUnits) high |= bit;
+            energy += m;
+        }
+        out.aboveStep = above;
+        out.belowLow = low;
+        out.aboveHigh = high;
+        out.energy = energy;
+    }
+
+    void run(const int16_t *x, const int16_t *y, const int16_t *z, uint8_t n, AccelBlock &out, bool dsp) {
+        if (n > ACCEL_KERNEL_MAX_BLOCK) n = ACCEL_KERNEL_MAX_BLOCK;
+        out.count = n;
+#ifdef ACCEL_KERNEL_DSP
+        if (dsp) squaresDsp(x, y, z, n, out.mag2);
+        else squaresScalar(x, y, z, n, out.mag2);
+#else
+        (void)dsp;
+        squaresScalar(x, y, z, n, out.mag2);
+#endif
+        classify(out);
+    }
+
+    // Fixed test vectors: full-scale corners plus a pseudo-random walk
+    static void testVectors(int16_t *x, int16_t *y, int16_t *z, uint8_t n, uint32_t seed) {
+        static const int16_t corners[] = { 0, 1, -1, 32767, -32768, 16384, -16384, 6000 };
+        for (uint8_t i = 0; i < n; i++) {
+            seed = seed * 1664525 + 1013904223; // LCG
+            if (i < 8) {
+                x[i] = corners[i];
+                y[i] = corners[7 - i];
+                z[i] = corners[(i + 3) & 7];
+            } else {
+                x[i] = (int16_t)(seed >> 16);
+                y[i] = (int16_t)(seed >> 8);
+                z[i] = (int16_t)seed;
+            }
+        }
+    }
+
+  public:
+    // Thresholds are magnitudes in raw LSB (+-2 g: 16384 = 1 g)
+    bool begin(uint32_t stepThreshold, uint32_t fallLowThreshold, uint32_t fallHighThreshold) {
+        stepUnits = accelKernelUnits(stepThreshold);
+        lowUnits = accelKernelUnits(fallLowThreshold);
+        highUnits = accelKernelUnits(fallHighThreshold);
+        useDsp = false;
+#ifdef ACCEL_KERNEL_DSP
+        useDsp = selfCheck();
+        Serial.println(useDsp ? "✅ Accel kernel: esp-dsp path matches scalar"
+                              : "❌ Accel kernel: esp-dsp mismatch, using scalar");
+#endif
+        return true;
+    }
+
+    void process(const int16_t *x, const int16_t *y, const int16_t *z, uint8_t n, AccelBlock &out) {
+        run(x, y, z, n, out, useDsp);
+        totalEnergy += out.energy;
+        totalSamples += out.count;
+    }
+
+    // Returns true if the esp-dsp path reproduces the scalar reference on
+    // every block length (always true without ACCEL_KERNEL_DSP)
+    bool selfCheck() {
+        int16_t x[ACCEL_KERNEL_MAX_BLOCK], y[ACCEL_KERNEL_MAX_BLOCK], z[ACCEL_KERNEL_MAX_BLOCK];
+        AccelBlock ref, dsp;
+        for (uint8_t n = 1; n <= ACCEL_KERNEL_MAX_BLOCK; n++) {
+            testVectors(x, y, z, n, n);
+            run(x, y, z, n, ref, false);
+            run(x, y, z, n, dsp, true);
+            if (memcmp(ref.mag2, dsp.mag2, n * sizeof(uint16_t)) != 0 || ref.aboveStep != dsp.aboveStep ||
+                ref.belowLow != dsp.belowLow || ref.aboveHigh != dsp.aboveHigh || ref.energy != dsp.energy) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Cycles per sample over full blocks, scalar vs esp-dsp
+    void benchmark(uint16_t blocks = 1000) {
+        int16_t x[ACCEL_KERNEL_MAX_BLOCK], y[ACCEL_KERNEL_MAX_BLOCK], z[ACCEL_KERNEL_MAX_BLOCK];
+        AccelBlock out;
+        testVectors(x, y, z, ACCEL_KERNEL_MAX_BLOCK, 1);
+
+        Serial.println("--- ACCEL KERNEL BENCHMARK ---");
+        for (uint8_t path = 0; path < 2; path++) {
+#ifndef ACCEL_KERNEL_DSP
+            if (path == 1) break;
+#endif
+            uint32_t start = ESP.getCycleCount();
+            for (uint16_t b = 0; b < blocks; b++) run(x, y, z, ACCEL_KERNEL_MAX_BLOCK, out, path == 1);
+            uint32_t cycles = ESP.getCycleCount() - start;
+            Serial.printf("%-8s %6.1f cycles/sample (energy %lu)\n", path ? "esp-dsp" : "scalar",
+                          (float)cycles / ((uint32_t)blocks * ACCEL_KERNEL_MAX_BLOCK), (unsigned long)out.energy);
+        }
+#ifdef ACCEL_KERNEL_DSP
+        Serial.printf("Self-check: %s\n", selfCheck() ? "OK" : "MISMATCH");
+#endif
+    }
+
+    // --- GETTERS ---
+    bool isDsp() { return useDsp; }
+    uint64_t getTotalEnergy() { return totalEnergy; }
+    uint32_t getTotalSamples() { return totalSamples; }
+};
+
+#endif
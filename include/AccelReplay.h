@@ -0,0 +1,304 @@
+#ifndef ACCELREPLAY_H
+#define ACCELREPLAY_H
+
+#include <Arduino.h>
+#include <math.h>
+#include "AccelKernel.h"
+#include "ActivityClassifier.h"
+#include "FallDetector.h"
+#include "EpisodeRecorder.h"
+
+/*
+  AccelReplay
+  -----------
+  Replays accelerometer data through the activity pipeline (esp32-s3-accelreplay).
+  - Synthetic cases with a known label (idle, walk, run, stairs, and a
+    wrist turning back and forth with no steps: active) are generated at
+    the 100 Hz ODR and must end in that activity
+  - Synthetic falls (forward fall, trip, slow slump) and non-falls (jump,
+    slap, sitting down hard, turning the wrist, running) go through FallDetector; precision
+    and recall are reported with each case's confidence and stage scores
+  - Every recorded episode on LittleFS (EpisodeRecorder accel channel:
+    x, y, z, dt) is replayed as well: seconds per activity and the fall
+    candidates found (recorded episodes carry no ground truth)
+  - All report the cost per sample
+  - The synthetic cases also run on the host (test/test_accel_replay)
+*/
+
+#define ACCEL_REPLAY_SECONDS 20
+#define ACCEL_REPLAY_MAX_EPISODES 32
+#define ACCEL_REPLAY_FALL_MS 9000       // Length of each fall / non-fall case
+#define ACCEL_REPLAY_EVENT_MS 3000      // Where the event starts in it
+
+enum ReplayFallCase : uint8_t {
+    REPLAY_FALL_FORWARD,
+    REPLAY_FALL_TRIP,
+    REPLAY_FALL_SLUMP,
+    REPLAY_JUMP,
+    REPLAY_SLAP,
+    REPLAY_SIT,
+    REPLAY_TURN,
+    REPLAY_RUN,
+    REPLAY_CASE_COUNT
+};
+
+class AccelReplay {
+  private:
+    AccelKernel kernel;
+    AccelSample batch[ACCEL_KERNEL_MAX_BLOCK];
+    int16_t bx[ACCEL_KERNEL_MAX_BLOCK];
+    int16_t by[ACCEL_KERNEL_MAX_BLOCK];
+    int16_t bz[ACCEL_KERNEL_MAX_BLOCK];
+    AccelBlock block;
+    uint8_t count = 0;
+    uint32_t seed = 1;
+    uint8_t failures = 0;
+    uint8_t precision = 100;   // Fall cases, %
+    uint8_t recall = 100;
+    ActivityClassifier *classifier = nullptr;   // Sinks for the current case
+    FallDetector *fall = nullptr;
+
+    int16_t noise(int16_t amplitude) {
+        seed = seed * 1664525 + 1013904223;
+        return (int16_t)((int32_t)(seed >> 16) % (2 * amplitude + 1) - amplitude);
+    }
+
+    static int16_t clamp16(float v) {
+        if (v > 32767) return 32767;
+        if (v < -32768) return -32768;
+        return (int16_t)v;
+    }
+
+    void push(int16_t x, int16_t y, int16_t z, uint32_t timeMs) {
+        batch[count].x = x;
+        batch[count].y = y;
+        batch[count].z = z;
+        batch[count].timeMs = timeMs;
+        bx[count] = x;
+        by[count] = y;
+        bz[count] = z;
+        if (++count == ACCEL_KERNEL_MAX_BLOCK) flush();
+    }
+
+    void flush() {
+        if (count == 0) return;
+        kernel.process(bx, by, bz, count, block);
+        if (classifier) classifier->addBlock(batch, block, 0);
+        if (fall) fall->addBlock(batch, block);
+        count = 0;
+    }
+
+    void pushG(float x, float y, float z, uint32_t timeMs) {
+        push(clamp16(x * 16384) + noise(100), clamp16(y * 16384) + noise(100),
+             clamp16(z * 16384) + noise(100), timeMs);
+    }
+
+    // stepHz: step frequency, amplitude in g, climb in m/s; turnHz > 0
+    // instead turns the wrist +-60 degrees about x (constant magnitude)
+    void synthetic(const char *name, ActivityType expected, float stepHz, float amplitude, float climb,
+                   float turnHz = 0) {
+        ActivityClassifier activity;
+        activity.begin();
+        classifier = &activity;
+        fall = nullptr;
+        seed = 1;
+        count = 0;
+
+        for (uint32_t i = 0; i < (uint32_t)ACCEL_REPLAY_SECONDS * ACCEL_ODR_HZ; i++) {
+            uint32_t t = i * 1000 / ACCEL_ODR_HZ;
+            if (turnHz > 0) {
+                float angle = (PI / 3) * sinf(2 * PI * turnHz * t / 1000.0f);
+                push(noise(150), clamp16(sinf(angle) * 16384) + noise(150), clamp16(cosf(angle) * 16384) + noise(150), t);
+                continue;
+            }
+            float phase = 2 * PI * stepHz * t / 1000.0f;
+            float vertical = amplitude * sinf(phase);
+            float sway = 0.3f * amplitude * sinf(phase / 2);
+            push(clamp16(sway * 16384) + noise(150), noise(150), clamp16((1 + vertical) * 16384) + noise(150), t);
+            if (i % ACCEL_ODR_HZ == 0) activity.addAltitude(climb * t / 1000.0f, t);
+        }
+        flush();
+
+        bool ok = activity.getActivity() == expected;
+        if (!ok) failures++;
+        Serial.printf("%-8s %-6s cadence %3u, SMA %4u mg, %5lu ns/sample, max hop %3lu us  %s\n", name,
+                      ActivityClassifier::getName(activity.getActivity()), activity.getCadence(),
+                      activity.getSmaMilliG(), (unsigned long)activity.getNanosPerSample(),
+                      (unsigned long)activity.getMaxHopMicros(), ok ? "OK" : "WRONG");
+    }
+
+    // One sample of a fall / non-fall case, in g (upright: gravity on z)
+    void fallSample(ReplayFallCase c, uint32_t t) {
+        float walk = 0.3f * sinf(2 * PI * 1.8f * t / 1000.0f);
+        float run = 1.0f * sinf(2 * PI * 2.8f * t / 1000.0f);
+        int32_t e = (int32_t)t - ACCEL_REPLAY_EVENT_MS;   // ms since the event
+
+        switch (c) {
+        case REPLAY_FALL_FORWARD:   // Walk, 300 ms free-fall, 3.5 g impact, lying still
+        case REPLAY_FALL_TRIP:      // Walk, 150 ms free-fall, 2.5 g impact, lying still
+        case REPLAY_JUMP: {         // Walk, 300 ms airborne, 3 g landing, walk on
+            int32_t airMs = (c == REPLAY_FALL_TRIP) ? 150 : 300;
+            float impact = (c == REPLAY_FALL_FORWARD) ? 3.5f : (c == REPLAY_FALL_TRIP) ? 2.5f : 3.0f;
+            if (e < 0) pushG(0.1f * walk, 0, 1 + walk, t);
+            else if (e < airMs) pushG(0.05f, 0.05f, 0.05f, t);
+            else if (e < airMs + 40) pushG(impact * 0.8f, 0, impact * 0.6f, t);
+            else if (c == REPLAY_JUMP) pushG(0.1f * walk, 0, 1 + walk, t);
+            else pushG(1, 0, 0.05f, t);
+            break;
+        }
+        case REPLAY_FALL_SLUMP: {   // Standing, 1.5 s slide to lying, no impact, still
+            if (e < 0) {
+                pushG(0, 0, 1, t);
+            } else if (e < 1500) {
+                float angle = (PI / 2) * e / 1500.0f;
+                pushG(sinf(angle), 0, cosf(angle), t);
+            } else {
+                pushG(1, 0, 0.05f, t);
+            }
+            break;
+        }
+        case REPLAY_SLAP:           // Walking, sharp 4 g knock, walking on
+            if (e >= 0 && e < 30) pushG(0, 2.4f, 3.2f, t);
+            else pushG(0.1f * walk, 0, 1 + walk, t);
+            break;
+        case REPLAY_SIT: {          // Walk, 2 g sit-down, still with a 20 degree tilt
+            if (e < 0) pushG(0.1f * walk, 0, 1 + walk, t);
+            else if (e < 40) pushG(0, 0, 2.0f, t);
+            else pushG(0.34f, 0, 0.94f, t);
+            break;
+        }
+        case REPLAY_TURN: {         // Standing, wrist turning +-60 degrees at 0.5 Hz
+            float angle = (PI / 3) * sinf(2 * PI * 0.5f * t / 1000.0f);
+            pushG(sinf(angle), 0, cosf(angle), t);
+            break;
+        }
+        case REPLAY_RUN:            // Running throughout
+        default:
+            pushG(0.2f * run, 0, 1 + run, t);
+            break;
+        }
+    }
+
+    void fallCases() {
+        static const char *names[REPLAY_CASE_COUNT] = { "forward", "trip", "slump", "jump", "slap", "sit", "turn", "run" };
+        uint8_t truePos = 0, falsePos = 0, falseNeg = 0;
+        uint32_t samples = 0;
+        unsigned long micro = 0;
+
+        Serial.println("--- ACCEL REPLAY: falls ---");
+        for (uint8_t c = 0; c < REPLAY_CASE_COUNT; c++) {
+            FallDetector detector;
+            detector.begin();
+            classifier = nullptr;
+            fall = &detector;
+            seed = 7;
+            count = 0;
+
+            unsigned long start = micros();
+            for (uint32_t t = 0; t < ACCEL_REPLAY_FALL_MS; t += 1000 / ACCEL_ODR_HZ) fallSample((ReplayFallCase)c, t);
+            flush();
+            micro += micros() - start;
+            samples += ACCEL_REPLAY_FALL_MS * ACCEL_ODR_HZ / 1000;
+
+            bool isFall = c <= REPLAY_FALL_SLUMP;
+            bool detected = detector.getConfirmed() > 0;
+            if (detected && isFall) truePos++;
+            if (detected && !isFall) falsePos++;
+            if (!detected && isFall) falseNeg++;
+
+            const FallEvent &e = detector.getLastEvent();
+            Serial.printf("%-8s %-8s conf %3u (ff %3u imp %3u ori %3u still %3u) %4u mg %2u deg %-6s %lu candidates  %s\n",
+                          names[c], isFall ? "fall" : "non-fall", e.confidence, e.freefallScore, e.impactScore,
+                          e.orientationScore, e.inactivityScore, e.impactMilliG, e.angleDeg,
+                          e.tilt ? "tilt," : "",
+                          (unsigned long)detector.getCandidates(), (detected == isFall) ? "OK" : "WRONG");
+            if (detected != isFall) failures++;
+        }
+
+        uint8_t detected = truePos + falsePos;
+        uint8_t falls = truePos + falseNeg;
+        precision = detected ? 100 * truePos / detected : 100;
+        recall = falls ? 100 * truePos / falls : 100;
+        Serial.printf("Precision %u%%, recall %u%%, %lu ns/sample (incl. kernel)\n", precision, recall,
+                      samples ? (unsigned long)((uint64_t)micro * 1000 / samples) : 0UL);
+    }
+
+    void episodes() {
+        static int32_t values[EPISODE_PAGE_SIZE * 4];
+        EpisodeReader reader;
+        for (uint16_t n = 0; n < ACCEL_REPLAY_MAX_EPISODES; n++) {
+            if (!reader.open(n)) continue;
+            ActivityClassifier activity;
+            FallDetector detector;
+            activity.begin();
+            detector.begin();
+            classifier = &activity;
+            fall = &detector;
+            count = 0;
+            uint32_t t = 0;
+
+            EpisodeBlock info;
+            while (reader.next(info, values, sizeof(values) / sizeof(values[0]))) {
+                if (info.channel != EPISODE_CH_ACC || info.width != 4) continue;
+                for (uint16_t f = 0; f < info.frames; f++) {
+                    const int32_t *v = &values[f * 4];
+                    t += v[3];
+                    push((int16_t)v[0], (int16_t)v[1], (int16_t)v[2], t);
+                }
+            }
+            flush();
+            reader.close();
+
+            Serial.printf("ep_%04u  reason %u: idle %lus walk %lus run %lus stairs %lus active %lus, "
+                          "%lu samples, %lu ns/sample, falls %lu of %lu candidates (last conf %u)\n",
+                          n, reader.getReason(), (unsigned long)activity.getActivitySeconds(ACTIVITY_IDLE),
+                          (unsigned long)activity.getActivitySeconds(ACTIVITY_WALK),
+                          (unsigned long)activity.getActivitySeconds(ACTIVITY_RUN),
+                          (unsigned long)activity.getActivitySeconds(ACTIVITY_STAIRS),
+                          (unsigned long)activity.getActivitySeconds(ACTIVITY_OTHER),
+                          (unsigned long)activity.getSamples(), (unsigned long)activity.getNanosPerSample(),
+                          (unsigned long)detector.getConfirmed(), (unsigned long)detector.getCandidates(),
+                          detector.getLastEvent().confidence);
+        }
+    }
+
+  public:
+    // Synthetic activity cases; returns the number classified wrongly
+    uint8_t runActivity() {
+        kernel.begin(15000, 6000, 25000);
+        failures = 0;
+
+        Serial.println("--- ACCEL REPLAY: activity ---");
+        synthetic("idle", ACTIVITY_IDLE, 0, 0, 0);
+        synthetic("walk", ACTIVITY_WALK, 1.8f, 0.3f, 0);
+        synthetic("run", ACTIVITY_RUN, 2.8f, 1.0f, 0);
+        synthetic("stairs", ACTIVITY_STAIRS, 1.6f, 0.3f, 0.2f);
+        synthetic("gesture", ACTIVITY_OTHER, 0, 0, 0, 0.5f);
+        return failures;
+    }
+
+    // Fall / non-fall cases; returns the number classified wrongly
+    uint8_t runFalls() {
+        kernel.begin(15000, 6000, 25000);
+        failures = 0;
+        fallCases();
+        return failures;
+    }
+
+    // Everything, recorded episodes included; returns the synthetic cases
+    // (activity and falls) classified wrongly
+    uint8_t run() {
+        uint8_t wrong = runActivity();
+        wrong += runFalls();
+        episodes();
+
+        Serial.printf("--- %u cases wrong ---\n", wrong);
+        return wrong;
+    }
+
+    // --- RESULTS OF runFalls() ---
+    uint8_t getPrecision() { return precision; }
+    uint8_t getRecall() { return recall; }
+};
+
+#endif
@@ -0,0 +1,334 @@
+#ifndef ACTIVITYCLASSIFIER_H
+#define ACTIVITYCLASSIFIER_H
+
+#include <Arduino.h>
+#include "ActivityManager.h"
+
+/*
+  ActivityClassifier
+  ------------------
+  Idle / walk / run / stairs from sliding accelerometer windows.
+  - Works on ActivityManager's batches (AccelKernel output, no float per
+    sample). Every feature is a running total over the window, updated in
+    O(1) per sample:
+      variance  : dynamic magnitude (squared magnitude minus a slow
+                  gravity baseline), ring of the last ACTIVITY_WINDOW values
+      SMA       : |x - gx| + |y - gy| + |z - gz| against per-axis gravity
+      cadence   : mean interval between magnitude peaks (hysteresis
+                  crossings), ring of the last ACTIVITY_MAX_INTERVALS
+  - Every ACTIVITY_HOP samples the window is classified in constant time;
+    walking with a steady altitude change (WeatherManager, 1 Hz) is stairs
+  - The magnitude does not change when the wrist only turns (gestures,
+    typing, brushing teeth), so a quiet variance with a high SMA is
+    active, not idle
+  - Distance uses a per-activity stride (from body height), energy uses
+    per-activity METs (active kcal, from body weight)
+  - Samples and classification are timed; hops over ACTIVITY_HOP_BUDGET_US
+    are counted
+*/
+
+#define ACTIVITY_WINDOW 256            // Samples per feature window (2.56 s at 100 Hz)
+#define ACTIVITY_HOP 100               // Classify every 100 samples (1 s)
+#define ACTIVITY_BASELINE_SHIFT 8      // Gravity EMA: 256 samples
+#define ACTIVITY_PEAK_HYST 160         // Dynamic magnitude hysteresis (~0.04 g, kernel units)
+#define ACTIVITY_MAX_INTERVALS 8
+#define ACTIVITY_MIN_INTERVAL_MS 250   // 240 steps/min
+#define ACTIVITY_MAX_INTERVAL_MS 2000  // 30 steps/min; longer = no cadence
+#define ACTIVITY_ALT_SAMPLES 8         // Altitude trend over 7 s
+#define ACTIVITY_STALE_MS 2000         // No samples for this long = idle
+#define ACTIVITY_HOP_BUDGET_US 500
+
+// Thresholds (dynamic magnitude std in kernel units: 1 g change ~ 4096)
+#define ACTIVITY_IDLE_STD 250          // ~0.06 g
+#define ACTIVITY_ACTIVE_SMA_MG 135     // Rest / activity cut on the SMA
+#define ACTIVITY_RUN_STD 1800          // ~0.45 g
+#define ACTIVITY_RUN_CADENCE 140       // steps/min
+#define ACTIVITY_STAIRS_RATE_CM_S 12   // Vertical speed while walking
+
+enum ActivityType : uint8_t {
+    ACTIVITY_IDLE,
+    ACTIVITY_WALK,
+    ACTIVITY_RUN,
+    ACTIVITY_STAIRS,
+    ACTIVITY_OTHER,   // Moving without a step rhythm
+    ACTIVITY_COUNT
+};
+
+class ActivityClassifier {
+  private:
+    // --- PROFILE ---
+    uint16_t heightCm = 170;
+    uint8_t weightKg = 70;
+
+    // --- WINDOW FEATURES ---
+    int16_t dynRing[ACTIVITY_WINDOW];
+    uint16_t smaRing[ACTIVITY_WINDOW];  // Per-sample SMA >> 2
+    uint16_t ringPos = 0;
+    uint16_t ringFill = 0;
+    int32_t dynSum = 0;
+    int64_t dynSumSq = 0;
+    uint32_t smaSum = 0;
+
+    int32_t baseline = 0;               // Gravity EMA of mag2 (<< ACTIVITY_BASELINE_SHIFT)
+    int32_t gravity[3] = { 0, 0, 0 };   // Per-axis gravity EMA (<< ACTIVITY_BASELINE_SHIFT)
+    bool primed = false;
+
+    // Cadence: peak intervals
+    bool armed = false;                 // Dynamic magnitude went below -hysteresis
+    uint32_t lastPeakMs = 0;
+    uint16_t intervals[ACTIVITY_MAX_INTERVALS];
+    uint8_t intervalPos = 0;
+    uint8_t intervalCount = 0;
+    uint32_t intervalSum = 0;
+
+    // Altitude trend (cm, 1 Hz)
+    int32_t altCm[ACTIVITY_ALT_SAMPLES];
+    uint32_t altMs[ACTIVITY_ALT_SAMPLES];
+    uint8_t altPos = 0;
+    uint8_t altCount = 0;
+
+    // --- OUTPUT ---
+    ActivityType activity = ACTIVITY_IDLE;
+    uint16_t cadence = 0;               // steps/min
+    int16_t climbRate = 0;              // cm/s
+    float distanceM = 0;
+    float energyKcal = 0;
+    uint16_t hopSamples = 0;
+    uint32_t hopStartMs = 0;
+    uint32_t lastSampleMs = 0;
+    unsigned long lastSampleMillis = 0;
+    int lastSteps = -1;
+    uint32_t activitySeconds[ACTIVITY_COUNT];
+
+    // --- CPU ---
+    uint32_t samples = 0;
+    uint64_t sampleMicros = 0;
+    uint32_t hops = 0;
+    uint32_t maxHopMicros = 0;
+    uint32_t hopOverruns = 0;
+
+    void resetCadence() {
+        intervalPos = 0;
+        intervalCount = 0;
+        intervalSum = 0;
+    }
+
+    void addInterval(uint16_t ms) {
+        if (intervalCount == ACTIVITY_MAX_INTERVALS) intervalSum -= intervals[intervalPos];
+        else intervalCount++;
+        intervals[intervalPos] = ms;
+        intervalSum += ms;
+        intervalPos = (intervalPos + 1) % ACTIVITY_MAX_INTERVALS;
+    }
+
+    void addSample(const AccelSample &s, uint16_t mag2) {
+        if (!primed) {
+            baseline = (int32_t)mag2 << ACTIVITY_BASELINE_SHIFT;
+            gravity[0] = (int32_t)s.x << ACTIVITY_BASELINE_SHIFT;
+            gravity[1] = (int32_t)s.y << ACTIVITY_BASELINE_SHIFT;
+            gravity[2] = (int32_t)s.z << ACTIVITY_BASELINE_SHIFT;
+            hopStartMs = s.timeMs;
+            primed = true;
+        }
+
+        // Dynamic magnitude and SMA against the slow gravity estimates
+        baseline += mag2 - (baseline >> ACTIVITY_BASELINE_SHIFT);
+        int32_t dyn = (int32_t)mag2 - (baseline >> ACTIVITY_BASELINE_SHIFT);
+        if (dyn > 32767) dyn = 32767;
+        if (dyn < -32768) dyn = -32768;
+
+        const int16_t axis[3] = { s.x, s.y, s.z };
+        uint32_t sma = 0;
+        for (uint8_t a = 0; a < 3; a++) {
+            gravity[a] += axis[a] - (gravity[a] >> ACTIVITY_BASELINE_SHIFT);
+            sma += abs(axis[a] - (gravity[a] >> ACTIVITY_BASELINE_SHIFT));
+        }
+        sma >>= 2;
+        if (sma > 65535) sma = 65535;
+
+        // Slide the window (running totals)
+        if (ringFill == ACTIVITY_WINDOW) {
+            int16_t old = dynRing[ringPos];
+            dynSum -= old;
+            dynSumSq -= (int32_t)old * old;
+            smaSum -= smaRing[ringPos];
+        } else {
+            ringFill++;
+        }
+        dynRing[ringPos] = (int16_t)dyn;
+        smaRing[ringPos] = (uint16_t)sma;
+        dynSum += dyn;
+        dynSumSq += dyn * dyn;
+        smaSum += sma;
+        ringPos = (ringPos + 1) % ACTIVITY_WINDOW;
+
+        // Peaks: rise through +hysteresis after dipping below -hysteresis
+        if (dyn < -ACTIVITY_PEAK_HYST) {
+            armed = true;
+        } else if (armed && dyn > ACTIVITY_PEAK_HYST) {
+            armed = false;
+            uint32_t interval = s.timeMs - lastPeakMs;
+            if (interval >= ACTIVITY_MIN_INTERVAL_MS && interval <= ACTIVITY_MAX_INTERVAL_MS) {
+                addInterval((uint16_t)interval);
+            }
+            lastPeakMs = s.timeMs;
+        }
+        if (s.timeMs - lastPeakMs > ACTIVITY_MAX_INTERVAL_MS) resetCadence();
+
+        lastSampleMs = s.timeMs;
+    }
+
+    // Squared std of the dynamic magnitude over the window
+    uint32_t variance() {
+        if (ringFill == 0) return 0;
+        int64_t mean = dynSum / ringFill;
+        int64_t var = dynSumSq / ringFill - mean * mean;
+        return (var > 0) ? (uint32_t)var : 0;
+    }
+
+    uint16_t strideCm(ActivityType type) {
+        switch (type) {
+        case ACTIVITY_WALK: return heightCm * 415 / 1000;
+        case ACTIVITY_RUN: return heightCm * 650 / 1000;
+        case ACTIVITY_STAIRS: return 28; // Horizontal tread
+        default: return heightCm * 415 / 1000;
+        }
+    }
+
+    // Metabolic equivalents x10 (resting = 10)
+    uint8_t met10(ActivityType type) {
+        switch (type) {
+        case ACTIVITY_WALK: return (cadence >= 110) ? 43 : 35;
+        case ACTIVITY_RUN: return (cadence >= 170) ? 110 : 90;
+        case ACTIVITY_STAIRS: return (climbRate > 0) ? 80 : 50;
+        case ACTIVITY_OTHER: return 20;
+        default: return 10;
+        }
+    }
+
+    // Constant-time classification of the current window
+    void classify(int steps) {
+        uint32_t var = variance();
+        cadence = intervalCount ? (uint16_t)(60000UL * intervalCount / intervalSum) : 0;
+
+        if (var < (uint32_t)ACTIVITY_IDLE_STD * ACTIVITY_IDLE_STD) {
+            activity = (getSmaMilliG() >= ACTIVITY_ACTIVE_SMA_MG) ? ACTIVITY_OTHER : ACTIVITY_IDLE;
+            cadence = 0;
+        } else if (cadence == 0) {
+            activity = ACTIVITY_OTHER;
+        } else if (cadence >= ACTIVITY_RUN_CADENCE && var >= (uint32_t)ACTIVITY_RUN_STD * ACTIVITY_RUN_STD) {
+            activity = ACTIVITY_RUN;
+        } else if (abs(climbRate) >= ACTIVITY_STAIRS_RATE_CM_S) {
+            activity = ACTIVITY_STAIRS;
+        } else {
+            activity = ACTIVITY_WALK;
+        }
+
+        // Distance and energy for this hop
+        uint32_t elapsedMs = lastSampleMs - hopStartMs;
+        hopStartMs = lastSampleMs;
+        if (lastSteps >= 0 && steps > lastSteps) distanceM += (steps - lastSteps) * strideCm(activity) / 100.0f;
+        lastSteps = steps;
+        energyKcal += (met10(activity) - 10) / 10.0f * weightKg * elapsedMs / 3600000.0f;
+        activitySeconds[activity] += (elapsedMs + 500) / 1000;
+    }
+
+  public:
+    void begin(uint16_t bodyHeightCm = 170, uint8_t bodyWeightKg = 70) {
+        heightCm = bodyHeightCm;
+        weightKg = bodyWeightKg;
+        ringPos = 0;
+        ringFill = 0;
+        dynSum = 0;
+        dynSumSq = 0;
+        smaSum = 0;
+        primed = false;
+        armed = false;
+        resetCadence();
+        altPos = 0;
+        altCount = 0;
+        activity = ACTIVITY_IDLE;
+        cadence = 0;
+        climbRate = 0;
+        hopSamples = 0;
+        lastSteps = -1;
+        for (uint8_t i = 0; i < ACTIVITY_COUNT; i++) activitySeconds[i] = 0;
+    }
+
+    // Feed the batch ActivityManager just read (with its kernel output).
+    // 'steps' is the step counter after this batch.
+    void addBlock(const AccelSample *batch, const AccelBlock &block, int steps) {
+        if (block.count == 0) return;
+        unsigned long start = micros();
+        for (uint8_t i = 0; i < block.count; i++) {
+            addSample(batch[i], block.mag2[i]);
+            if (++hopSamples < ACTIVITY_HOP) continue;
+            hopSamples = 0;
+
+            unsigned long hopStart = micros();
+            classify(steps);
+            uint32_t hopMicros = micros() - hopStart;
+            hops++;
+            if (hopMicros > maxHopMicros) maxHopMicros = hopMicros;
+            if (hopMicros > ACTIVITY_HOP_BUDGET_US) hopOverruns++;
+        }
+        samples += block.count;
+        sampleMicros += micros() - start;
+        lastSampleMillis = millis();
+    }
+
+    // Altitude in meters (call about once per second)
+    void addAltitude(float meters, uint32_t timeMs) {
+        altCm[altPos] = (int32_t)(meters * 100.0f);
+        altMs[altPos] = timeMs;
+        uint8_t newest = altPos;
+        altPos = (altPos + 1) % ACTIVITY_ALT_SAMPLES;
+        if (altCount < ACTIVITY_ALT_SAMPLES) altCount++;
+
+        if (altCount < 2) return;
+        uint8_t oldest = (altCount == ACTIVITY_ALT_SAMPLES) ? altPos : 0;
+        uint32_t dt = altMs[newest] - altMs[oldest];
+        climbRate = dt ? (int16_t)((altCm[newest] - altCm[oldest]) * 1000 / (int32_t)dt) : 0;
+    }
+
+    // Goes idle when the accelerometer stops delivering samples
+    // (hardware event mode stops the FIFO when there is no motion)
+    void update() {
+        if (activity != ACTIVITY_IDLE && millis() - lastSampleMillis > ACTIVITY_STALE_MS) {
+            activity = ACTIVITY_IDLE;
+            cadence = 0;
+        }
+    }
+
+    // --- GETTERS ---
+    ActivityType getActivity() { return activity; }
+    uint16_t getCadence() { return cadence; }
+    int16_t getClimbRate() { return climbRate; }
+    float getDistanceKm() { return distanceM / 1000.0f; }
+    int getCalories() { return (int)energyKcal; }
+    uint32_t getActivitySeconds(ActivityType type) { return activitySeconds[type]; }
+
+    // Signal magnitude area over the window, in mg
+    uint16_t getSmaMilliG() {
+        return ringFill ? (uint16_t)((uint64_t)smaSum * 4 * 1000 / 16384 / ringFill) : 0;
+    }
+
+    static const char *getName(ActivityType type) {
+        switch (type) {
+        case ACTIVITY_IDLE: return "IDLE";
+        case ACTIVITY_WALK: return "WALK";
+        case ACTIVITY_RUN: return "RUN";
+        case ACTIVITY_STAIRS: return "STAIRS";
+        case ACTIVITY_OTHER: return "ACTIVE";
+        default: return "?";
+        }
+    }
+
+    // --- CPU STATS ---
+    uint32_t getSamples() { return samples; }
+    uint32_t getNanosPerSample() { return samples ? (uint32_t)(sampleMicros * 1000 / samples) : 0; }
+    uint32_t getMaxHopMicros() { return maxHopMicros; }
+    uint32_t getHopOverruns() { return hopOverruns; }
+};
+
+#endif
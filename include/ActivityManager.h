@@ -3,104 +3,371 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "I2CBus.h"
+#include "AccelKernel.h"
+#include "FallDetector.h"
+
+/*
+  ActivityManager
+  ---------------
+  Step counting and fall detection on the MPU6050 accelerometer.
+  - The sensor samples at a fixed ODR (DLPF on, 1 kHz / (1 + SMPLRT_DIV))
+    and queues accelerometer samples in its 1 KB FIFO
+  - The data-ready interrupt counts samples as they are produced; once a
+    watermark's worth is pending, update() burst-reads the whole FIFO
+    (the MPU6050 has no FIFO watermark interrupt of its own)
+  - Every sample is timestamped from the ODR, so step and fall timing no
+    longer depends on the loop rate
+  - Each batch goes through AccelKernel once (squared magnitudes + threshold
+    masks); step counting only visits the samples whose mask bit can
+    change its state, and FallDetector scores fall candidates
+  - FIFO overflows are counted (the FIFO is reset and the lost samples
+    estimated from the interrupt count)
+
+  Hardware event mode (begin(..., true)):
+  - The data-ready interrupt is replaced by the MPU6050's own free-fall and
+    motion detectors on the INT pin
+  - While there is motion the FIFO is drained every ACCEL_POLL_MS for step
+    counting; after ACCEL_IDLE_MS without a motion interrupt the FIFO is
+    stopped and the bus stays silent until the next interrupt
+  - A free-fall interrupt (timed from the ISR) is passed to FallDetector
+    as free-fall evidence; the FIFO keeps running while a candidate is
+    being scored
+*/
+
+#define MPU6050_ADDR 0x68
+#define MPU6050_I2C_CLOCK 400000
+
+// Registers
+#define MPU6050_SMPLRT_DIV 0x19
+#define MPU6050_CONFIG 0x1A
+#define MPU6050_ACCEL_CONFIG 0x1C
+#define MPU6050_FF_THR 0x1D
+#define MPU6050_FF_DUR 0x1E
+#define MPU6050_MOT_THR 0x1F
+#define MPU6050_MOT_DUR 0x20
+#define MPU6050_FIFO_EN 0x23
+#define MPU6050_INT_PIN_CFG 0x37
+#define MPU6050_INT_ENABLE 0x38
+#define MPU6050_INT_STATUS 0x3A
+#define MPU6050_USER_CTRL 0x6A
+#define MPU6050_PWR_MGMT_1 0x6B
+#define MPU6050_FIFO_COUNT_H 0x72
+#define MPU6050_FIFO_R_W 0x74
+
+// Register values
+#define MPU6050_DLPF_44HZ 0x03          // CONFIG: accel 44 Hz bandwidth, 1 kHz internal rate
+#define MPU6050_FIFO_ACCEL 0x08         // FIFO_EN: accelerometer only
+#define MPU6050_ACCEL_HPF_5HZ 0x01     // ACCEL_CONFIG: high-pass feeding the motion detectors
+#define MPU6050_INT_DATA_RDY 0x01
+#define MPU6050_INT_FIFO_OFLOW 0x10
+#define MPU6050_INT_MOT 0x40
+#define MPU6050_INT_FF 0x80
+#define MPU6050_USER_FIFO_EN 0x40
+#define MPU6050_USER_FIFO_RESET 0x04
+#define MPU6050_CLOCK_PLL_X 0x01        // PWR_MGMT_1: wake, gyro X PLL clock
+
+#define ACCEL_ODR_HZ 100
+#define ACCEL_BYTES_PER_SAMPLE 6
+#define ACCEL_FIFO_BYTES 1024
+#define ACCEL_WATERMARK 10              // Samples pending before a burst read (100 ms)
+#define ACCEL_MAX_BATCH ACCEL_KERNEL_MAX_BLOCK // Samples read per update()
+#define ACCEL_POLL_MS 100               // Read interval when no data-ready interrupt is used
+
+// Hardware event mode (register units: ~2 mg and 1 ms per LSB)
+#define ACCEL_FF_THRESHOLD 100          // Every axis below ~0.2 g (software: |a| < 6000 LSB)
+#define ACCEL_FF_DURATION 40            // ms below the threshold
+#define ACCEL_MOT_THRESHOLD 20          // ~40 mg after the high-pass (walking)
+#define ACCEL_MOT_DURATION 5            // ms above the threshold
+#define ACCEL_IDLE_MS 10000             // No motion interrupt for this long = stop the FIFO
 
 class ActivityManager {
   private:
+    I2CBus *bus = nullptr;
+    uint8_t busDevice = 0;
+
+    // --- FIFO ACQUISITION ---
+    int intPin = -1;
+    bool hwEvents = false;              // Free-fall / motion interrupts instead of data ready
+    volatile uint32_t readyCount = 0;   // Data-ready interrupts since the last read
+    uint32_t sampleIndex = 0;           // Samples produced since begin() (ODR clock)
+    uint32_t fifoOverflows = 0;
+    uint32_t lostSamples = 0;
+    unsigned long lastRead = 0;
+    uint8_t fifoBytes[ACCEL_MAX_BATCH * ACCEL_BYTES_PER_SAMPLE];
+    AccelSample batch[ACCEL_MAX_BATCH];
+    uint8_t batchCount = 0;
+
+    // Kernel input (one array per axis) and output
+    AccelKernel kernel;
+    int16_t batchX[ACCEL_MAX_BATCH];
+    int16_t batchY[ACCEL_MAX_BATCH];
+    int16_t batchZ[ACCEL_MAX_BATCH];
+    AccelBlock block;
+
+    // --- HARDWARE EVENTS ---
+    volatile uint32_t eventCount = 0;   // Free-fall / motion interrupts since the last read
+    volatile uint32_t lastEventMs = 0;
+    bool fifoActive = true;
+    unsigned long lastMotion = 0;
+    uint32_t freefallEvents = 0;
+    uint32_t motionEvents = 0;
+    uint32_t wakeups = 0;
+
     // --- COMMON VARIABLES ---
-    float magnitudePrev = 0;
+    bool abovePrev = false;   // Last sample of the previous batch was above the step threshold
 
     // --- FALL DETECTION VARIABLES ---
-    bool fallDetected = false;
-    unsigned long freefallStartTime = 0;
-    int fallState = 0; 
-    const float fallLowThreshold = 6000;    // "Freefall"
-    const float fallHighThreshold = 25000;  // "Impact"
+    FallDetector fall;
+    const uint32_t fallLowThreshold = 6000;    // "Freefall"
+    const uint32_t fallHighThreshold = 25000;  // "Impact"
 
     // --- STEP COUNTING VARIABLES ---
     int steps = 0;
     unsigned long lastStepTime = 0;
-    const float stepThreshold = 15000; // Sensitivity for walking
+    const uint32_t stepThreshold = 15000; // Sensitivity for walking
     const int stepDelay = 300;         // Minimum ms between steps (debounce)
 
-  public:
-    void begin() {
-        Wire.beginTransmission(0x68);
-        Wire.write(0x6B); 
-        Wire.write(0);    
-        Wire.endTransmission(true);
+    static void IRAM_ATTR onInterrupt(void *arg) {
+        ActivityManager *self = (ActivityManager *)arg;
+        if (self->hwEvents) {
+            self->eventCount++;
+            self->lastEventMs = millis();
+        } else {
+            self->readyCount++;
+        }
     }
 
-    void update() {
-        Wire.beginTransmission(0x68);
-        Wire.write(0x3B); 
-        Wire.endTransmission(false);
-        Wire.requestFrom(0x68, 6, true);
+    uint32_t sampleClockMs() {
+        return (uint32_t)((uint64_t)sampleIndex * 1000 / ACCEL_ODR_HZ);
+    }
+
+    void resetFifo() {
+        bus->writeRegister(busDevice, MPU6050_USER_CTRL, MPU6050_USER_FIFO_RESET, I2C_PRIO_SENSOR);
+        bus->writeRegister(busDevice, MPU6050_USER_CTRL, MPU6050_USER_FIFO_EN, I2C_PRIO_SENSOR);
+    }
+
+    // Restart the FIFO after idle; the sample clock picks up at the current time
+    void startFifo() {
+        sampleIndex = (uint32_t)((uint64_t)millis() * ACCEL_ODR_HZ / 1000);
+        bus->writeRegister(busDevice, MPU6050_FIFO_EN, MPU6050_FIFO_ACCEL, I2C_PRIO_SENSOR);
+        resetFifo();
+        fifoActive = true;
+        wakeups++;
+    }
+
+    void stopFifo() {
+        bus->writeRegister(busDevice, MPU6050_FIFO_EN, 0x00, I2C_PRIO_SENSOR);
+        fifoActive = false;
+    }
+
+    // Burst-read every complete sample in the FIFO (up to one batch).
+    // 'status' is this update's INT_STATUS (reading it clears it).
+    void readFifo(uint8_t status, uint32_t produced) {
+        uint8_t countBytes[2];
+        if (bus->readRegisters(busDevice, MPU6050_FIFO_COUNT_H, countBytes, 2, I2C_PRIO_SENSOR) != I2C_OK) return;
+        uint16_t available = ((uint16_t)countBytes[0] << 8 | countBytes[1]) / ACCEL_BYTES_PER_SAMPLE;
+
+        if (status & MPU6050_INT_FIFO_OFLOW) {
+            // The FIFO kept only its newest bytes and may be misaligned:
+            // drop it, keep the sample clock running over the gap
+            fifoOverflows++;
+            uint32_t gap = (produced > available) ? produced : available;
+            lostSamples += gap;
+            sampleIndex += gap;
+            resetFifo();
+            return;
+        }
+
+        uint16_t count = (available > ACCEL_MAX_BATCH) ? ACCEL_MAX_BATCH : available;
+        if (count == 0) return;
+        if (bus->readRegisters(busDevice, MPU6050_FIFO_R_W, fifoBytes, count * ACCEL_BYTES_PER_SAMPLE,
+                               I2C_PRIO_SENSOR) != I2C_OK) return;
+
+        const uint8_t *p = fifoBytes;
+        for (uint16_t i = 0; i < count; i++, p += ACCEL_BYTES_PER_SAMPLE) {
+            AccelSample &s = batch[i];
+            s.x = (int16_t)(p[0] << 8 | p[1]);
+            s.y = (int16_t)(p[2] << 8 | p[3]);
+            s.z = (int16_t)(p[4] << 8 | p[5]);
+            s.timeMs = sampleClockMs();
+            sampleIndex++;
+            batchX[i] = s.x;
+            batchY[i] = s.y;
+            batchZ[i] = s.z;
+        }
+        batchCount = count;
 
-        int16_t ax = Wire.read() << 8 | Wire.read();
-        int16_t ay = Wire.read() << 8 | Wire.read();
-        int16_t az = Wire.read() << 8 | Wire.read();
+        // Anything left over is picked up on the next call
+        if (available > count && !hwEvents) __atomic_add_fetch(&readyCount, available - count, __ATOMIC_RELAXED);
+    }
+
+    // Stream mode: data-ready watermark (or polling without an INT pin)
+    void updateStream() {
+        bool due = (intPin >= 0) ? readyCount >= ACCEL_WATERMARK
+                                 : millis() - lastRead >= ACCEL_POLL_MS;
+        if (!due) return;
+        lastRead = millis();
+
+        uint32_t produced = __atomic_exchange_n(&readyCount, 0, __ATOMIC_ACQ_REL);
+        uint8_t status;
+        if (bus->readRegisters(busDevice, MPU6050_INT_STATUS, &status, 1, I2C_PRIO_SENSOR) != I2C_OK) return;
+        readFifo(status, (intPin >= 0) ? produced : 0);
+    }
+
+    // Hardware event mode: no bus traffic while idle, drain while moving
+    void updateEvents() {
+        bool event = __atomic_exchange_n(&eventCount, 0, __ATOMIC_ACQ_REL) > 0;
+        if (!event && (!fifoActive || millis() - lastRead < ACCEL_POLL_MS)) return;
+        lastRead = millis();
+
+        // INT_STATUS also carries the FIFO overflow flag for the drain
+        uint8_t status;
+        if (bus->readRegisters(busDevice, MPU6050_INT_STATUS, &status, 1, I2C_PRIO_SENSOR) != I2C_OK) return;
+        if (status & MPU6050_INT_MOT) motionEvents++;
+        if (status & MPU6050_INT_FF) freefallEvents++;
+        if (event || (status & (MPU6050_INT_MOT | MPU6050_INT_FF))) lastMotion = millis();
+        uint32_t eventAge = millis() - lastEventMs;
+
+        if (fifoActive) {
+            readFifo(status, 0);
+        } else if (event) {
+            startFifo(); // Samples from here on; the free-fall itself was seen by the sensor
+        }
+
+        // Free-fall evidence, timed from the interrupt on the sample clock
+        if (status & MPU6050_INT_FF) fall.addFreefallHint(sampleClockMs() - eventAge);
+
+        if (fifoActive && !fall.isBusy() && millis() - lastMotion >= ACCEL_IDLE_MS) stopFifo();
+    }
 
-        // Calculate Magnitude (Total G-Force)
-        float magnitude = sqrt(pow(ax, 2) + pow(ay, 2) + pow(az, 2));
+    void processBatch() {
+        block.count = 0;
+        if (batchCount == 0) return;
+        kernel.process(batchX, batchY, batchZ, batchCount, block);
 
         // ===========================
         // 1. STEP COUNTING LOGIC
         // ===========================
-        // Check if we crossed the threshold from low to high (a "step")
-        if (magnitude > stepThreshold && magnitudePrev <= stepThreshold) {
+        // Samples that crossed the threshold from low to high (a "step")
+        uint64_t above = block.aboveStep;
+        uint64_t rising = above & ~((above << 1) | (abovePrev ? 1 : 0));
+        abovePrev = (above >> (batchCount - 1)) & 1;
+        while (rising) {
+            const AccelSample &s = batch[__builtin_ctzll(rising)];
+            rising &= rising - 1;
             // Check if enough time has passed since the last step
-            if (millis() - lastStepTime > stepDelay) {
+            if (s.timeMs - lastStepTime > (unsigned long)stepDelay) {
                 steps++;
-                lastStepTime = millis();
+                lastStepTime = s.timeMs;
             }
         }
 
         // ===========================
-        // 2. FALL DETECTION LOGIC
+        // 2. FALL DETECTION
         // ===========================
-        
-        // A. Detect Freefall
-        if (magnitude < fallLowThreshold && fallState == 0) {
-            fallState = 1;
-            freefallStartTime = millis();
+        fall.addBlock(batch, block);
+    }
+
+  public:
+    // interruptPin: GPIO wired to the MPU6050 INT pin (-1 = poll the FIFO)
+    // motionEvents: use the hardware free-fall / motion interrupts (needs the pin)
+    void begin(I2CBus &i2c, int interruptPin = -1, bool motionEvents = false) {
+        bus = &i2c;
+        busDevice = bus->addDevice(MPU6050_ADDR, MPU6050_I2C_CLOCK, "mpu6050");
+        intPin = interruptPin;
+        hwEvents = motionEvents && intPin >= 0;
+        kernel.begin(stepThreshold, fallLowThreshold, fallHighThreshold);
+        fall.begin();
+
+        bus->writeRegister(busDevice, MPU6050_PWR_MGMT_1, MPU6050_CLOCK_PLL_X); // Wake up
+        bus->writeRegister(busDevice, MPU6050_CONFIG, MPU6050_DLPF_44HZ);
+        bus->writeRegister(busDevice, MPU6050_SMPLRT_DIV, 1000 / ACCEL_ODR_HZ - 1);
+        bus->writeRegister(busDevice, MPU6050_FIFO_EN, MPU6050_FIFO_ACCEL);
+        bus->writeRegister(busDevice, MPU6050_INT_PIN_CFG, 0x00);   // Active high, 50 us pulse
+        if (hwEvents) {
+            bus->writeRegister(busDevice, MPU6050_ACCEL_CONFIG, MPU6050_ACCEL_HPF_5HZ); // +-2 g
+            bus->writeRegister(busDevice, MPU6050_FF_THR, ACCEL_FF_THRESHOLD);
+            bus->writeRegister(busDevice, MPU6050_FF_DUR, ACCEL_FF_DURATION);
+            bus->writeRegister(busDevice, MPU6050_MOT_THR, ACCEL_MOT_THRESHOLD);
+            bus->writeRegister(busDevice, MPU6050_MOT_DUR, ACCEL_MOT_DURATION);
+            bus->writeRegister(busDevice, MPU6050_INT_ENABLE,
+                               MPU6050_INT_FF | MPU6050_INT_MOT | MPU6050_INT_FIFO_OFLOW);
+        } else {
+            bus->writeRegister(busDevice, MPU6050_ACCEL_CONFIG, 0x00);  // +-2 g
+            bus->writeRegister(busDevice, MPU6050_INT_ENABLE, MPU6050_INT_DATA_RDY | MPU6050_INT_FIFO_OFLOW);
         }
+        resetFifo();
 
-        // B. Detect Impact
-        if (fallState == 1) {
-            if (magnitude > fallHighThreshold) {
-                fallDetected = true; 
-                fallState = 0;       
-            }
-            
-            // Timeout (Reset if impact doesn't happen quickly)
-            if (millis() - freefallStartTime > 200) {
-                fallState = 0;
-            }
+        sampleIndex = (uint32_t)((uint64_t)millis() * ACCEL_ODR_HZ / 1000);
+        readyCount = 0;
+        eventCount = 0;
+        fifoActive = true;
+        lastRead = millis();
+        lastMotion = millis();
+        if (intPin >= 0) {
+            pinMode(intPin, INPUT);
+            attachInterruptArg(digitalPinToInterrupt(intPin), onInterrupt, this, RISING);
         }
+    }
 
-        // Store current magnitude for the next loop's comparison
-        magnitudePrev = magnitude;
+    // Reads the FIFO when samples are due and runs step / fall detection
+    // over the batch
+    void update() {
+        batchCount = 0;
+        if (hwEvents) updateEvents();
+        else updateStream();
+
+        processBatch();
     }
 
     // --- GETTERS ---
 
     bool isFallDetected() {
-        return fallDetected;  // Just return the state, don't reset it
+        return fall.hasEvent();  // Just return the state, don't reset it
     }
 
     void clearFallDetected() {
-        fallDetected = false;  // Caller decides when to clear
+        fall.clearEvent();  // Caller decides when to clear
     }
 
+    // Confidence, timestamp and stage scores of the last scored candidate
+    const FallEvent &getFallEvent() { return fall.getLastEvent(); }
+
     // This is the method you asked for:
     int getSteps() {
         return steps;
     }
-    
+
     // Optional: Reset steps at midnight or via menu
     void resetSteps() {
         steps = 0;
     }
+
+    // Samples read by the last update() (valid until the next one)
+    uint8_t getBatch(const AccelSample *&samples) {
+        samples = batch;
+        return batchCount;
+    }
+
+    // Kernel output for the last batch (squared magnitudes, masks, energy)
+    const AccelBlock &getBlock() { return block; }
+    AccelKernel &getKernel() { return kernel; }
+
+    // --- ACQUISITION STATS ---
+    uint16_t getSampleRate() { return ACCEL_ODR_HZ; }
+    uint32_t getSampleCount() { return sampleIndex; }
+    uint32_t getOverflowCount() { return fifoOverflows; }
+    uint32_t getLostSamples() { return lostSamples; }
+
+    // --- EVENT STATS ---
+    bool isHardwareEvents() { return hwEvents; }
+    bool isIdle() { return !fifoActive; }
+    uint32_t getFreefallEvents() { return freefallEvents; }
+    uint32_t getMotionEvents() { return motionEvents; }
+    uint32_t getWakeups() { return wakeups; }
+    uint32_t getFallCandidates() { return fall.getCandidates(); }
+    uint32_t getFallsRejected() { return fall.getRejected(); }
 };
 
-#endif
\ No newline at end of file
+#endif
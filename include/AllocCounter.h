@@ -0,0 +1,71 @@
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+  AllocCounter
+  ------------
+  Counts every heap allocation made by the firmware (malloc / calloc /
+  realloc, which also covers `new` and Arduino String).
+  - Enabled by the [env:esp32-s3-alloccheck] build, which defines
+    ALLOC_COUNTER and links with --wrap for the malloc family
+  - In normal builds getAllocCount() always returns 0
+  - ignoreAllocsFrom() excludes one task (the cloud uploader, whose
+    client allocates per request) so it doesn't show up in loop counts
+  - Include from exactly one translation unit (main.cpp)
+*/
+
+#ifdef ALLOC_COUNTER
+
+static volatile uint32_t allocCount = 0;
+static TaskHandle_t allocIgnoredTask = nullptr;
+
+static inline void countAlloc() {
+    if (allocIgnoredTask == nullptr || xTaskGetCurrentTaskHandle() != allocIgnoredTask) {
+        __atomic_fetch_add(&allocCount, 1, __ATOMIC_RELAXED);
+    }
+}
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    countAlloc();
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    countAlloc();
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    countAlloc();
+    return __real_realloc(ptr, size);
+}
+}
+
+inline uint32_t getAllocCount() {
+    return allocCount;
+}
+
+inline void ignoreAllocsFrom(TaskHandle_t task) {
+    allocIgnoredTask = task;
+}
+
+#else
+
+inline uint32_t getAllocCount() {
+    return 0;
+}
+
+inline void ignoreAllocsFrom(TaskHandle_t) {}
+
+#endif
+
+#endif
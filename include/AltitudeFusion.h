@@ -0,0 +1,182 @@
+#ifndef ALTITUDEFUSION_H
+#define ALTITUDEFUSION_H
+
+#include <Arduino.h>
+#include <math.h>
+#include "AccelKernel.h"
+
+/*
+  AltitudeFusion
+  --------------
+  Baro-inertial altitude and an up / down floor counter.
+  - Vertical acceleration: each accelerometer sample projected on a
+    low-passed gravity vector (1 / 2^ALT_GRAVITY_SHIFT per sample), minus g.
+    The gravity norm and its inverse are computed once per block
+  - Third-order complementary filter at the accelerometer rate: altitude,
+    vertical speed and accelerometer bias are pulled towards the latest
+    BMP280 altitude with gains 3w, 3w^2, w^3 (w = ALT_FUSION_OMEGA), so
+    the accelerometer carries the fast part of a climb and the barometer
+    the slow part
+  - Floors are counted separately up and down: once the fused altitude is
+    ALT_FLOOR_HYST_M away from the floor reference, a floor is counted and
+    the reference moves one ALT_FLOOR_M. Otherwise the reference follows
+    the altitude at no more than ALT_DRIFT_MPS, which absorbs weather
+    pressure drift (well under 0.001 m/s) but not a staircase (~0.2 m/s)
+  - Without accelerometer data (MPU6050 idle) the barometer alone drives
+    the altitude, so an elevator ride still counts
+  - Cost per sample is measured in CPU cycles against ALT_FUSION_BUDGET_CYCLES
+*/
+
+#define ALT_FUSION_OMEGA 0.5f           // rad/s: baro / accel crossover (~2 s)
+#define ALT_GRAVITY_SHIFT 6             // Gravity low-pass: 0.64 s at 100 Hz
+#define ALT_FLOOR_M 3.0f
+#define ALT_FLOOR_HYST_M 2.4f           // Count a floor once 80% of it is covered
+#define ALT_DRIFT_MPS 0.01f             // Floor reference follow rate
+#define ALT_ACCEL_TIMEOUT_MS 500        // Barometer only after this long without samples
+#define ALT_BARO_ONLY_ALPHA 0.2f        // Per barometer reading, barometer-only mode
+#define ALT_FUSION_BUDGET_CYCLES 2000   // Per accelerometer sample
+#define ALT_G_MS2 9.80665f
+
+class AltitudeFusion {
+  private:
+    // Filter state
+    float height = 0;           // m
+    float speed = 0;            // m/s, up
+    float bias = 0;             // m/s^2, accelerometer correction
+    float baro = 0;             // Latest barometer altitude
+    bool baroValid = false;
+    int32_t gravity[3] = { 0, 0, 0 };   // Low-passed accel << ALT_GRAVITY_SHIFT
+    bool gravityValid = false;
+    uint32_t lastSampleMs = 0;      // Accelerometer sample clock
+    uint32_t lastBlockMs = 0;       // millis() when the last batch arrived
+    bool haveBlock = false;
+    uint32_t lastBaroMs = 0;
+
+    // Floors
+    float floorRef = 0;
+    uint16_t floorsUp = 0;
+    uint16_t floorsDown = 0;
+
+    // Cost
+    uint32_t samples = 0;
+    uint64_t cyclesTotal = 0;
+    uint32_t maxCyclesPerSample = 0;
+    uint32_t overruns = 0;
+
+    void stepFloors(float dt) {
+        float diff = height - floorRef;
+        if (diff >= ALT_FLOOR_HYST_M) {
+            floorsUp++;
+            floorRef += ALT_FLOOR_M;
+        } else if (diff <= -ALT_FLOOR_HYST_M) {
+            floorsDown++;
+            floorRef -= ALT_FLOOR_M;
+        } else {
+            float follow = ALT_DRIFT_MPS * dt;
+            floorRef += (diff > follow) ? follow : (diff < -follow) ? -follow : diff;
+        }
+    }
+
+  public:
+    void begin() {
+        baroValid = false;
+        gravityValid = false;
+        haveBlock = false;
+        speed = 0;
+        bias = 0;
+        floorsUp = 0;
+        floorsDown = 0;
+    }
+
+    // One BMP280 altitude reading (m), timeMs from millis()
+    void addBaro(float altitude, uint32_t timeMs) {
+        baro = altitude;
+        if (!baroValid) {
+            baroValid = true;
+            height = altitude;
+            floorRef = altitude;
+            lastBaroMs = timeMs;
+            return;
+        }
+        float dt = (timeMs - lastBaroMs) / 1000.0f;
+        lastBaroMs = timeMs;
+
+        // No accelerometer batch lately: the barometer alone, low-passed.
+        // Compared on millis(), not the accelerometer's sample clock, which
+        // drifts from it with the MPU6050 oscillator (a batch arriving
+        // between the two millis() reads makes the difference negative)
+        int32_t sinceBlock = (int32_t)(timeMs - lastBlockMs);
+        if (!haveBlock || sinceBlock > ALT_ACCEL_TIMEOUT_MS) {
+            height += (baro - height) * ALT_BARO_ONLY_ALPHA;
+            speed = 0;
+            stepFloors(dt);
+        }
+    }
+
+    // One accelerometer batch (raw, +-2 g) with its kernel output
+    void addBlock(const AccelSample *batch, const AccelBlock &block) {
+        if (block.count == 0) return;
+        uint32_t start = ESP.getCycleCount();
+        lastBlockMs = millis();
+        haveBlock = true;
+
+        // Gravity direction and norm: once per block
+        if (!gravityValid) {
+            gravity[0] = (int32_t)batch[0].x << ALT_GRAVITY_SHIFT;
+            gravity[1] = (int32_t)batch[0].y << ALT_GRAVITY_SHIFT;
+            gravity[2] = (int32_t)batch[0].z << ALT_GRAVITY_SHIFT;
+            gravityValid = true;
+            lastSampleMs = batch[0].timeMs;
+        }
+        float gx = (float)gravity[0], gy = (float)gravity[1], gz = (float)gravity[2];
+        float norm = sqrtf(gx * gx + gy * gy + gz * gz);
+        float inv = (norm > 0) ? 1.0f / norm : 0;
+        float gLsb = norm / (1 << ALT_GRAVITY_SHIFT);
+        float scale = ALT_G_MS2 / 16384.0f;
+        const float k1 = 3 * ALT_FUSION_OMEGA;
+        const float k2 = 3 * ALT_FUSION_OMEGA * ALT_FUSION_OMEGA;
+        const float k3 = ALT_FUSION_OMEGA * ALT_FUSION_OMEGA * ALT_FUSION_OMEGA;
+
+        for (uint8_t i = 0; i < block.count; i++) {
+            const AccelSample &s = batch[i];
+            gravity[0] += s.x - (gravity[0] >> ALT_GRAVITY_SHIFT);
+            gravity[1] += s.y - (gravity[1] >> ALT_GRAVITY_SHIFT);
+            gravity[2] += s.z - (gravity[2] >> ALT_GRAVITY_SHIFT);
+
+            uint32_t gap = s.timeMs - lastSampleMs;
+            lastSampleMs = s.timeMs;
+            if (!baroValid) continue;
+            if (gap > ALT_ACCEL_TIMEOUT_MS) {
+                speed = 0;   // Back from idle: restart the integration
+                continue;
+            }
+            float dt = gap / 1000.0f;
+
+            float up = ((s.x * gx + s.y * gy + s.z * gz) * inv - gLsb) * scale;
+            float err = baro - height;
+            bias += k3 * err * dt;
+            height += (speed + k1 * err) * dt;
+            speed += (up + bias + k2 * err) * dt;
+            stepFloors(dt);
+        }
+
+        uint32_t cycles = ESP.getCycleCount() - start;
+        uint32_t perSample = cycles / block.count;
+        samples += block.count;
+        cyclesTotal += cycles;
+        if (perSample > maxCyclesPerSample) maxCyclesPerSample = perSample;
+        if (perSample > ALT_FUSION_BUDGET_CYCLES) overruns++;
+    }
+
+    // --- GETTERS ---
+    float getAltitude() { return height; }
+    float getVerticalSpeed() { return speed; }
+    uint16_t getFloorsUp() { return floorsUp; }
+    uint16_t getFloorsDown() { return floorsDown; }
+    uint32_t getSamples() { return samples; }
+    uint32_t getCyclesPerSample() { return samples ? (uint32_t)(cyclesTotal / samples) : 0; }
+    uint32_t getMaxCyclesPerSample() { return maxCyclesPerSample; }
+    uint32_t getBudgetOverruns() { return overruns; }
+};
+
+#endif
@@ -10,16 +10,109 @@
 #include "WeatherManager.h"
 #include "ECGManager.h"
 #include "ActivityManager.h"
+#include "ActivityClassifier.h"
 #include "HartRate.h"
 #include "Vibrate.h"
+#include "FrameGovernor.h"
+#include "SpriteCache.h"
+#include "I2CBus.h"
+
+// --- PARTIAL FLUSH ---
+#define OLED_ADDR 0x3C
+#define OLED_WIDTH 128
+#define OLED_PAGES 8              // 8-pixel rows
+#define OLED_COLUMN_OFFSET 2      // SH1106 RAM is 132 wide, panel starts at column 2
+#define OLED_I2C_CLOCK 400000
+#define OLED_DATA_CHUNK (I2C_BUFFER_LENGTH - 1) // Bytes per transaction after the 0x40 control byte
+#define OLED_PAGE_TRANSACTIONS 3  // Addressing + up to two data chunks
+#define OLED_BUFFER_BYTES (OLED_WIDTH * OLED_PAGES)
+
+// --- FLUSH TASK ---
+#define DISPLAY_TASK_CORE 0       // Loop runs on core 1
+#define DISPLAY_TASK_PRIORITY 1   // Below the ECG acquisition task
+#define DISPLAY_FRAME_FRESH 0x80  // Set on the ready slot until the task takes it
+
+// --- SPRITES ---
+#define BIG_GLYPH_CHARS "0123456789:-. APMC" // Size-2 characters drawn from the cache
+#define BIG_GLYPH_COUNT (sizeof(BIG_GLYPH_CHARS) - 1)
+#define BIG_GLYPH_WIDTH 12                  // 6x8 font cell at size 2
+#define BIG_GLYPH_HEIGHT 16
+#define SPRITE_ANCHOR_X 40                  // Where icons are drawn for capture
+#define SPRITE_ANCHOR_Y 16
+
+enum DisplayScreen {
+    SCREEN_START,
+    SCREEN_HEART,
+    SCREEN_WEATHER,
+    SCREEN_ECG,
+    SCREEN_STEPS,
+    SCREEN_ALERT,   // SOS / fall / heart alert animations
+    SCREEN_OTHER,   // clear() + update(), power off
+    SCREEN_COUNT
+};
+
+// Render and flush cost of one screen
+struct ScreenStats {
+    uint32_t frames = 0;
+    uint32_t emptyFrames = 0;       // Frames with nothing to send
+    uint32_t lastRenderMicros = 0;  // Drawing into the framebuffer
+    uint32_t lastFlushMicros = 0;   // Sending the changed pages
+    uint16_t lastFlushBytes = 0;    // Pixel bytes sent (commands excluded)
+    uint32_t totalFlushBytes = 0;
+    uint32_t droppedFrames = 0;     // Replaced by a newer frame before the flush task took them
+};
 
 class DisplayManager {
 private:
     Adafruit_SH1106G display;
+    I2CBus *bus = nullptr;
+    uint8_t busDevice = 0;
+
+    // Copy of what the panel currently shows (same page layout as the buffer)
+    uint8_t shadow[OLED_BUFFER_BYTES];
+    bool shadowValid = false;       // false = next flush resends everything
+    ScreenStats stats[SCREEN_COUNT];
+
+    // Flush task handoff (triple buffer): the loop renders into the
+    // Adafruit buffer, copies it into 'backFrame' and swaps that with the
+    // ready slot; the task swaps the ready slot with 'frontFrame' and flushes
+    // it. Neither side waits, and a frame not yet taken is simply replaced.
+    // Inversion travels with its frame: the task applies it right before
+    // sending that frame, so it never shows on the frame still queued.
+    bool useFlushTask = false;
+    TaskHandle_t flushTask = nullptr;
+    uint8_t frames[3][OLED_BUFFER_BYTES];
+    uint8_t frameScreen[3];
+    bool frameInverted[3] = { false, false, false };
+    bool inverted = false;          // Requested by the loop for the next frame
+    bool panelInverted = false;     // What the panel shows (flush task side)
+    uint8_t backFrame = 0;          // Owned by the loop
+    uint8_t frontFrame = 1;         // Owned by the flush task
+    uint8_t readyFrame = 2;         // Shared: index | DISPLAY_FRAME_FRESH
+
+    // Redraw only when a screen's input model changes (capped per screen)
+    FrameGovernor governor;
     
     // ECG Graph State Variables
+    // The trace sweeps left to right; each column is the mean of
+    // ECG_SAMPLES_PER_COLUMN samples read straight from the ECG ring.
+    static const int ECG_SAMPLES_PER_COLUMN = 8;
+    uint8_t ecgTrace[128];
     int ecgX = 0;
-    int ecgLastY = 32;
+    uint32_t ecgSeq = 0;
+    int32_t ecgColumnSum = 0;
+    int ecgColumnCount = 0;
+
+    // Icons and size-2 glyphs, rasterized once in begin()
+    SpriteCache sprites;
+    enum Icon { ICON_PHONE, ICON_HEART, ICON_ALERT_HEART, ICON_WARNING, ICON_SHOE, ICON_COUNT };
+    Sprite icons[ICON_COUNT];
+    Sprite bigGlyphs[BIG_GLYPH_COUNT];
+    bool useSprites = true;   // false = draw with the primitives (reference output)
+
+    // Benchmark support: render into the framebuffer without flushing
+    bool renderOnly = false;
+    friend class RenderBenchmark;
 
     // --- HELPER: Draw Phone Icon ---
     void drawPhoneHandset(int x, int y) {
@@ -52,33 +145,281 @@ private:
         display.drawLine(x + 6, y + 3, x + 10, y + 3, SH110X_BLACK);
     }
 
+    // --- HELPER: Draw Heart Alert Icon ---
+    void drawAlertHeart(int x, int y) {
+        display.fillCircle(x, y, 5, SH110X_WHITE);
+        display.fillCircle(x + 10, y, 5, SH110X_WHITE);
+        display.fillTriangle(x - 5, y, x + 15, y, x + 5, y + 15, SH110X_WHITE);
+    }
+
+    // --- SPRITE CACHE ---
+    void drawIconPrimitive(Icon icon, int x, int y) {
+        switch (icon) {
+        case ICON_PHONE:       drawPhoneHandset(x, y); break;
+        case ICON_HEART:       drawHeart(x, y, 10); break;
+        case ICON_ALERT_HEART: drawAlertHeart(x, y); break;
+        case ICON_WARNING:     drawWarningIcon(x, y); break;
+        case ICON_SHOE:        drawShoeIcon(x, y); break;
+        default: break;
+        }
+    }
+
+    void buildSprites() {
+        sprites.clear();
+
+        // Draw each icon with its primitives and keep the pixels
+        for (uint8_t i = 0; i < ICON_COUNT; i++) {
+            display.clearDisplay();
+            drawIconPrimitive((Icon)i, SPRITE_ANCHOR_X, SPRITE_ANCHOR_Y);
+            if (!sprites.capture(display.getBuffer(), SPRITE_ANCHOR_X, SPRITE_ANCHOR_Y, icons[i]))
+                Serial.println("⚠️ Sprite pool full");
+        }
+
+        // Glyphs keep their full cell so the advance stays BIG_GLYPH_WIDTH
+        display.clearDisplay();
+        for (uint8_t i = 0; i < BIG_GLYPH_COUNT; i++) {
+            int16_t x = (i % 10) * BIG_GLYPH_WIDTH;
+            int16_t y = (i / 10) * BIG_GLYPH_HEIGHT;
+            display.drawChar(x, y, BIG_GLYPH_CHARS[i], SH110X_WHITE, SH110X_WHITE, 2);
+            sprites.captureBox(display.getBuffer(), x, y, BIG_GLYPH_WIDTH, BIG_GLYPH_HEIGHT, x, y, bigGlyphs[i]);
+        }
+        display.clearDisplay();
+    }
+
+    void drawIcon(Icon icon, int16_t x, int16_t y) {
+        if (useSprites) sprites.blit(display.getBuffer(), icons[icon], x, y);
+        else drawIconPrimitive(icon, x, y);
+    }
+
+    // Size-2 text from the glyph cache (other characters use the font).
+    // Returns the x position after the text.
+    int16_t drawBigText(int16_t x, int16_t y, const char *text) {
+        for (; *text; text++, x += BIG_GLYPH_WIDTH) {
+            const char *slot = useSprites ? strchr(BIG_GLYPH_CHARS, *text) : nullptr;
+            if (slot) sprites.blit(display.getBuffer(), bigGlyphs[slot - BIG_GLYPH_CHARS], x, y);
+            else display.drawChar(x, y, *text, SH110X_WHITE, SH110X_WHITE, 2);
+        }
+        return x;
+    }
+
+    int16_t drawBigNumber(int16_t x, int16_t y, int value) {
+        char text[12];
+        snprintf(text, sizeof(text), "%d", value);
+        return drawBigText(x, y, text);
+    }
+
+    // --- PARTIAL FLUSH ---
+    // Send columns [first, last] of one page: the addressing commands and
+    // the data are queued together at display priority, then waited for
+    // once. Sensor reads queued meanwhile run between pages.
+    bool sendPage(uint8_t page, uint8_t first, uint8_t last, const uint8_t *row) {
+        uint8_t column = first + OLED_COLUMN_OFFSET;
+        uint8_t cmds[3] = {
+            (uint8_t)(0xB0 | page),            // Page address
+            (uint8_t)(0x10 | (column >> 4)),   // Column high nibble
+            (uint8_t)(column & 0x0F)           // Column low nibble
+        };
+
+        I2CTransaction t[OLED_PAGE_TRANSACTIONS];
+        uint8_t count = 0;
+        t[count].device = busDevice;
+        t[count].hasReg = true;
+        t[count].reg = 0x00;                   // Command stream
+        t[count].tx = cmds;
+        t[count].txLen = sizeof(cmds);
+        count++;
+
+        for (uint16_t x = first; x <= last && count < OLED_PAGE_TRANSACTIONS; x += OLED_DATA_CHUNK) {
+            uint16_t length = last + 1 - x;
+            if (length > OLED_DATA_CHUNK) length = OLED_DATA_CHUNK;
+            t[count].device = busDevice;
+            t[count].hasReg = true;
+            t[count].reg = 0x40;               // Data stream
+            t[count].tx = &row[x];
+            t[count].txLen = length;
+            count++;
+        }
+
+        uint8_t queued = 0;
+        while (queued < count && bus->submit(t[queued], I2C_PRIO_DISPLAY)) queued++;
+        bool ok = queued == count;
+        for (uint8_t i = 0; i < queued; i++) {
+            if (bus->wait(t[i]) != I2C_OK) ok = false;
+        }
+        return ok;
+    }
+
+    // Panel commands that go through the Adafruit driver
+    void applyInverted(bool invert) {
+        I2CBusLock guard(*bus, busDevice);
+        display.invertDisplay(invert);
+    }
+
+    // With the flush task the next finished frame carries it
+    void setInverted(bool invert) {
+        inverted = invert;
+        if (!useFlushTask) applyInverted(invert);
+    }
+
+    // Send only the changed column range of each changed page.
+    // Returns the pixel bytes sent (0 = the panel was already up to date).
+    uint16_t flush(const uint8_t *buffer) {
+        uint16_t sent = 0;
+
+        for (uint8_t page = 0; page < OLED_PAGES; page++) {
+            const uint8_t *row = &buffer[page * OLED_WIDTH];
+            uint8_t *shadowRow = &shadow[page * OLED_WIDTH];
+
+            int first = 0;
+            int last = OLED_WIDTH - 1;
+            if (shadowValid) {
+                while (first < OLED_WIDTH && row[first] == shadowRow[first]) first++;
+                if (first == OLED_WIDTH) continue; // Page unchanged
+                while (row[last] == shadowRow[last]) last--;
+            }
+
+            if (!sendPage(page, first, last, row)) {
+                shadowValid = false; // Unknown panel state: resend all next time
+                return sent;
+            }
+            memcpy(&shadowRow[first], &row[first], last + 1 - first);
+            sent += last + 1 - first;
+        }
+        shadowValid = true;
+        return sent;
+    }
+
+    void recordFlush(uint8_t screen, unsigned long flushStart, uint16_t bytes) {
+        ScreenStats &s = stats[screen];
+        if (bytes == 0) s.emptyFrames++;
+        s.lastFlushMicros = micros() - flushStart;
+        s.lastFlushBytes = bytes;
+        s.totalFlushBytes += bytes;
+    }
+
+    // End of a frame: flush it (or hand it to the flush task) and record what it cost
+    void finishFrame(DisplayScreen screen, unsigned long renderStart) {
+        unsigned long flushStart = micros();
+        ScreenStats &s = stats[screen];
+        s.frames++;
+        s.lastRenderMicros = flushStart - renderStart;
+
+        if (renderOnly) return;
+        if (!useFlushTask) {
+            recordFlush(screen, flushStart, flush(display.getBuffer()));
+            return;
+        }
+
+        memcpy(frames[backFrame], display.getBuffer(), OLED_BUFFER_BYTES);
+        frameScreen[backFrame] = screen;
+        frameInverted[backFrame] = inverted;
+        uint8_t previous = __atomic_exchange_n(&readyFrame, (uint8_t)(backFrame | DISPLAY_FRAME_FRESH), __ATOMIC_ACQ_REL);
+        if (previous & DISPLAY_FRAME_FRESH) stats[frameScreen[previous & 0x03]].droppedFrames++;
+        backFrame = previous & 0x03;
+        xTaskNotifyGive(flushTask);
+    }
+
+    // Flush task: always shows the newest completed frame.
+    // I2C: pages go through the bus manager like every other transfer.
+    static void flushTaskEntry(void *arg) {
+        DisplayManager *self = (DisplayManager *)arg;
+        for (;;) {
+            // Bus completions share this task's notification, so the ready
+            // slot itself is checked rather than trusting each wake-up
+            if (!(__atomic_load_n(&self->readyFrame, __ATOMIC_ACQUIRE) & DISPLAY_FRAME_FRESH)) {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+                continue;
+            }
+
+            uint8_t taken = __atomic_exchange_n(&self->readyFrame, self->frontFrame, __ATOMIC_ACQ_REL);
+            self->frontFrame = taken & 0x03;
+
+            bool invert = self->frameInverted[self->frontFrame];
+            if (invert != self->panelInverted) {
+                self->applyInverted(invert);
+                self->panelInverted = invert;
+            }
+
+            unsigned long flushStart = micros();
+            uint16_t bytes = self->flush(self->frames[self->frontFrame]);
+            self->recordFlush(self->frameScreen[self->frontFrame], flushStart, bytes);
+        }
+    }
+
 public:
     // Constructor initializes the SH1106G object
-    DisplayManager() : display(128, 64, &Wire, -1) {}
+    DisplayManager() : display(128, 64, &Wire, -1) {
+        memset(ecgTrace, 32, sizeof(ecgTrace));
+    }
+
+    // useTask: flush frames from a task on the other core instead of the loop
+    void begin(I2CBus &i2c, bool useTask = false) {
+        bus = &i2c;
+        busDevice = bus->addDevice(OLED_ADDR, OLED_I2C_CLOCK, "sh1106");
 
-    void begin() {
         // Initialize OLED with I2C address 0x3C
-        if (!display.begin(0x3C, true)) {
-            Serial.println("❌ OLED NOT FOUND");
-            while (1);
+        {
+            I2CBusLock guard(*bus, busDevice);
+            if (!display.begin(OLED_ADDR, true)) {
+                Serial.println("❌ OLED NOT FOUND");
+                while (1);
+            }
         }
-        display.clearDisplay();
         display.setTextColor(SH110X_WHITE);
-        display.display();
+        buildSprites(); // Uses the framebuffer as scratch, leaves it clear
+        {
+            I2CBusLock guard(*bus, busDevice);
+            display.display();
+        }
+        memcpy(shadow, display.getBuffer(), sizeof(shadow));
+        shadowValid = true;
+
+        // Maximum redraw rate per screen (only reached while its model changes)
+        governor.setMaxFps(SCREEN_START, 2);
+        governor.setMaxFps(SCREEN_HEART, 10);
+        governor.setMaxFps(SCREEN_WEATHER, 2);
+        governor.setMaxFps(SCREEN_ECG, 25);
+        governor.setMaxFps(SCREEN_STEPS, 5);
+
+        if (useTask) {
+            useFlushTask = xTaskCreatePinnedToCore(flushTaskEntry, "oled_flush", 3072, this,
+                                                   DISPLAY_TASK_PRIORITY, &flushTask,
+                                                   DISPLAY_TASK_CORE) == pdPASS;
+            if (!useFlushTask) Serial.println("⚠️ OLED flush task failed, flushing from loop");
+        }
     }
 
     void clear() {
         display.clearDisplay();
+        governor.invalidate(); // Whatever is shown next must be redrawn
     }
 
     void update() {
-        display.display();
+        finishFrame(SCREEN_OTHER, micros());
+    }
+
+    bool isFlushTaskActive() { return useFlushTask; }
+
+    // Render / flush cost of one screen
+    const ScreenStats &getScreenStats(DisplayScreen screen) {
+        return stats[screen];
+    }
+
+    // Redraws done / avoided per screen
+    FrameGovernor &getGovernor() {
+        return governor;
     }
 
     // ============================================
     // SCREEN 0: START / CLOCK
     // ============================================
-    void showStartScreen(String date, String time) {
+    void showStartScreen(const char *date, const char *time) {
+        uint32_t model = FrameGovernor::start();
+        model = FrameGovernor::mix(model, date);
+        model = FrameGovernor::mix(model, time);
+        if (!governor.shouldDraw(SCREEN_START, model)) return;
+
+        unsigned long renderStart = micros();
         display.clearDisplay();
         
         // Date Header
@@ -88,15 +429,11 @@ public:
         display.drawLine(0, 10, 128, 10, SH110X_WHITE);
 
         // Centered Time
-        display.setTextSize(2);
-        int16_t x1, y1;
-        uint16_t w, h;
-        display.getTextBounds(time, 0, 0, &x1, &y1, &w, &h);
+        int w = strlen(time) * BIG_GLYPH_WIDTH;
+        int h = BIG_GLYPH_HEIGHT;
         int centerX = (128 - w) / 2;
         int centerY = (64 - h) / 2;
-        
-        display.setCursor(centerX, centerY);
-        display.print(time);
+        drawBigText(centerX, centerY, time);
 
         // Footer
         display.setTextSize(1);
@@ -104,13 +441,21 @@ public:
         display.println("  PRESS BUTTON");
         display.println("   TO CONTINUE");
         
-        display.display();
+        finishFrame(SCREEN_START, renderStart);
     }
 
     // ============================================
     // SCREEN 1: HEART RATE MONITOR
     // ============================================
-    void showHeartRateScreen(HeartData data) {
+    void showHeartRateScreen(const HeartData &data) {
+        uint32_t model = FrameGovernor::start();
+        model = FrameGovernor::mix(model, (int32_t)data.fingerPresent);
+        model = FrameGovernor::mix(model, (int32_t)data.currentBpm);
+        model = FrameGovernor::mix(model, (int32_t)data.avgBpm);
+        model = FrameGovernor::mix(model, (int32_t)data.spo2);
+        if (!governor.shouldDraw(SCREEN_HEART, model)) return;
+
+        unsigned long renderStart = micros();
         display.clearDisplay();
         
         // Header
@@ -122,7 +467,7 @@ public:
         // Status
         display.setCursor(0, 14);
         display.print(">> ");
-        display.print(data.irValue > 50000 ? "Sensing..." : "Place Finger");
+        display.print(data.fingerPresent ? "Sensing..." : "Place Finger");
 
         // BPM
         display.setCursor(0, 24);
@@ -134,22 +479,42 @@ public:
         display.print("AVG: ");
         display.print((int)data.avgBpm);
 
+        // Oxygen Saturation
+        display.setCursor(0, 44);
+        display.print("SpO2: ");
+        if (data.spo2 > 0) {
+            display.print(data.spo2);
+            display.print("%");
+        } else {
+            display.print("--");
+        }
+
         // Visual
-        drawHeart(100, 30, 10);
-        display.display();
+        drawIcon(ICON_HEART, 100, 30);
+        finishFrame(SCREEN_HEART, renderStart);
     }
 
     // ============================================
     // SCREEN 2: WEATHER
     // ============================================
     void showWeatherScreen(WeatherManager &weather) {
+        uint32_t model = FrameGovernor::start();
+        model = FrameGovernor::mix(model, (int32_t)weather.isConnected());
+        model = FrameGovernor::mix(model, (int32_t)weather.peekTemperature());
+        model = FrameGovernor::mix(model, weather.getForecast());
+        model = FrameGovernor::mix(model, (int32_t)weather.peekPressure());
+        model = FrameGovernor::mix(model, (int32_t)weather.getFloorsClimbed());
+        model = FrameGovernor::mix(model, (int32_t)weather.getFloorsDescended());
+        if (!governor.shouldDraw(SCREEN_WEATHER, model)) return;
+
+        unsigned long renderStart = micros();
         display.clearDisplay();
 
         if (!weather.isConnected()) {
             display.setTextSize(1);
             display.setCursor(20, 25);
             display.print("SENSOR ERROR");
-            display.display();
+            finishFrame(SCREEN_WEATHER, renderStart);
             return;
         }
 
@@ -160,13 +525,11 @@ public:
         display.drawLine(0, 10, 128, 10, SH110X_WHITE);
 
         // Temp
-        display.setTextSize(2);
-        display.setCursor(0, 18);
-        display.print((int)weather.getTemperature());
+        int tempEnd = drawBigNumber(0, 18, (int)weather.getTemperature());
         display.setTextSize(1);
-        display.print(" o"); 
-        display.setTextSize(2);
-        display.print("C");
+        display.setCursor(tempEnd, 18);
+        display.print(" o");
+        drawBigText(display.getCursorX(), 18, "C");
 
         // Forecast
         display.setTextSize(1);
@@ -180,31 +543,55 @@ public:
         display.setCursor(0, 48);
         display.print("Prs: "); display.print((int)weather.getPressure()); display.print("hPa");
         display.setCursor(75, 48);
-        display.print("FLR: "); display.print(weather.getFloorsClimbed());
+        display.print("FLR "); display.print(weather.getFloorsClimbed());
+        display.print("/"); display.print(weather.getFloorsDescended());
         
         display.drawFastVLine(70, 45, 15, SH110X_WHITE);
-        display.display();
+        finishFrame(SCREEN_WEATHER, renderStart);
     }
 
     // ============================================
     // SCREEN 3: ECG GRAPH
     // ============================================
     void showECGScreen(ECGManager &ecg) {
+        // The trace moves with every new column of samples
+        uint32_t model = FrameGovernor::start();
+        model = FrameGovernor::mix(model, (int32_t)ecg.isConnected());
+        model = FrameGovernor::mix(model, (int32_t)(ecg.getAcquisition().getWriteSeq() / ECG_SAMPLES_PER_COLUMN));
+        if (!governor.shouldDraw(SCREEN_ECG, model)) return;
+
+        unsigned long renderStart = micros();
         display.clearDisplay();
 
         if (!ecg.isConnected()) {
             display.setCursor(20, 30);
             display.print("ATTACH PADS...");
-            display.display();
+            finishFrame(SCREEN_ECG, renderStart);
             return;
         }
 
-        // Get Data
-        int raw = analogRead(36); 
-        // Note: In main code, pin 36 is implied. Ensure ECGManager handles this pin.
-        
-        bool isBeat = ecg.detectBeat(raw);
-        int yPos = ecg.getGraphValue(40); // Map to top 40 pixels
+        // Get Data: every sample since the last frame (no ADC reads here)
+        const ECGAcquisition &acq = ecg.getAcquisition();
+        if (ecgSeq < acq.getSafeSeq()) ecgSeq = acq.getSafeSeq();
+
+        const int16_t *values;
+        const uint8_t *flags;
+        uint16_t count;
+        while ((count = acq.view(ecgSeq, values, flags)) > 0) {
+            for (uint16_t i = 0; i < count; i++) {
+                ecgColumnSum += values[i];
+                if (++ecgColumnCount < ECG_SAMPLES_PER_COLUMN) continue;
+
+                // Map to top 40 pixels
+                ecgTrace[ecgX] = ecg.getGraphValue(ecgColumnSum / ECG_SAMPLES_PER_COLUMN, 40);
+                ecgX = (ecgX + 1) % 128;
+                ecgColumnSum = 0;
+                ecgColumnCount = 0;
+            }
+            ecgSeq += count;
+        }
+
+        bool isBeat = ecg.consumeBeat();
 
         // Draw UI
         display.setTextSize(1);
@@ -213,49 +600,68 @@ public:
         display.drawFastHLine(0, 42, 128, SH110X_WHITE);
         display.setCursor(0, 48);
         display.print("Stress: "); display.println(ecg.getStressLevel());
-
-        // Draw Graph Line
-        if (ecgX > 0) {
-            display.drawLine(ecgX - 1, ecgLastY, ecgX, yPos, SH110X_WHITE);
+        const HRVMetrics &hrv = ecg.getHRV();
+        if (hrv.getCount() >= HRV_MIN_BEATS) {
+            display.setCursor(0, 56);
+            display.print("RMSSD "); display.print((int)hrv.getRMSSD());
+            display.setCursor(64, 56);
+            display.print("SDNN "); display.print((int)hrv.getSDNN());
         }
 
-        ecgLastY = yPos;
-        ecgX++;
-
-        if (ecgX >= 128) {
-            ecgX = 0;
-            display.clearDisplay();
+        // Draw Graph Line (gap after the newest column marks the sweep)
+        for (int x = 1; x < 128; x++) {
+            if (x == ecgX) continue;
+            display.drawLine(x - 1, ecgTrace[x - 1], x, ecgTrace[x], SH110X_WHITE);
         }
 
         if (isBeat) {
             display.fillCircle(120, 5, 4, SH110X_WHITE);
         }
-        display.display();
+        finishFrame(SCREEN_ECG, renderStart);
     }
 
     // ============================================
     // SCREEN 4: STEPS / PEDOMETER
     // ============================================
-    void showStepsScreen(ActivityManager &activity) {
-        display.clearDisplay();
+    void showStepsScreen(ActivityManager &activity, ActivityClassifier &classifier) {
         int steps = activity.getSteps();
+        float distanceKm = classifier.getDistanceKm();
+        int calories = classifier.getCalories();
+        ActivityType type = classifier.getActivity();
+        uint16_t cadence = classifier.getCadence();
+
+        uint32_t model = FrameGovernor::mix(FrameGovernor::start(), (int32_t)steps);
+        model = FrameGovernor::mix(model, (int32_t)(distanceKm * 10));
+        model = FrameGovernor::mix(model, (int32_t)calories);
+        model = FrameGovernor::mix(model, (int32_t)type);
+        model = FrameGovernor::mix(model, (int32_t)cadence);
+        if (!governor.shouldDraw(SCREEN_STEPS, model)) return;
+
+        unsigned long renderStart = micros();
+        display.clearDisplay();
         int goal = 6000;
-        float distanceKm = steps * 0.000762;
-        int calories = steps * 0.04;
 
-        drawShoeIcon(10, 5);
+        drawIcon(ICON_SHOE, 10, 5);
         display.setTextSize(1);
         display.setCursor(38, 5);
-        display.print("PEDOMETER");
+        if (type == ACTIVITY_IDLE) {
+            display.print("PEDOMETER");
+        } else {
+            // Current activity and cadence (steps/min)
+            display.print(ActivityClassifier::getName(type));
+            if (cadence > 0) {
+                display.print(" ");
+                display.print(cadence);
+                display.print("/min");
+            }
+        }
         display.drawLine(0, 18, 128, 18, SH110X_WHITE);
 
         // Steps Count
-        display.setTextSize(2);
         int xOffset = (steps < 10) ? 55 : (steps < 100) ? 50 : (steps < 1000) ? 45 : 35;
-        display.setCursor(xOffset, 25);
-        display.print(steps);
+        int stepsEnd = drawBigNumber(xOffset, 25, steps);
         display.setTextSize(1);
-        display.setCursor(xOffset + (String(steps).length() * 12) + 2, 32);
+        display.setCursor(stepsEnd + 2, 32);
         display.print("stps");
 
         // Progress Bar
@@ -269,142 +675,245 @@ public:
         display.setCursor(70, 55);
         display.print("Cal: "); display.print(calories);
 
-        display.display();
+        finishFrame(SCREEN_STEPS, renderStart);
     }
 
     // ============================================
-    // ANIMATION: SOS EMERGENCY
+    // ANIMATIONS (non-blocking)
     // ============================================
-    void animateEmergencyCall(Vibrate &vibrate) {
-        int callDuration = 50; 
-        
-        for (int i = 0; i < callDuration; i++) {
-            display.clearDisplay();
-            int iconX = 52, iconY = 20;
-            drawPhoneHandset(iconX, iconY);
+    // start*() arms an animation; updateAnimation() draws at most one frame
+    // per call once the frame deadline has passed, so the loop keeps
+    // sampling sensors, reading buttons and uploading while it plays.
 
-            // Expanding waves
-            if (i % 10 > 2) display.drawCircle(iconX + 12, iconY + 4, 15, SH110X_WHITE);
-            if (i % 10 > 5) display.drawCircle(iconX + 12, iconY + 4, 22, SH110X_WHITE);
-            if (i % 10 > 8) display.drawCircle(iconX + 12, iconY + 4, 29, SH110X_WHITE);
+    void startEmergencyCall() {
+        startAnimation(ANIM_SOS, 0);
+    }
 
-            // Text
+    // cancelPin: button (active LOW) that cancels the countdown
+    void startFallAlert(int cancelPin) {
+        fallCancelPin = cancelPin;
+        startAnimation(ANIM_FALL, 0);
+    }
+
+    // A heart alert never interrupts an SOS or fall animation
+    void startHeartAlert(const char *status, float bpm, int level) {
+        if (animation == ANIM_SOS || animation == ANIM_FALL) return;
+        if (animation == ANIM_HEART) return; // Let the current one finish
+        alertStatus = status;
+        alertBpm = bpm;
+        alertLevel = level;
+        startAnimation(ANIM_HEART, 0);
+    }
+
+    bool isAnimating() { return animation != ANIM_NONE; }
+
+    // True once after the cancel button stopped a fall alert; the caller
+    // must not treat that press as its own (the cancel pin is a real button)
+    bool takeFallCancelPress() {
+        bool pressed = fallCancelPressed;
+        fallCancelPressed = false;
+        return pressed;
+    }
+
+    // Call every loop. Returns true while an animation owns the screen.
+    bool updateAnimation(Vibrate &vibrate) {
+        if (animation == ANIM_NONE) return false;
+
+        // The cancel button is checked every loop, not just every frame
+        if (animation == ANIM_FALL && animPhase == PHASE_RUN && digitalRead(fallCancelPin) == LOW) {
+            fallCancelPressed = true;
+            setInverted(false);
+            display.clearDisplay();
             display.setTextSize(1);
-            display.setCursor(35, 0);
-            display.print("EMERGENCY");
-            display.setTextSize(2);
-            display.setCursor(15, 45);
-            if (i % 8 < 5) display.print("DIALING..");
+            display.setCursor(25, 25);
+            display.print("CANCELLED");
+            finishFrame(SCREEN_ALERT, micros());
+            holdPhase(1000);
+            return true;
+        }
 
-            // Progress Bar
-            display.drawRect(14, 60, 100, 4, SH110X_WHITE); 
-            int progress = map(i, 0, callDuration, 0, 98);
-            display.fillRect(15, 61, progress, 2, SH110X_WHITE);
+        if ((long)(millis() - nextFrameTime) < 0) return true;
 
-            display.display();
-            vibrate.vibrateFor(100);
-            delay(100);
+        switch (animation) {
+        case ANIM_SOS:   stepEmergencyCall(vibrate); break;
+        case ANIM_FALL:  stepFallAlert(); break;
+        case ANIM_HEART: stepHeartAlert(vibrate); break;
+        default: break;
         }
+        return animation != ANIM_NONE;
+    }
+
+private:
+    enum Animation { ANIM_NONE, ANIM_SOS, ANIM_FALL, ANIM_HEART };
+    enum AnimPhase { PHASE_RUN, PHASE_HOLD };
+
+    static const int ANIM_FRAME_MS = 100;
+    static const int SOS_FRAMES = 50;
+    static const int FALL_FRAMES = 100;
+    static const int HEART_FRAMES = 30;
+
+    Animation animation = ANIM_NONE;
+    AnimPhase animPhase = PHASE_RUN;
+    int animFrame = 0;
+    unsigned long nextFrameTime = 0;
+    bool flashState = false;
+
+    int fallCancelPin = -1;
+    bool fallCancelPressed = false;
+    const char *alertStatus = "";
+    float alertBpm = 0;
+    int alertLevel = 0;
+
+    void startAnimation(Animation anim, int frame) {
+        animation = anim;
+        animPhase = PHASE_RUN;
+        animFrame = frame;
+        flashState = false;
+        nextFrameTime = millis();
+        setInverted(false);
+    }
 
+    // Show the current frame for 'ms', then end the animation
+    void holdPhase(unsigned long ms) {
+        animPhase = PHASE_HOLD;
+        nextFrameTime = millis() + ms;
+    }
+
+    void endAnimation() {
+        setInverted(false);
         display.clearDisplay();
-        display.setTextSize(2);
-        display.setCursor(10, 25);
-        display.print("CONNECTED");
-        display.display();
-        delay(2000);
+        governor.invalidate();
+        animation = ANIM_NONE;
     }
 
-    // ============================================
-    // ANIMATION: FALL DETECTION
-    // ============================================
-    void animateFallAlert(Vibrate &vibrate, int cancelPin) {
-        int countdown = 100;
-        bool flashState = false;
+    // Next frame deadline (fixed period, does not drift with a slow loop)
+    void nextFrame() {
+        animFrame++;
+        nextFrameTime += ANIM_FRAME_MS;
+        if ((long)(millis() - nextFrameTime) > ANIM_FRAME_MS) nextFrameTime = millis();
+    }
 
-        for (int i = 0; i < countdown; i++) {
-            display.clearDisplay();
-            drawWarningIcon(64, 5);
+    // --- SOS EMERGENCY ---
+    void stepEmergencyCall(Vibrate &vibrate) {
+        if (animPhase == PHASE_HOLD) {
+            endAnimation();
+            return;
+        }
 
+        if (animFrame >= SOS_FRAMES) {
+            display.clearDisplay();
             display.setTextSize(2);
-            display.setCursor(10, 45);
-            display.print("FALL DETECTED");
+            display.setCursor(10, 25);
+            display.print("CONNECTED");
+            finishFrame(SCREEN_ALERT, micros());
+            holdPhase(2000);
+            return;
+        }
 
-            int barWidth = map(i, 0, 100, 0, 128);
-            display.fillRect(0, 0, barWidth, 4, SH110X_WHITE);
+        unsigned long renderStart = micros();
+        int i = animFrame;
+        display.clearDisplay();
+        int iconX = 52, iconY = 20;
+        drawIcon(ICON_PHONE, iconX, iconY);
 
-            display.setTextSize(1);
-            display.setCursor(35, 30);
-            display.print("SENDING SOS...");
+        // Expanding waves
+        if (i % 10 > 2) display.drawCircle(iconX + 12, iconY + 4, 15, SH110X_WHITE);
+        if (i % 10 > 5) display.drawCircle(iconX + 12, iconY + 4, 22, SH110X_WHITE);
+        if (i % 10 > 8) display.drawCircle(iconX + 12, iconY + 4, 29, SH110X_WHITE);
 
-            if (i % 5 == 0) {
-                flashState = !flashState;
-                display.invertDisplay(flashState);
-            }
-            display.display();
+        // Text
+        display.setTextSize(1);
+        display.setCursor(35, 0);
+        display.print("EMERGENCY");
+        display.setTextSize(2);
+        display.setCursor(15, 45);
+        if (i % 8 < 5) display.print("DIALING..");
 
-            // Cancel check
-            if (digitalRead(cancelPin) == LOW) {
-                display.invertDisplay(false);
-                display.clearDisplay();
-                display.setCursor(25, 25);
-                display.print("CANCELLED");
-                display.display();
-                delay(1000);
-                return;
-            }
-            delay(100);
+        // Progress Bar
+        display.drawRect(14, 60, 100, 4, SH110X_WHITE);
+        int progress = map(i, 0, SOS_FRAMES, 0, 98);
+        display.fillRect(15, 61, progress, 2, SH110X_WHITE);
+
+        finishFrame(SCREEN_ALERT, renderStart);
+        vibrate.vibrateFor(100);
+        nextFrame();
+    }
+
+    // --- FALL DETECTION ---
+    void stepFallAlert() {
+        if (animPhase == PHASE_HOLD) {
+            endAnimation();
+            return;
         }
 
-        display.invertDisplay(false);
+        if (animFrame >= FALL_FRAMES) {
+            setInverted(false);
+            display.clearDisplay();
+            display.setTextSize(2);
+            display.setCursor(10, 20);
+            display.print("SOS SENT!");
+            finishFrame(SCREEN_ALERT, micros());
+            holdPhase(2000);
+            return;
+        }
+
+        unsigned long renderStart = micros();
+        int i = animFrame;
         display.clearDisplay();
+        drawIcon(ICON_WARNING, 64, 5);
+
         display.setTextSize(2);
-        display.setCursor(10, 20);
-        display.print("SOS SENT!");
-        display.display();
-        delay(2000);
+        display.setCursor(10, 45);
+        display.print("FALL DETECTED");
+
+        int barWidth = map(i, 0, FALL_FRAMES, 0, 128);
+        display.fillRect(0, 0, barWidth, 4, SH110X_WHITE);
+
+        display.setTextSize(1);
+        display.setCursor(35, 30);
+        display.print("SENDING SOS...");
+
+        if (i % 5 == 0) {
+            flashState = !flashState;
+            setInverted(flashState);
+        }
+        finishFrame(SCREEN_ALERT, renderStart);
+        nextFrame();
     }
-    
-    // ============================================
-    // ANIMATION: HEART ALERT
-    // ============================================
-    void showHeartAlert(String status, float bpm, int alertLevel, Vibrate &vibrate) {
-        int duration = 30;
-        bool flashState = false;
 
-        for (int i = 0; i < duration; i++) {
-            display.clearDisplay();
-            
-            // Icon
-            int x = 58; int y = 5;
-            display.fillCircle(x, y, 5, SH110X_WHITE);
-            display.fillCircle(x + 10, y, 5, SH110X_WHITE);
-            display.fillTriangle(x - 5, y, x + 15, y, x + 5, y + 15, SH110X_WHITE);
-
-            // Data
-            display.setTextSize(1);
-            display.setCursor(10, 25); 
-            display.print(status);
-            display.setTextSize(2);
-            display.setCursor(45, 40);
-            display.print((int)bpm);
-            display.setTextSize(1);
-            display.setCursor(85, 47);
-            display.print("BPM");
-
-            // Flashing for Critical (Level 2)
-            if (alertLevel == 2 && i % 5 == 0) {
-                flashState = !flashState;
-                display.invertDisplay(flashState);
-            } else if (alertLevel != 2) {
-                 display.invertDisplay(false);
-            }
+    // --- HEART ALERT ---
+    void stepHeartAlert(Vibrate &vibrate) {
+        if (animFrame >= HEART_FRAMES) {
+            endAnimation();
+            return;
+        }
 
-            display.display();
-            vibrate.vibrateFor(100);
-            delay(100);
+        unsigned long renderStart = micros();
+        int i = animFrame;
+        display.clearDisplay();
+
+        // Icon
+        drawIcon(ICON_ALERT_HEART, 58, 5);
+
+        // Data
+        display.setTextSize(1);
+        display.setCursor(10, 25);
+        display.print(alertStatus);
+        drawBigNumber(45, 40, (int)alertBpm);
+        display.setTextSize(1);
+        display.setCursor(85, 47);
+        display.print("BPM");
+
+        // Flashing for Critical (Level 2)
+        if (alertLevel == 2 && i % 5 == 0) {
+            flashState = !flashState;
+            setInverted(flashState);
         }
-        display.invertDisplay(false);
+
+        finishFrame(SCREEN_ALERT, renderStart);
+        vibrate.vibrateFor(100);
+        nextFrame();
     }
 };
 
-#endif
\ No newline at end of file
+#endif
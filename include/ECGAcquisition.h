@@ -0,0 +1,213 @@
+#ifndef ECGACQUISITION_H
+#define ECGACQUISITION_H
+
+#include <Arduino.h>
+#include <driver/adc.h>
+
+/*
+  ECGAcquisition
+  --------------
+  Fixed-rate ECG sampling that does not depend on the loop or the screen.
+  - ADC1 runs in continuous (DMA) mode at ECG_ADC_RATE_HZ; the ESP32-S3
+    cannot run the DMA slower than ~611 Hz, so blocks are box-averaged
+    down to the requested 250 or 500 Hz
+  - A small task drains the DMA pool into a ring of samples + lead-off flags
+  - Pins that are not on ADC1 fall back to a fixed-period analogRead task
+  - Readers keep their own sequence cursor and get contiguous views into
+    the ring (no copies); one writer, any number of readers
+  - The writer keeps going while a view is read. Readers start no closer
+    than ECG_READ_SLACK samples to the overwrite point (getSafeSeq()) and
+    check overwritten() after consuming a view; samples the writer
+    reached in the meantime are counted and discarded by the reader
+*/
+
+#define ECG_ADC_RATE_HZ 1000     // DMA conversion rate (decimated afterwards)
+#define ECG_RING_SIZE 1024       // Samples kept (power of two, ~2 s at 500 Hz)
+#define ECG_READ_SLACK 256       // Reader margin to the overwrite point (~0.5 s at 500 Hz)
+#define ECG_DMA_FRAME_BYTES 256  // Bytes per DMA read (64 conversions)
+#define ECG_DMA_POOL_BYTES 4096  // Driver pool (~1 s of conversions)
+
+// Per-sample flags
+#define ECG_FLAG_LEAD_OFF_P 0x01
+#define ECG_FLAG_LEAD_OFF_N 0x02
+
+class ECGAcquisition {
+  private:
+    int adcPin;
+    int loPlus;
+    int loMinus;
+    uint16_t sampleRate = 500;
+    uint8_t decimation = 2;
+    bool dmaMode = false;
+
+    // Ring storage (single writer: the acquisition task)
+    int16_t values[ECG_RING_SIZE];
+    uint8_t flags[ECG_RING_SIZE];
+    volatile uint32_t writeSeq = 0;
+
+    // Decimation accumulator
+    int32_t decimSum = 0;
+    uint8_t decimCount = 0;
+
+    // Stats
+    volatile uint32_t dmaOverruns = 0;
+
+    TaskHandle_t task = nullptr;
+
+    uint8_t readLeadFlags() {
+        uint8_t f = 0;
+        if (digitalRead(loPlus) == HIGH) f |= ECG_FLAG_LEAD_OFF_P;
+        if (digitalRead(loMinus) == HIGH) f |= ECG_FLAG_LEAD_OFF_N;
+        return f;
+    }
+
+    // Average 'decimation' raw conversions into one output sample
+    void pushRaw(int32_t raw, uint8_t leadFlags) {
+        decimSum += raw;
+        if (++decimCount < decimation) return;
+
+        uint32_t seq = writeSeq;
+        uint32_t slot = seq & (ECG_RING_SIZE - 1);
+        values[slot] = (int16_t)(decimSum / decimation);
+        flags[slot] = leadFlags;
+        __atomic_store_n(&writeSeq, seq + 1, __ATOMIC_RELEASE);
+
+        decimSum = 0;
+        decimCount = 0;
+    }
+
+    void runDma() {
+        uint8_t frame[ECG_DMA_FRAME_BYTES];
+        for (;;) {
+            uint32_t length = 0;
+            esp_err_t err = adc_digi_read_bytes(frame, sizeof(frame), &length, 100);
+            if (err == ESP_ERR_INVALID_STATE) {
+                dmaOverruns++; // Pool filled up before we drained it
+            }
+            if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) continue;
+
+            uint8_t leadFlags = readLeadFlags();
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+                adc_digi_output_data_t *out = (adc_digi_output_data_t *)&frame[i];
+                pushRaw(out->type2.data, leadFlags);
+            }
+        }
+    }
+
+    void runTimed() {
+        TickType_t period = pdMS_TO_TICKS(1000 / sampleRate);
+        if (period == 0) period = 1;
+        TickType_t wake = xTaskGetTickCount();
+        for (;;) {
+            vTaskDelayUntil(&wake, period);
+            decimCount = decimation - 1; // One read per output sample
+            pushRaw(analogRead(adcPin), readLeadFlags());
+        }
+    }
+
+    static void taskEntry(void *arg) {
+        ECGAcquisition *self = (ECGAcquisition *)arg;
+        if (self->dmaMode) self->runDma();
+        else self->runTimed();
+    }
+
+  public:
+    ECGAcquisition(int adc, int lp, int lm) : adcPin(adc), loPlus(lp), loMinus(lm) {}
+
+    // rate: output sample rate in Hz (250 or 500)
+    bool begin(uint16_t rate = 500) {
+        sampleRate = (rate == 250) ? 250 : 500;
+        decimation = ECG_ADC_RATE_HZ / sampleRate;
+
+        int8_t channel = digitalPinToAnalogChannel(adcPin);
+        dmaMode = (channel >= 0 && channel < SOC_ADC_CHANNEL_NUM(0));
+
+        if (dmaMode) {
+            adc_digi_init_config_t initConfig = {};
+            initConfig.max_store_buf_size = ECG_DMA_POOL_BYTES;
+            initConfig.conv_num_each_intr = ECG_DMA_FRAME_BYTES;
+            initConfig.adc1_chan_mask = BIT(channel);
+            initConfig.adc2_chan_mask = 0;
+
+            adc_digi_pattern_config_t pattern = {};
+            pattern.atten = ADC_ATTEN_DB_11;
+            pattern.channel = channel;
+            pattern.unit = 0; // ADC1
+            pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+            adc_digi_configuration_t digiConfig = {};
+            digiConfig.conv_limit_en = false;
+            digiConfig.conv_limit_num = 250;
+            digiConfig.pattern_num = 1;
+            digiConfig.adc_pattern = &pattern;
+            digiConfig.sample_freq_hz = ECG_ADC_RATE_HZ;
+            digiConfig.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+            digiConfig.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+
+            if (adc_digi_initialize(&initConfig) != ESP_OK ||
+                adc_digi_controller_configure(&digiConfig) != ESP_OK ||
+                adc_digi_start() != ESP_OK) {
+                dmaMode = false;
+            }
+        }
+
+        if (!dmaMode) {
+            Serial.println("⚠️ ECG pin not on ADC1, using timed sampling");
+        }
+
+        return xTaskCreatePinnedToCore(taskEntry, "ecg_acq", 3072, this, 5, &task, 0) == pdPASS;
+    }
+
+    // --- READER API ---
+
+    // Total samples written since begin() (monotonic sequence number)
+    uint32_t getWriteSeq() const {
+        return __atomic_load_n(&writeSeq, __ATOMIC_ACQUIRE);
+    }
+
+    // Oldest sequence number still held in the ring
+    uint32_t getOldestSeq() const {
+        uint32_t seq = getWriteSeq();
+        return (seq > ECG_RING_SIZE) ? seq - ECG_RING_SIZE : 0;
+    }
+
+    // Where a reader that fell behind resumes: ECG_READ_SLACK samples past
+    // the oldest, so the writer cannot reach a view while it is read
+    uint32_t getSafeSeq() const {
+        uint32_t seq = getWriteSeq();
+        return (seq > ECG_RING_SIZE - ECG_READ_SLACK) ? seq - (ECG_RING_SIZE - ECG_READ_SLACK) : 0;
+    }
+
+    // How many samples at the start of [fromSeq, fromSeq + count) the writer
+    // has reached (overwritten, or is overwriting) since they were viewed
+    uint16_t overwritten(uint32_t fromSeq, uint16_t count) const {
+        uint32_t seq = getWriteSeq(); // The writer fills this slot next
+        if (seq - fromSeq < ECG_RING_SIZE) return 0;
+        uint32_t reached = seq - ECG_RING_SIZE - fromSeq + 1;
+        return (reached >= count) ? count : (uint16_t)reached;
+    }
+
+    // Contiguous view starting at 'fromSeq' (stops at the ring wrap; call
+    // again for the rest). Returns the number of samples in the view.
+    uint16_t view(uint32_t fromSeq, const int16_t *&outValues, const uint8_t *&outFlags) const {
+        uint32_t end = getWriteSeq();
+        if (fromSeq >= end) return 0;
+        uint32_t slot = fromSeq & (ECG_RING_SIZE - 1);
+        uint32_t count = end - fromSeq;
+        if (count > ECG_RING_SIZE - slot) count = ECG_RING_SIZE - slot;
+        outValues = &values[slot];
+        outFlags = &flags[slot];
+        return (uint16_t)count;
+    }
+
+    int16_t latest() const {
+        uint32_t seq = getWriteSeq();
+        return seq ? values[(seq - 1) & (ECG_RING_SIZE - 1)] : 0;
+    }
+
+    uint16_t getSampleRate() const { return sampleRate; }
+    bool isDmaMode() const { return dmaMode; }
+    uint32_t getOverrunCount() const { return dmaOverruns; }
+};
+
+#endif
@@ -2,30 +2,115 @@
 #define ECGMANAGER_H
 
 #include <Arduino.h>
+#include "ECGAcquisition.h"
+#include "QRSDetector.h"
+#include "HRVMetrics.h"
+
+#define ECG_MAX_BEATS 8       // QRS complexes reported per processed view
+#define HRV_SHORT_BEATS 16    // Rhythm window
+#define HRV_LONG_BEATS 64     // Stress / HRV window (~1 min)
+#define HRV_MIN_BEATS 10      // Beats needed before classifying
+
+// Classification results with constant display text (no String allocation)
+enum StressLevel : uint8_t { STRESS_SENSING, STRESS_LOW, STRESS_MODERATE, STRESS_HIGH };
+enum RhythmStatus : uint8_t { RHYTHM_ANALYSING, RHYTHM_STABLE, RHYTHM_IRREGULAR };
+
+constexpr const char *STRESS_LEVEL_TEXT[] = { "Sensing...", "Low (Relaxed)", "Moderate", "High Stress" };
+constexpr const char *RHYTHM_STATUS_TEXT[] = { "Analysing...", "Stable", "Irregular" };
 
 class ECGManager {
   private:
     int outputPin;
     int loPlus;
     int loMinus;
+
+    // Continuous acquisition (shared by detector, display and recorder)
+    ECGAcquisition acquisition;
+    uint32_t readSeq = 0;        // Detector's cursor into the sample ring
+    uint32_t missedSamples = 0;  // Samples overwritten before (or while) the detector saw them
+    bool beatPending = false;    // Set on each beat, cleared by consumeBeat()
     
     // variables for heart beat detection
-    unsigned long lastPeakTime = 0;
-    int threshold = 2800; // Adjust this if detection is too sensitive
-    long currentInterval = 0;
+    QRSDetector detector;
+    QRSBeat beats[ECG_MAX_BEATS];
+    uint32_t lastBeatSeq = 0;
+    long currentInterval = 0; // Latest RR interval in ms
+
+    // Heart-rate variability
+    HRVMetrics hrvShort;
+    HRVMetrics hrvLong;
+
+    // Lead-off or unreliable samples: the detector learns from scratch
+    void restartDetection() {
+        detector.reset();
+        hrvShort.reset();
+        hrvLong.reset();
+        currentInterval = 0;
+    }
 
   public:
-    ECGManager(int output, int lp, int lm) {
+    ECGManager(int output, int lp, int lm) : acquisition(output, lp, lm) {
         outputPin = output;
         loPlus = lp;
         loMinus = lm;
     }
 
-    void begin() {
+    // rate: ECG sample rate in Hz (250 or 500)
+    void begin(uint16_t rate = 500) {
         pinMode(loPlus, INPUT);  // Pin 38
         pinMode(loMinus, INPUT); // Pin 37
+        acquisition.begin(rate);
+        detector.begin(acquisition.getSampleRate());
+        hrvShort.begin(HRV_SHORT_BEATS);
+        hrvLong.begin(HRV_LONG_BEATS);
+    }
+
+    // Call this in loop(): runs beat detection over every new sample
+    void update() {
+        const int16_t *values;
+        const uint8_t *flags;
+        for (;;) {
+            uint32_t safe = acquisition.getSafeSeq();
+            if (readSeq < safe) {
+                missedSamples += safe - readSeq;
+                readSeq = safe;
+            }
+            uint16_t count = acquisition.view(readSeq, values, flags);
+            if (count == 0) break;
+
+            // Lead-off blocks carry no ECG: restart the detector's learning
+            if (flags[0] != 0 || flags[count - 1] != 0) {
+                restartDetection();
+            } else {
+                detectBeats(values, count, readSeq);
+            }
+
+            // The writer reached the view while it was read: those samples
+            // are unreliable, and so is what the detector learned from them
+            uint16_t torn = acquisition.overwritten(readSeq, count);
+            if (torn > 0) {
+                missedSamples += torn;
+                restartDetection();
+            }
+            readSeq += count;
+        }
     }
 
+    // Time of a sample on the ADC sample clock
+    unsigned long sampleTimeMs(uint32_t seq) {
+        return (unsigned long)((uint64_t)seq * 1000 / acquisition.getSampleRate());
+    }
+
+    // True once per detected beat (for the display's beat marker)
+    bool consumeBeat() {
+        bool beat = beatPending;
+        beatPending = false;
+        return beat;
+    }
+
+    const ECGAcquisition &getAcquisition() { return acquisition; }
+    uint32_t getMissedSamples() { return missedSamples; }
+
     // Decision 1: Is the hardware connected?
     bool isConnected() {
         if ((digitalRead(loPlus) == HIGH) || (digitalRead(loMinus) == HIGH)) {
@@ -34,40 +119,58 @@ class ECGManager {
         return true;
     }
 
-    // Decision 2: Find the electrical spike (R-Peak)
-    bool detectBeat(int rawVal) {
-        if (rawVal > threshold && (millis() - lastPeakTime > 300)) {
-            currentInterval = millis() - lastPeakTime;
-            lastPeakTime = millis();
-            return true; 
+    // Decision 2: Find the electrical spike (R-Peak) with Pan-Tompkins
+    // RR intervals come from sample indices, so they are sample-accurate
+    uint8_t detectBeats(const int16_t *values, uint16_t count, uint32_t firstSeq) {
+        uint8_t found = detector.process(values, count, firstSeq, beats, ECG_MAX_BEATS);
+        for (uint8_t i = 0; i < found; i++) {
+            lastBeatSeq = beats[i].seq;
+            if (beats[i].rrSamples > 0) {
+                currentInterval = (long)beats[i].rrSamples * 1000 / acquisition.getSampleRate();
+                hrvShort.addInterval((uint16_t)currentInterval);
+                hrvLong.addInterval((uint16_t)currentInterval);
+            }
+            beatPending = true;
         }
-        return false;
+        return found;
+    }
+
+    uint32_t getLastBeatSeq() { return lastBeatSeq; }
+
+    // HRV over the ~1 minute window (display and cloud)
+    const HRVMetrics &getHRV() { return hrvLong; }
+
+    // Decision 3: Translate HRV into Stress Level
+    // (low RMSSD = low vagal tone = higher stress)
+    StressLevel getStressCode() {
+        if (hrvLong.getCount() < HRV_MIN_BEATS) return STRESS_SENSING;
+        float rmssd = hrvLong.getRMSSD();
+        if (rmssd > 40) return STRESS_LOW;
+        if (rmssd > 20) return STRESS_MODERATE;
+        return STRESS_HIGH;
     }
 
-    // Decision 3: Translate Interval into Stress Level
-    String getStressLevel() {
-        if (currentInterval == 0) return "Sensing...";
-        if (currentInterval > 850) return "Low (Relaxed)";
-        if (currentInterval > 700) return "Moderate";
-        return "High Stress";
+    const char *getStressLevel() {
+        return STRESS_LEVEL_TEXT[getStressCode()];
+    }
+
+    // Decision 4: Translate beat-to-beat variation into Rhythm Status
+    // Read-only: the answer no longer depends on how often it is asked
+    RhythmStatus getRhythmCode() {
+        if (hrvShort.getCount() < HRV_MIN_BEATS) return RHYTHM_ANALYSING;
+
+        // Successive differences relative to the mean interval
+        float variation = hrvShort.getRMSSD() / hrvShort.getMeanRR();
+        if (variation < 0.12f) return RHYTHM_STABLE; // Very little variation
+        return RHYTHM_IRREGULAR;                     // High variation detected
     }
 
-    // Decision 4: Translate timing into Rhythm Status
-    String getRhythmStatus() {
-        static long lastStoredInterval = 0;
-        if (currentInterval == 0) return "Analysing...";
-        
-        // Compare current beat timing to the previous one
-        long diff = abs(currentInterval - lastStoredInterval);
-        lastStoredInterval = currentInterval;
-
-        if (diff < 100) return "Stable"; // Very little variation
-        return "Irregular";            // High variation detected
+    const char *getRhythmStatus() {
+        return RHYTHM_STATUS_TEXT[getRhythmCode()];
     }
 
-    int getGraphValue(int screenHeight) {
-        if (!isConnected()) return screenHeight / 2;
-        int raw = analogRead(outputPin);
+    // Map one buffered sample to a graph row
+    int getGraphValue(int raw, int screenHeight) {
         // Map 12-bit ESP32 ADC (0-4095) to screen pixels
         return map(raw, 0, 4095, screenHeight - 2, 12); 
     }
@@ -0,0 +1,519 @@
+#ifndef EPISODERECORDER_H
+#define EPISODERECORDER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include "ECGAcquisition.h"
+
+/*
+  EpisodeRecorder
+  ---------------
+  Keeps the raw signals around an event (fall, critical heart alert).
+  - Pre-trigger rings in RAM for ECG, PPG (red + IR) and accelerometer
+  - On trigger, EPISODE_PRE_MS before to EPISODE_POST_MS after is written
+    to LittleFS as delta + zigzag varint blocks, each with a CRC32
+  - Encoding is incremental (bounded frames per update) and each update()
+    writes at most one page, so loop() never stalls on a whole episode;
+    acquisition itself runs from hardware FIFOs / the ECG task
+  - EpisodeReader streams the blocks back one at a time for upload
+  - Episodes rotate through EPISODE_SLOTS files (/ep_0000.bin ...): a new
+    one replaces the oldest, and further old ones are dropped until
+    EPISODE_MIN_FREE bytes of flash are free. begin() resumes after the
+    highest sequence number found
+  - A short flash write ends the episode early; it is kept (every block
+    before the cut still decodes) and counted as truncated
+
+  File layout (little endian):
+    File header  : "EPH1", reason u8, version u8, ecgRate u16, ppgRate u16,
+                   sequence u16, triggerMs u32                         (16 bytes)
+    Block        : "EPB1", channel u8, width u8, frames u16, firstSeq u32,
+                   payload u16, reserved u16, payload..., crc32 u32
+    Payload      : per frame, per column: zigzag varint of (value - previous)
+                   (the first frame of a block is relative to 0)
+*/
+
+#define EPISODE_PRE_MS 10000
+#define EPISODE_POST_MS 20000
+#define EPISODE_COOLDOWN_MS 60000     // Minimum gap between episodes
+#define EPISODE_GRACE_MS 2000         // Channels still short after POST + grace are closed
+
+#define EPISODE_ECG_RING 8192         // > 10 s at 500 Hz
+#define EPISODE_PPG_RING 2048         // > 10 s at 100 Hz
+#define EPISODE_ACC_RING 2048         // > 10 s at the accelerometer rate
+#define EPISODE_ECG_STAGE 128         // ECG samples copied per check against the writer
+
+#define EPISODE_PAGE_SIZE 256         // One flash program page per block
+#define EPISODE_PAGE_QUEUE 8          // Encoded pages waiting for flash
+#define EPISODE_BLOCK_HEADER 16
+#define EPISODE_BLOCK_CRC 4
+#define EPISODE_FILE_HEADER 16
+#define EPISODE_ENCODE_BUDGET 512     // Frames encoded per channel per update()
+#define EPISODE_SLOTS 16              // Episode files kept on flash
+#define EPISODE_MIN_FREE 65536        // Free flash needed to start an episode (typical: ~40 KB)
+
+enum EpisodeReason : uint8_t { EPISODE_FALL = 1, EPISODE_HEART = 2, EPISODE_SOS = 3 };
+enum EpisodeChannel : uint8_t { EPISODE_CH_ECG, EPISODE_CH_PPG, EPISODE_CH_ACC, EPISODE_CH_COUNT };
+
+// --- ENCODING HELPERS ---
+inline uint32_t episodeCrc32(uint32_t crc, const uint8_t *data, size_t length) {
+    // Nibble-table CRC-32 (IEEE), small enough to keep in flash
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+inline void episodePut16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+inline void episodePut32(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+inline uint16_t episodeGet16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+inline uint32_t episodeGet32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Fixed ring of multi-column frames with a monotonic sequence number
+template <typename T, size_t N, uint8_t W>
+class EpisodeRing {
+  private:
+    T frames[N][W];
+    uint32_t writeSeq = 0;
+
+  public:
+    void push(const T *values) {
+        T *slot = frames[writeSeq % N];
+        for (uint8_t c = 0; c < W; c++) slot[c] = values[c];
+        writeSeq++;
+    }
+
+    const T *at(uint32_t seq) const { return frames[seq % N]; }
+    uint32_t getWriteSeq() const { return writeSeq; }
+    uint32_t getOldestSeq() const { return (writeSeq > N) ? writeSeq - N : 0; }
+    static constexpr uint8_t width() { return W; }
+};
+
+class EpisodeRecorder {
+  private:
+    // Pre-trigger storage
+    EpisodeRing<int16_t, EPISODE_ECG_RING, 1> ecgRing;
+    EpisodeRing<int32_t, EPISODE_PPG_RING, 2> ppgRing;   // red, ir
+    EpisodeRing<int16_t, EPISODE_ACC_RING, 4> accRing;   // x, y, z, dt (ms)
+    uint32_t ecgReadSeq = 0;
+    int16_t ecgStage[EPISODE_ECG_STAGE];   // View copy, checked before it is kept
+    uint32_t lastAccMs = 0;
+
+    uint16_t ecgRate = 500;
+    uint16_t ppgRate = 100;
+    uint16_t accRate = 100;  // Nominal, used to size the window only
+
+    // Encoder state per channel
+    struct Cursor {
+        uint32_t next;
+        uint32_t end;
+        bool done;
+    };
+    Cursor cursors[EPISODE_CH_COUNT];
+
+    // Encoded pages waiting to be written
+    uint8_t pages[EPISODE_PAGE_QUEUE][EPISODE_PAGE_SIZE];
+    uint16_t pageLength[EPISODE_PAGE_QUEUE];
+    uint8_t pageHead = 0;   // Next page to fill
+    uint8_t pageTail = 0;   // Next page to write
+    uint8_t pagesQueued = 0;
+
+    bool fsOK = false;
+    bool recording = false;
+    unsigned long triggerTime = 0;
+    File file;
+    uint16_t episodeNumber = 0;
+    unsigned long lastEpisodeEnd = 0;
+    bool hadEpisode = false;
+
+    // Stats
+    uint32_t episodesWritten = 0;
+    uint32_t episodesTruncated = 0;
+    uint32_t episodesDropped = 0;    // Old episodes deleted to make room
+    uint32_t bytesWritten = 0;
+    uint32_t framesLost = 0;
+    uint32_t maxEncodeMicros = 0;
+
+    static uint8_t putVarint(uint8_t *p, int32_t value) {
+        uint32_t z = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+        uint8_t n = 0;
+        while (z >= 0x80) {
+            p[n++] = (uint8_t)(z | 0x80);
+            z >>= 7;
+        }
+        p[n++] = (uint8_t)z;
+        return n;
+    }
+
+    // Encode one block from 'ring' into the next free page.
+    // Returns frames encoded (0 = nothing to do or no free page).
+    template <typename Ring>
+    uint16_t encodeBlock(const Ring &ring, EpisodeChannel channel, uint16_t budget) {
+        Cursor &cur = cursors[channel];
+        if (cur.done || pagesQueued == EPISODE_PAGE_QUEUE) return 0;
+
+        // Frames overwritten before we got to them are skipped
+        uint32_t oldest = ring.getOldestSeq();
+        if (cur.next < oldest) {
+            framesLost += oldest - cur.next;
+            cur.next = oldest;
+        }
+
+        uint32_t available = ring.getWriteSeq();
+        if (available > cur.end) available = cur.end;
+        if (cur.next >= available) {
+            if (cur.next >= cur.end) cur.done = true;
+            return 0;
+        }
+
+        const uint8_t width = Ring::width();
+        uint8_t *page = pages[pageHead];
+        uint8_t *payload = page + EPISODE_BLOCK_HEADER;
+        const uint16_t maxPayload = EPISODE_PAGE_SIZE - EPISODE_BLOCK_HEADER - EPISODE_BLOCK_CRC;
+
+        int32_t prev[4] = { 0, 0, 0, 0 };
+        uint16_t used = 0;
+        uint16_t frames = 0;
+        uint32_t firstSeq = cur.next;
+
+        // Stop while a worst-case frame (5 bytes per column) still fits
+        while (cur.next < available && frames < budget && used + width * 5 <= maxPayload) {
+            const auto *frame = ring.at(cur.next);
+            for (uint8_t c = 0; c < width; c++) {
+                int32_t v = frame[c];
+                used += putVarint(payload + used, v - prev[c]);
+                prev[c] = v;
+            }
+            cur.next++;
+            frames++;
+        }
+
+        memcpy(page, "EPB1", 4);
+        page[4] = channel;
+        page[5] = width;
+        episodePut16(page + 6, frames);
+        episodePut32(page + 8, firstSeq);
+        episodePut16(page + 12, used);
+        episodePut16(page + 14, 0);
+        uint32_t crc = episodeCrc32(0, page, EPISODE_BLOCK_HEADER + used);
+        episodePut32(payload + used, crc);
+
+        pageLength[pageHead] = EPISODE_BLOCK_HEADER + used + EPISODE_BLOCK_CRC;
+        pageHead = (pageHead + 1) % EPISODE_PAGE_QUEUE;
+        pagesQueued++;
+
+        if (cur.next >= cur.end) cur.done = true;
+        return frames;
+    }
+
+    void startCursor(EpisodeChannel channel, uint32_t nowSeq, uint32_t oldestSeq, uint16_t rate) {
+        uint32_t pre = (uint32_t)rate * EPISODE_PRE_MS / 1000;
+        uint32_t post = (uint32_t)rate * EPISODE_POST_MS / 1000;
+        Cursor &cur = cursors[channel];
+        cur.next = (nowSeq > pre) ? nowSeq - pre : 0;
+        if (cur.next < oldestSeq) cur.next = oldestSeq;
+        cur.end = nowSeq + post;
+        cur.done = false;
+    }
+
+    static void slotPath(char *path, size_t size, uint16_t sequence) {
+        snprintf(path, size, "/ep_%04u.bin", sequence % EPISODE_SLOTS);
+    }
+
+    static size_t freeBytes() {
+        size_t total = LittleFS.totalBytes(), used = LittleFS.usedBytes();
+        return (total > used) ? total - used : 0;
+    }
+
+    // Delete the episode that used to hold this slot
+    void dropSlot(uint16_t sequence) {
+        char path[20];
+        slotPath(path, sizeof(path), sequence);
+        if (LittleFS.exists(path) && LittleFS.remove(path)) episodesDropped++;
+    }
+
+    void finishEpisode(bool complete) {
+        file.close();
+        recording = false;
+        episodesWritten++;
+        lastEpisodeEnd = millis();
+        hadEpisode = true;
+        // episodeNumber already points at the next one
+        uint16_t number = episodeNumber - 1;
+        if (complete) {
+            Serial.printf("💾 Episode %u saved\n", number);
+        } else {
+            episodesTruncated++;
+            pageHead = pageTail = pagesQueued = 0;
+            Serial.printf("⚠️ Episode %u truncated (flash write failed)\n", number);
+        }
+    }
+
+  public:
+    bool begin(uint16_t ecgSampleRate, uint16_t ppgSampleRate) {
+        ecgRate = ecgSampleRate;
+        ppgRate = ppgSampleRate;
+        for (uint8_t c = 0; c < EPISODE_CH_COUNT; c++) cursors[c].done = true;
+        fsOK = LittleFS.begin(true); // Format on first use
+        if (!fsOK) {
+            Serial.println("❌ LittleFS FAILED (episodes disabled)");
+            return false;
+        }
+
+        // Continue numbering after the newest episode already stored
+        bool found = false;
+        for (uint16_t slot = 0; slot < EPISODE_SLOTS; slot++) {
+            char path[20];
+            slotPath(path, sizeof(path), slot);
+            File stored = LittleFS.open(path, FILE_READ);
+            if (!stored) continue;
+            uint8_t header[EPISODE_FILE_HEADER];
+            if (stored.read(header, sizeof(header)) == sizeof(header) && memcmp(header, "EPH1", 4) == 0) {
+                uint16_t sequence = episodeGet16(header + 10);
+                if (!found || (int16_t)(sequence - episodeNumber) >= 0) episodeNumber = sequence + 1;
+                found = true;
+            }
+            stored.close();
+        }
+
+        // Episodes from before the rotation were numbered on past the slots
+        for (uint16_t n = EPISODE_SLOTS; n < 9999; n++) {
+            char path[20];
+            snprintf(path, sizeof(path), "/ep_%04u.bin", n);
+            if (!LittleFS.exists(path) || !LittleFS.remove(path)) break;
+        }
+        return true;
+    }
+
+    // --- SAMPLE INPUT (call every loop) ---
+
+    // Copy every ECG sample not yet seen from the acquisition ring. Each
+    // view is staged and checked against the writer before it is kept
+    void addEcg(const ECGAcquisition &acq) {
+        const int16_t *values;
+        const uint8_t *flags;
+        for (;;) {
+            uint32_t safe = acq.getSafeSeq();
+            if (ecgReadSeq < safe) {
+                framesLost += safe - ecgReadSeq;
+                ecgReadSeq = safe;
+            }
+            uint16_t count = acq.view(ecgReadSeq, values, flags);
+            if (count == 0) break;
+            if (count > EPISODE_ECG_STAGE) count = EPISODE_ECG_STAGE;
+            memcpy(ecgStage, values, count * sizeof(int16_t));
+            uint16_t torn = acq.overwritten(ecgReadSeq, count);
+            framesLost += torn;
+            for (uint16_t i = torn; i < count; i++) ecgRing.push(&ecgStage[i]);
+            ecgReadSeq += count;
+        }
+    }
+
+    void addPpg(const uint32_t *red, const uint32_t *ir, uint16_t count) {
+        for (uint16_t i = 0; i < count; i++) {
+            int32_t frame[2] = { (int32_t)red[i], (int32_t)ir[i] };
+            ppgRing.push(frame);
+        }
+    }
+
+    void addAccel(int16_t x, int16_t y, int16_t z, uint32_t timeMs) {
+        uint32_t dt = timeMs - lastAccMs;
+        lastAccMs = timeMs;
+        int16_t frame[4] = { x, y, z, (int16_t)((dt > 32767) ? 32767 : dt) };
+        accRing.push(frame);
+    }
+
+    // --- TRIGGER ---
+    // Returns true if a new episode was started
+    bool trigger(EpisodeReason reason) {
+        if (!fsOK || recording) return false;
+        if (hadEpisode && millis() - lastEpisodeEnd < EPISODE_COOLDOWN_MS) return false;
+
+        // Replace the oldest episode, then drop the next oldest until there is room
+        dropSlot(episodeNumber);
+        for (uint16_t n = 1; n < EPISODE_SLOTS && freeBytes() < EPISODE_MIN_FREE; n++) {
+            dropSlot(episodeNumber + n);
+        }
+        if (freeBytes() < EPISODE_MIN_FREE) {
+            Serial.println("❌ Flash full, episode not recorded");
+            return false;
+        }
+
+        char path[20];
+        slotPath(path, sizeof(path), episodeNumber);
+        file = LittleFS.open(path, FILE_WRITE);
+        if (!file) return false;
+
+        uint8_t header[EPISODE_FILE_HEADER];
+        memcpy(header, "EPH1", 4);
+        header[4] = reason;
+        header[5] = 2; // Format version
+        episodePut16(header + 6, ecgRate);
+        episodePut16(header + 8, ppgRate);
+        episodePut16(header + 10, episodeNumber);
+        episodePut32(header + 12, millis());
+        size_t written = file.write(header, sizeof(header));
+        bytesWritten += written;
+        if (written != sizeof(header)) {
+            file.close();
+            LittleFS.remove(path);
+            return false;
+        }
+
+        startCursor(EPISODE_CH_ECG, ecgRing.getWriteSeq(), ecgRing.getOldestSeq(), ecgRate);
+        startCursor(EPISODE_CH_PPG, ppgRing.getWriteSeq(), ppgRing.getOldestSeq(), ppgRate);
+        startCursor(EPISODE_CH_ACC, accRing.getWriteSeq(), accRing.getOldestSeq(), accRate);
+
+        recording = true;
+        triggerTime = millis();
+        episodeNumber++;
+        return true;
+    }
+
+    // Encode a bounded number of frames and write at most one page
+    void update() {
+        if (!recording) return;
+
+        unsigned long start = micros();
+        encodeBlock(ecgRing, EPISODE_CH_ECG, EPISODE_ENCODE_BUDGET);
+        encodeBlock(ppgRing, EPISODE_CH_PPG, EPISODE_ENCODE_BUDGET);
+        encodeBlock(accRing, EPISODE_CH_ACC, EPISODE_ENCODE_BUDGET);
+        uint32_t took = micros() - start;
+        if (took > maxEncodeMicros) maxEncodeMicros = took;
+
+        if (pagesQueued > 0) {
+            size_t written = file.write(pages[pageTail], pageLength[pageTail]);
+            bytesWritten += written;
+            if (written != pageLength[pageTail]) {
+                finishEpisode(false);
+                return;
+            }
+            pageTail = (pageTail + 1) % EPISODE_PAGE_QUEUE;
+            pagesQueued--;
+        }
+
+        // A stalled channel (sensor stopped, slow loop) must not keep the file open
+        if (millis() - triggerTime > EPISODE_POST_MS + EPISODE_GRACE_MS) {
+            for (uint8_t c = 0; c < EPISODE_CH_COUNT; c++) cursors[c].done = true;
+        }
+
+        bool allDone = cursors[EPISODE_CH_ECG].done && cursors[EPISODE_CH_PPG].done &&
+                       cursors[EPISODE_CH_ACC].done;
+        if (allDone && pagesQueued == 0) finishEpisode(true);
+    }
+
+    // --- GETTERS ---
+    bool isRecording() { return recording; }
+    uint16_t getEpisodeCount() { return episodeNumber; }
+    uint32_t getEpisodesWritten() { return episodesWritten; }
+    uint32_t getEpisodesTruncated() { return episodesTruncated; }
+    uint32_t getEpisodesDropped() { return episodesDropped; }
+    uint32_t getBytesWritten() { return bytesWritten; }
+    uint32_t getFramesLost() { return framesLost; }
+    uint32_t getMaxEncodeMicros() { return maxEncodeMicros; }
+};
+
+/*
+  EpisodeReader
+  -------------
+  Streams a stored episode back block by block (constant RAM), verifying
+  each block's CRC before decoding it.
+*/
+struct EpisodeBlock {
+    EpisodeChannel channel;
+    uint8_t width;      // Values per frame
+    uint16_t frames;
+    uint32_t firstSeq;  // Sample number of the first frame on its channel
+};
+
+class EpisodeReader {
+  private:
+    File file;
+    uint8_t page[EPISODE_PAGE_SIZE];
+    uint8_t reason = 0;
+    uint16_t ecgRate = 0;
+    uint16_t ppgRate = 0;
+    uint32_t triggerMs = 0;
+    uint32_t crcErrors = 0;
+
+  public:
+    bool open(uint16_t number) {
+        char path[20];
+        snprintf(path, sizeof(path), "/ep_%04u.bin", number);
+        file = LittleFS.open(path, FILE_READ);
+        if (!file) return false;
+
+        uint8_t header[EPISODE_FILE_HEADER];
+        if (file.read(header, sizeof(header)) != sizeof(header) || memcmp(header, "EPH1", 4) != 0) {
+            file.close();
+            return false;
+        }
+        reason = header[4];
+        ecgRate = episodeGet16(header + 6);
+        ppgRate = episodeGet16(header + 8);
+        triggerMs = episodeGet32(header + 12);
+        return true;
+    }
+
+    // Decode the next valid block into 'values' (frames x width entries).
+    // Blocks with a bad CRC are skipped. Returns false at end of file.
+    bool next(EpisodeBlock &block, int32_t *values, uint16_t maxValues) {
+        while (file && file.available() >= EPISODE_BLOCK_HEADER) {
+            if (file.read(page, EPISODE_BLOCK_HEADER) != EPISODE_BLOCK_HEADER) return false;
+            if (memcmp(page, "EPB1", 4) != 0) return false;
+
+            uint16_t payload = episodeGet16(page + 12);
+            if (payload > EPISODE_PAGE_SIZE - EPISODE_BLOCK_HEADER - EPISODE_BLOCK_CRC) return false;
+            uint8_t *data = page + EPISODE_BLOCK_HEADER;
+            if (file.read(data, payload + EPISODE_BLOCK_CRC) != (size_t)(payload + EPISODE_BLOCK_CRC)) return false;
+
+            if (episodeCrc32(0, page, EPISODE_BLOCK_HEADER + payload) != episodeGet32(data + payload)) {
+                crcErrors++;
+                continue;
+            }
+
+            block.channel = (EpisodeChannel)page[4];
+            block.width = page[5];
+            block.frames = episodeGet16(page + 6);
+            block.firstSeq = episodeGet32(page + 8);
+            if (block.width == 0 || block.width > 4 || (uint32_t)block.frames * block.width > maxValues) return false;
+
+            int32_t prev[4] = { 0, 0, 0, 0 };
+            uint16_t pos = 0;
+            for (uint32_t i = 0; i < (uint32_t)block.frames * block.width; i++) {
+                uint32_t z = 0;
+                uint8_t shift = 0;
+                while (pos < payload) {
+                    uint8_t b = data[pos++];
+                    z |= (uint32_t)(b & 0x7F) << shift;
+                    shift += 7;
+                    if (!(b & 0x80)) break;
+                }
+                int32_t delta = (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+                uint8_t c = i % block.width;
+                prev[c] += delta;
+                values[i] = prev[c];
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void close() { file.close(); }
+
+    uint8_t getReason() { return reason; }
+    uint16_t getEcgRate() { return ecgRate; }
+    uint16_t getPpgRate() { return ppgRate; }
+    uint32_t getTriggerMs() { return triggerMs; }
+    uint32_t getCrcErrors() { return crcErrors; }
+};
+
+#endif
@@ -0,0 +1,348 @@
+#ifndef FALLDETECTOR_H
+#define FALLDETECTOR_H
+
+#include <Arduino.h>
+#include <math.h>
+#include "AccelKernel.h"
+
+/*
+  FallDetector
+  ------------
+  Multi-stage fall detection over a short accelerometer ring buffer.
+  - A candidate starts at an impact (|a| > FALL_IMPACT_TRIGGER_MG), or
+    without one at a tilt: the gravity vector of the last FALL_TILT_WINDOW
+    samples is FALL_ANGLE_MIN_DEG or more away from the delayed pre-event
+    window while |a| is steady (a slow slump). Nothing else is decided on
+    a single sample
+  - Four stages are scored (0..100 each) and weighted into a confidence:
+      free-fall   : longest |a| < free-fall threshold run ending shortly
+                    before the impact (or the MPU6050 free-fall interrupt)
+      impact      : peak |a| in the FALL_IMPACT_MS after the trigger
+      orientation : angle between the gravity vector before the event
+                    (delayed window, 1.5..2.5 s old, so a slow slump is
+                    still upright in it) and after it settles
+      inactivity  : how still |a| is in the post-impact window
+  - A jump (free-fall + impact, upright and moving afterwards) or a slap
+    (impact only) scores low; a slow slump (no impact, lying still,
+    rotated) scores high without any free-fall. A tilt candidate has no
+    impact to score, so its confidence is weighted over the other three
+    stages (lying down quickly and staying still looks the same)
+  - Per sample the cost is constant (running sums over the ring); the
+    float math runs once per candidate. The result carries the confidence
+    and the impact timestamp
+*/
+
+#define FALL_RING 256                   // 2.56 s at 100 Hz
+#define FALL_PRE_NEAR 150               // Pre-event gravity: samples 150..250 old
+#define FALL_PRE_FAR 250
+#define FALL_IMPACT_TRIGGER_MG 1600
+#define FALL_IMPACT_FULL_MG 3000
+#define FALL_FREEFALL_MIN_MS 30
+#define FALL_FREEFALL_FULL_MS 200
+#define FALL_FREEFALL_GAP_MS 500        // Free-fall must end this close to the impact
+#define FALL_IMPACT_MS 500              // Peak search after the trigger
+#define FALL_SETTLE_MS 1500             // Post window starts this long after the impact
+#define FALL_POST_MS 2000
+#define FALL_ANGLE_MIN_DEG 30
+#define FALL_ANGLE_FULL_DEG 70
+#define FALL_STILL_FULL 100             // Post-impact |a|^2 std (kernel units, ~0.025 g)
+#define FALL_STILL_NONE 400
+#define FALL_CONFIRM_CONFIDENCE 60
+#define FALL_TILT_WINDOW 50             // Recent gravity for the tilt trigger (0.5 s)
+#define FALL_TILT_SHIFT 8               // Sum scaling before the integer angle test
+
+// Stage weights (sum 100)
+#define FALL_WEIGHT_FREEFALL 25
+#define FALL_WEIGHT_IMPACT 15
+#define FALL_WEIGHT_ORIENTATION 35
+#define FALL_WEIGHT_INACTIVITY 25
+
+struct FallEvent {
+    uint32_t timeMs = 0;       // Impact time (sample clock)
+    uint8_t confidence = 0;    // 0..100
+    uint8_t freefallScore = 0;
+    uint8_t impactScore = 0;
+    uint8_t orientationScore = 0;
+    uint8_t inactivityScore = 0;
+    uint16_t freefallMs = 0;
+    uint16_t impactMilliG = 0;
+    uint8_t angleDeg = 0;
+    bool tilt = false;         // Opened by a tilt, not an impact
+};
+
+class FallDetector {
+  private:
+    enum Stage : uint8_t { STAGE_MONITOR, STAGE_IMPACT, STAGE_SETTLE, STAGE_POST };
+
+    struct Entry {
+        int16_t x;
+        int16_t y;
+        int16_t z;
+        uint16_t mag2;
+    };
+
+    Entry ring[FALL_RING];
+    uint16_t ringPos = 0;
+    uint32_t ringCount = 0;
+    int32_t preSum[3] = { 0, 0, 0 };    // Delayed gravity window (FALL_PRE_NEAR..FAR old)
+    int32_t recentSum[3] = { 0, 0, 0 }; // Last FALL_TILT_WINDOW samples
+    uint32_t recentMag = 0;             // Sum of |a|^2 over the same window
+    uint64_t recentMagSq = 0;
+    uint16_t impactTrigger = 0;         // Kernel units
+    uint16_t tiltCos2 = 0;              // cos^2(FALL_ANGLE_MIN_DEG), Q8
+
+    Stage stage = STAGE_MONITOR;
+
+    // Free-fall runs
+    bool inFreefall = false;
+    uint32_t freefallStart = 0;
+    uint32_t lastFreefallEnd = 0;
+    uint16_t lastFreefallMs = 0;
+    bool hwFreefall = false;
+    uint32_t hwFreefallMs = 0;
+
+    // Current candidate
+    FallEvent candidate;
+    uint16_t peak = 0;
+    int32_t before[3] = { 0, 0, 0 };
+    int32_t afterSum[3] = { 0, 0, 0 };
+    uint32_t postSum = 0;
+    uint64_t postSumSq = 0;
+    uint16_t postCount = 0;
+
+    // Output
+    FallEvent lastEvent;
+    bool eventPending = false;
+    uint32_t candidates = 0;
+    uint32_t confirmed = 0;
+    uint32_t rejected = 0;
+
+    static uint8_t ramp(float value, float zero, float full) {
+        if (value <= zero) return 0;
+        if (value >= full) return 100;
+        return (uint8_t)(100 * (value - zero) / (full - zero));
+    }
+
+    static float milliG(uint16_t mag2) {
+        return sqrtf((float)((uint32_t)mag2 << ACCEL_KERNEL_SHIFT)) * 1000.0f / 16384.0f;
+    }
+
+    void push(const AccelSample &s, uint16_t mag2) {
+        ring[ringPos] = { s.x, s.y, s.z, mag2 };
+        ringCount++;
+        // Slide the recent window
+        recentSum[0] += s.x;
+        recentSum[1] += s.y;
+        recentSum[2] += s.z;
+        recentMag += mag2;
+        recentMagSq += (uint32_t)mag2 * mag2;
+        if (ringCount > FALL_TILT_WINDOW) {
+            const Entry &out = ring[(ringPos + FALL_RING - FALL_TILT_WINDOW) % FALL_RING];
+            recentSum[0] -= out.x;
+            recentSum[1] -= out.y;
+            recentSum[2] -= out.z;
+            recentMag -= out.mag2;
+            recentMagSq -= (uint32_t)out.mag2 * out.mag2;
+        }
+        // Slide the delayed gravity window by one sample
+        if (ringCount > FALL_PRE_NEAR) {
+            const Entry &in = ring[(ringPos + FALL_RING - FALL_PRE_NEAR) % FALL_RING];
+            preSum[0] += in.x;
+            preSum[1] += in.y;
+            preSum[2] += in.z;
+        }
+        if (ringCount > FALL_PRE_FAR) {
+            const Entry &out = ring[(ringPos + FALL_RING - FALL_PRE_FAR) % FALL_RING];
+            preSum[0] -= out.x;
+            preSum[1] -= out.y;
+            preSum[2] -= out.z;
+        }
+        ringPos = (ringPos + 1) % FALL_RING;
+    }
+
+    void trackFreefall(uint32_t timeMs, bool low) {
+        if (low && !inFreefall) {
+            inFreefall = true;
+            freefallStart = timeMs;
+        } else if (!low && inFreefall) {
+            inFreefall = false;
+            lastFreefallEnd = timeMs;
+            uint32_t duration = timeMs - freefallStart;
+            lastFreefallMs = (duration > 65535) ? 65535 : (uint16_t)duration;
+        }
+    }
+
+    // Gravity turned by FALL_ANGLE_MIN_DEG or more against the pre-event
+    // window while |a| is steady. Integer only: the sums are scaled down so
+    // dot^2 << 8 fits in 64 bits
+    bool tilted() {
+        if (ringCount <= FALL_PRE_FAR) return false;
+        uint32_t mean = recentMag / FALL_TILT_WINDOW;
+        uint64_t meanSq = recentMagSq / FALL_TILT_WINDOW;
+        uint64_t var = (meanSq > (uint64_t)mean * mean) ? meanSq - (uint64_t)mean * mean : 0;
+        if (var >= (uint64_t)FALL_STILL_NONE * FALL_STILL_NONE) return false;
+
+        int64_t dot = 0, nPre = 0, nRecent = 0;
+        for (uint8_t a = 0; a < 3; a++) {
+            int64_t p = preSum[a] >> FALL_TILT_SHIFT;
+            int64_t r = recentSum[a] >> FALL_TILT_SHIFT;
+            dot += p * r;
+            nPre += p * p;
+            nRecent += r * r;
+        }
+        if (nPre == 0 || nRecent == 0) return false;
+        if (dot <= 0) return true;  // 90 degrees or more
+        return ((dot * dot) << 8) < (int64_t)tiltCos2 * nPre * nRecent;
+    }
+
+    void startCandidate(uint32_t timeMs, uint16_t mag2, bool tilt) {
+        candidates++;
+        candidate = FallEvent();
+        candidate.timeMs = timeMs;
+        candidate.tilt = tilt;
+        peak = mag2;
+        for (uint8_t a = 0; a < 3; a++) {
+            before[a] = preSum[a];
+            afterSum[a] = 0;
+        }
+        postSum = 0;
+        postSumSq = 0;
+        postCount = 0;
+
+        // Free-fall that ended just before this impact
+        if (lastFreefallEnd != 0 && timeMs - lastFreefallEnd <= FALL_FREEFALL_GAP_MS) {
+            candidate.freefallMs = lastFreefallMs;
+        }
+        candidate.freefallScore = ramp(candidate.freefallMs, FALL_FREEFALL_MIN_MS, FALL_FREEFALL_FULL_MS);
+        // The sensor's free-fall interrupt already required all axes < ~0.2 g
+        if (hwFreefall && (int32_t)(timeMs - hwFreefallMs) >= 0 && timeMs - hwFreefallMs <= FALL_FREEFALL_GAP_MS + FALL_IMPACT_MS) {
+            candidate.freefallScore = 100;
+        }
+        hwFreefall = false;
+        stage = STAGE_IMPACT;
+    }
+
+    void evaluate() {
+        candidate.impactMilliG = (uint16_t)milliG(peak);
+        candidate.impactScore = ramp(candidate.impactMilliG, FALL_IMPACT_TRIGGER_MG, FALL_IMPACT_FULL_MG);
+
+        // Orientation: angle between the mean gravity vectors
+        float dot = 0, nb = 0, na = 0;
+        for (uint8_t a = 0; a < 3; a++) {
+            float b = before[a];
+            float c = afterSum[a];
+            dot += b * c;
+            nb += b * b;
+            na += c * c;
+        }
+        float angle = 0;
+        if (nb > 0 && na > 0) {
+            float cosine = dot / sqrtf(nb * na);
+            if (cosine > 1) cosine = 1;
+            if (cosine < -1) cosine = -1;
+            angle = acosf(cosine) * 180.0f / PI;
+        }
+        candidate.angleDeg = (uint8_t)angle;
+        candidate.orientationScore = ramp(angle, FALL_ANGLE_MIN_DEG, FALL_ANGLE_FULL_DEG);
+
+        // Inactivity: std of |a|^2 after the impact has settled
+        float mean = postCount ? (float)postSum / postCount : 0;
+        float var = postCount ? (float)postSumSq / postCount - mean * mean : 0;
+        float stdDev = (var > 0) ? sqrtf(var) : 0;
+        candidate.inactivityScore = 100 - ramp(stdDev, FALL_STILL_FULL, FALL_STILL_NONE);
+
+        uint32_t weighted = candidate.freefallScore * FALL_WEIGHT_FREEFALL +
+                            candidate.orientationScore * FALL_WEIGHT_ORIENTATION +
+                            candidate.inactivityScore * FALL_WEIGHT_INACTIVITY;
+        if (candidate.tilt) {
+            candidate.confidence = (uint8_t)(weighted / (100 - FALL_WEIGHT_IMPACT));
+        } else {
+            candidate.confidence = (uint8_t)((weighted + candidate.impactScore * FALL_WEIGHT_IMPACT) / 100);
+        }
+
+        lastEvent = candidate;
+        if (candidate.confidence >= FALL_CONFIRM_CONFIDENCE) {
+            confirmed++;
+            eventPending = true;
+        } else {
+            rejected++;
+        }
+        stage = STAGE_MONITOR;
+    }
+
+    void addSample(const AccelSample &s, uint16_t mag2, bool low) {
+        push(s, mag2);
+        trackFreefall(s.timeMs, low);
+        uint32_t since = s.timeMs - candidate.timeMs;
+
+        switch (stage) {
+        case STAGE_MONITOR:
+            if (mag2 > impactTrigger) startCandidate(s.timeMs, mag2, false);
+            else if (tilted()) startCandidate(s.timeMs, mag2, true);
+            break;
+        case STAGE_IMPACT:
+            if (mag2 > peak) peak = mag2;
+            if (since >= FALL_IMPACT_MS) stage = STAGE_SETTLE;
+            break;
+        case STAGE_SETTLE:
+            if (since >= FALL_SETTLE_MS) stage = STAGE_POST;
+            break;
+        case STAGE_POST:
+            afterSum[0] += s.x;
+            afterSum[1] += s.y;
+            afterSum[2] += s.z;
+            postSum += mag2;
+            postSumSq += (uint32_t)mag2 * mag2;
+            postCount++;
+            if (since >= FALL_SETTLE_MS + FALL_POST_MS) evaluate();
+            break;
+        }
+    }
+
+  public:
+    void begin() {
+        impactTrigger = accelKernelUnits((uint32_t)FALL_IMPACT_TRIGGER_MG * 16384 / 1000);
+        float cosine = cosf(FALL_ANGLE_MIN_DEG * PI / 180.0f);
+        tiltCos2 = (uint16_t)(cosine * cosine * 256 + 0.5f);
+        ringPos = 0;
+        ringCount = 0;
+        recentMag = 0;
+        recentMagSq = 0;
+        for (uint8_t a = 0; a < 3; a++) {
+            preSum[a] = 0;
+            recentSum[a] = 0;
+        }
+        stage = STAGE_MONITOR;
+        inFreefall = false;
+        lastFreefallEnd = 0;
+        hwFreefall = false;
+        eventPending = false;
+    }
+
+    // One batch with its kernel output (belowLow = free-fall threshold)
+    void addBlock(const AccelSample *batch, const AccelBlock &block) {
+        for (uint8_t i = 0; i < block.count; i++) {
+            addSample(batch[i], block.mag2[i], (block.belowLow >> i) & 1);
+        }
+    }
+
+    // MPU6050 free-fall interrupt (hardware event mode), on the sample clock
+    void addFreefallHint(uint32_t timeMs) {
+        hwFreefall = true;
+        hwFreefallMs = timeMs;
+    }
+
+    // True while a candidate is being scored (keep the samples coming)
+    bool isBusy() { return stage != STAGE_MONITOR; }
+
+    // --- OUTPUT ---
+    bool hasEvent() { return eventPending; }
+    void clearEvent() { eventPending = false; }
+    const FallEvent &getLastEvent() { return lastEvent; }   // Last scored candidate
+
+    uint32_t getCandidates() { return candidates; }
+    uint32_t getConfirmed() { return confirmed; }
+    uint32_t getRejected() { return rejected; }
+};
+
+#endif
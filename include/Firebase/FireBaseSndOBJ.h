@@ -2,32 +2,57 @@
 #define FireBaseSndOBJ_h
 
 #include <Arduino.h>
+
+#define FORECAST_TEXT_SIZE 24
+
 class FireBaseSndOBJ{
       private:
     int  steps;
     bool fallDetec;
     bool state;
     int avgBpm;
+    float avgBpm3Min;
+    float bpmStdDev3Min;
+    int minBpm15Min;
+    int maxBpm15Min;
+    int spo2;
+    int signalQuality;
+    float hrvRmssd;
+    float hrvSdnn;
+    float hrvPnn50;
+    int ecgHr;
     float temp;
     float pressure;
     float Altitude;
     int FloorsClimbed;
-    String Forecast;
+    int FloorsDescended;
+    char Forecast[FORECAST_TEXT_SIZE] = "";
 
 
     public:
     FireBaseSndOBJ() {}
 
     // Getters
-    int getSteps() { return steps; }
-    bool getFallDetec() { return fallDetec; }
-    bool getState() { return state; }
-    int getAvgBpm() { return avgBpm; }
-    float getTemp() { return temp; }
-    float getPressure() { return pressure; }
-    float getAltitude() { return Altitude; }
-    int getFloorsClimbed() { return FloorsClimbed; }
-    String getForecast() { return Forecast; }
+    int getSteps() const { return steps; }
+    bool getFallDetec() const { return fallDetec; }
+    bool getState() const { return state; }
+    int getAvgBpm() const { return avgBpm; }
+    float getAvgBpm3Min() const { return avgBpm3Min; }
+    float getBpmStdDev3Min() const { return bpmStdDev3Min; }
+    int getMinBpm15Min() const { return minBpm15Min; }
+    int getMaxBpm15Min() const { return maxBpm15Min; }
+    int getSpo2() const { return spo2; }
+    int getSignalQuality() const { return signalQuality; }
+    float getHrvRmssd() const { return hrvRmssd; }
+    float getHrvSdnn() const { return hrvSdnn; }
+    float getHrvPnn50() const { return hrvPnn50; }
+    int getEcgHr() const { return ecgHr; }
+    float getTemp() const { return temp; }
+    float getPressure() const { return pressure; }
+    float getAltitude() const { return Altitude; }
+    int getFloorsClimbed() const { return FloorsClimbed; }
+    int getFloorsDescended() const { return FloorsDescended; }
+    const char *getForecast() const { return Forecast; }
 
     // Setters
     void setSteps(int s) {
@@ -41,6 +66,24 @@ class FireBaseSndOBJ{
     void setAvgBpm(int bpm) { 
         avgBpm = bpm;
      }
+    void setBpmStats(float avg3Min, float stdDev3Min, int min15Min, int max15Min) {
+        avgBpm3Min = avg3Min;
+        bpmStdDev3Min = stdDev3Min;
+        minBpm15Min = min15Min;
+        maxBpm15Min = max15Min;
+    }
+    void setSpo2(int s) {
+        spo2 = s;
+    }
+    void setSignalQuality(int q) {
+        signalQuality = q;
+    }
+    void setHrv(float rmssd, float sdnn, float pnn50, int meanHr) {
+        hrvRmssd = rmssd;
+        hrvSdnn = sdnn;
+        hrvPnn50 = pnn50;
+        ecgHr = meanHr;
+    }
     void setTemp(float t) {
          temp = t;
          }
@@ -53,9 +96,12 @@ class FireBaseSndOBJ{
     void setFloorsClimbed(int fc) { 
         FloorsClimbed = fc; 
     }
-    void setForecast(String f) {
-         Forecast = f; 
-        
+    void setFloorsDescended(int fd) {
+        FloorsDescended = fd;
+    }
+    void setForecast(const char *f) {
+         strncpy(Forecast, f, FORECAST_TEXT_SIZE - 1);
+         Forecast[FORECAST_TEXT_SIZE - 1] = '\0';
         }
 
 };
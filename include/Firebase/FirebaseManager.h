@@ -10,6 +10,46 @@
 #include <addons/TokenHelper.h>
 #include <addons/RTDBHelper.h>
 
+/*
+  FirebaseManager
+  ---------------
+  Uploads FireBaseSndOBJ snapshots to the RTDB from its own task.
+  - The uploader task runs on core 0 (with the Wi-Fi stack); loop() only
+    copies a snapshot and returns, so the HTTPS round trip (often hundreds
+    of ms) never blocks sampling or the UI
+  - Regular snapshots go through a triple-buffer mailbox (same handoff as
+    the OLED flush task): the loop swaps its back slot with the ready
+    slot, the task swaps the ready slot with its front slot. A snapshot
+    not yet taken is replaced by the newer one (counted as coalesced)
+  - Emergency snapshots (fall) go through a single-producer /
+    single-consumer ring that is never overwritten. The task sends them
+    before anything else, in order, until each is accepted; a failed one
+    is retried with back-off (CLOUD_RETRY_MS doubling up to
+    CLOUD_RETRY_MAX_MS) and regular snapshots keep going out in between
+  - A queued emergency only writes its own fields (fallDetected and the
+    uptime it was raised at): by the time a retry gets through, newer
+    regular snapshots may already have updated the vitals on /sensor
+  - Stats: queue depth, publish-to-upload latency, HTTPS call time,
+    coalesced snapshots and failed uploads. The upload counters are
+    written by the task and read by the loop under a spinlock
+  - If the task cannot be created, update() uploads from the loop as before
+*/
+
+#define CLOUD_TASK_CORE 0          // Wi-Fi core; loop() runs on core 1
+#define CLOUD_TASK_PRIORITY 1
+#define CLOUD_TASK_STACK 8192      // TLS handshake needs the room
+#define CLOUD_EMERGENCY_SLOTS 16   // Power of two
+#define CLOUD_RETRY_MS 1000        // First wait before retrying a failed emergency upload
+#define CLOUD_RETRY_MAX_MS 30000   // Back-off limit
+#define CLOUD_IDLE_MS 100          // Task wake-up without a new snapshot
+#define CLOUD_SNAPSHOT_FRESH 0x80  // Set on the ready slot until the task takes it
+
+struct CloudSnapshot {
+    FireBaseSndOBJ data;
+    uint32_t publishedMs = 0;
+    bool emergency = false;    // Upload the emergency fields only
+};
+
 class FirebaseManager {
   private:
     // --- YOUR CREDENTIALS ---
@@ -24,9 +64,150 @@ class FirebaseManager {
     FirebaseConfig config;
     
     unsigned long lastSendTime = 0;
-    const int sendInterval = 1000; // Faster updates (1 second) for responsiveness
+    const unsigned long sendInterval = 1000; // Faster updates (1 second) for responsiveness
     bool signupOK = false;
 
+    // Uploader task
+    bool useTask = false;
+    TaskHandle_t task = nullptr;
+
+    // Regular snapshots (triple buffer)
+    CloudSnapshot slots[3];
+    uint8_t backSlot = 0;          // Owned by the loop
+    uint8_t frontSlot = 1;         // Owned by the task
+    uint8_t readySlot = 2;         // Shared: index | CLOUD_SNAPSHOT_FRESH
+
+    // Emergency snapshots (SPSC ring, free-running indices)
+    CloudSnapshot emergency[CLOUD_EMERGENCY_SLOTS];
+    uint32_t emergencyHead = 0;    // Written by the loop
+    uint32_t emergencyTail = 0;    // Written by the task
+    CloudSnapshot pendingEmergency;  // Ring full: held here and re-published
+    bool hasPendingEmergency = false;
+
+    // Stats (loop side)
+    uint32_t published = 0;
+    uint32_t coalesced = 0;
+    uint32_t emergencyDrops = 0;
+    uint8_t maxDepth = 0;
+
+    // Stats (task side, under statsLock)
+    portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+    uint32_t uploads = 0;
+    uint32_t failures = 0;
+    uint32_t emergencyRetries = 0;
+    uint64_t latencyTotal = 0;
+    uint32_t maxLatencyMs = 0;
+    uint32_t lastCallMs = 0;
+    uint32_t maxCallMs = 0;
+
+    bool pushEmergency(const CloudSnapshot &snapshot) {
+        uint32_t head = emergencyHead;
+        if (head - __atomic_load_n(&emergencyTail, __ATOMIC_ACQUIRE) >= CLOUD_EMERGENCY_SLOTS) return false;
+        emergency[head & (CLOUD_EMERGENCY_SLOTS - 1)] = snapshot;
+        __atomic_store_n(&emergencyHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    void publish(const FireBaseSndOBJ &data, bool isEmergency) {
+        published++;
+        if (isEmergency || hasPendingEmergency) {
+            if (hasPendingEmergency && pushEmergency(pendingEmergency)) hasPendingEmergency = false;
+            if (isEmergency) {
+                CloudSnapshot snapshot;
+                snapshot.data = data;
+                snapshot.publishedMs = millis();
+                snapshot.emergency = true;
+                if (!pushEmergency(snapshot)) {
+                    if (hasPendingEmergency) emergencyDrops++; // Only with 17 unsent emergencies
+                    pendingEmergency = snapshot;
+                    hasPendingEmergency = true;
+                }
+            }
+        }
+        if (!isEmergency) {
+            slots[backSlot].data = data;
+            slots[backSlot].publishedMs = millis();
+            uint8_t previous = __atomic_exchange_n(&readySlot, backSlot | CLOUD_SNAPSHOT_FRESH, __ATOMIC_ACQ_REL);
+            if (previous & CLOUD_SNAPSHOT_FRESH) coalesced++;
+            backSlot = previous & 0x03;
+        }
+        uint8_t depth = getQueueDepth();
+        if (depth > maxDepth) maxDepth = depth;
+        xTaskNotifyGive(task);
+    }
+
+    // One upload, timed; runs on the uploader task (or the loop as fallback)
+    bool upload(const CloudSnapshot &snapshot) {
+        unsigned long start = millis();
+        bool ok = snapshot.emergency ? sendEmergency(snapshot) : sendData(snapshot.data);
+        uint32_t callMs = millis() - start;
+        uint32_t latency = millis() - snapshot.publishedMs;
+
+        portENTER_CRITICAL(&statsLock);
+        lastCallMs = callMs;
+        if (callMs > maxCallMs) maxCallMs = callMs;
+        if (ok) {
+            uploads++;
+            latencyTotal += latency;
+            if (latency > maxLatencyMs) maxLatencyMs = latency;
+        } else {
+            failures++;
+        }
+        portEXIT_CRITICAL(&statsLock);
+        return ok;
+    }
+
+    // One task-side counter, read from the loop
+    uint32_t readStat(const uint32_t &stat) {
+        portENTER_CRITICAL(&statsLock);
+        uint32_t value = stat;
+        portEXIT_CRITICAL(&statsLock);
+        return value;
+    }
+
+    static void taskEntry(void *arg) {
+        FirebaseManager *self = (FirebaseManager *)arg;
+        uint32_t retryMs = CLOUD_RETRY_MS;  // Current emergency back-off
+        uint32_t nextRetryMs = 0;           // millis() of the next emergency attempt
+        for (;;) {
+            // Token refresh also happens in here, so it stays off the loop too
+            if (!Firebase.ready()) {
+                vTaskDelay(pdMS_TO_TICKS(CLOUD_IDLE_MS));
+                continue;
+            }
+
+            // Emergencies first, in order, until each one is accepted
+            uint32_t tail = self->emergencyTail;
+            bool emergencyWaiting = tail != __atomic_load_n(&self->emergencyHead, __ATOMIC_ACQUIRE);
+            if (emergencyWaiting && (int32_t)(millis() - nextRetryMs) >= 0) {
+                if (self->upload(self->emergency[tail & (CLOUD_EMERGENCY_SLOTS - 1)])) {
+                    __atomic_store_n(&self->emergencyTail, tail + 1, __ATOMIC_RELEASE);
+                    retryMs = CLOUD_RETRY_MS;
+                } else {
+                    portENTER_CRITICAL(&self->statsLock);
+                    self->emergencyRetries++;
+                    portEXIT_CRITICAL(&self->statsLock);
+                    nextRetryMs = millis() + retryMs;
+                    retryMs = (retryMs * 2 > CLOUD_RETRY_MAX_MS) ? CLOUD_RETRY_MAX_MS : retryMs * 2;
+                }
+                continue;
+            }
+
+            // Latest regular snapshot (a failed one is superseded by the next),
+            // also while an emergency waits out its back-off
+            if (!(__atomic_load_n(&self->readySlot, __ATOMIC_ACQUIRE) & CLOUD_SNAPSHOT_FRESH)) {
+                uint32_t waitMs = CLOUD_IDLE_MS;
+                if (emergencyWaiting && nextRetryMs - millis() < waitMs) waitMs = nextRetryMs - millis();
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+                continue;
+            }
+            uint8_t taken = __atomic_exchange_n(&self->readySlot, self->frontSlot, __ATOMIC_ACQ_REL);
+            self->frontSlot = taken & 0x03;
+            // The link works again: retry the waiting emergency right away
+            if (self->upload(self->slots[self->frontSlot]) && emergencyWaiting) nextRetryMs = millis();
+        }
+    }
+
   public:
     FirebaseManager() {}
 
@@ -58,34 +239,56 @@ class FirebaseManager {
         
         Firebase.begin(&config, &auth);
         Firebase.reconnectWiFi(true);
+
+        // 5. Uploader task
+        if (signupOK) {
+            useTask = xTaskCreatePinnedToCore(taskEntry, "cloud_upload", CLOUD_TASK_STACK, this,
+                                              CLOUD_TASK_PRIORITY, &task, CLOUD_TASK_CORE) == pdPASS;
+            if (!useTask) Serial.println("⚠️ Cloud upload task failed, uploading from loop");
+        }
     }
 
-    // Call this from your main loop
-// Updated function with 'force' parameter
-    void update(FireBaseSndOBJ data, bool force = false) {
-        // Check if connected
-        if (Firebase.ready() && signupOK) {
-            // LOGIC CHANGE: 
-            // Send if 'force' is TRUE -OR- if enough time has passed
-            if (force || (millis() - lastSendTime > sendInterval)) {
-                lastSendTime = millis(); // Reset timer
-                sendData(data);
-            }
+    // Call this from your main loop. Only copies the snapshot for the
+    // uploader task; 'force' (emergency) skips the timer and is never dropped
+    void update(const FireBaseSndOBJ &data, bool force = false) {
+        if (!signupOK) return;
+        // Send if 'force' is TRUE -OR- if enough time has passed
+        if (!force && millis() - lastSendTime <= sendInterval) return;
+        lastSendTime = millis(); // Reset timer
+
+        if (useTask) {
+            publish(data, force);
+        } else if (Firebase.ready()) {
+            CloudSnapshot snapshot;
+            snapshot.data = data;
+            snapshot.publishedMs = millis();
+            upload(snapshot);
         }
     }
-    void sendData(FireBaseSndOBJ data) {
+
+    bool sendData(const FireBaseSndOBJ &data) {
         FirebaseJson json;
         
         // Matches the paths in index.html
         json.set("state", data.getState());
         json.set("steps", data.getSteps());
         json.set("heartrate", data.getAvgBpm());
-        json.set("spo2", 0);  // Not in FireBaseSndOBJ, set to default
+        json.set("heartrate3Min", data.getAvgBpm3Min());
+        json.set("heartrateStdDev3Min", data.getBpmStdDev3Min());
+        json.set("heartrateMin15Min", data.getMinBpm15Min());
+        json.set("heartrateMax15Min", data.getMaxBpm15Min());
+        json.set("spo2", data.getSpo2());
+        json.set("signalQuality", data.getSignalQuality());
+        json.set("ecgHeartrate", data.getEcgHr());
+        json.set("hrvRmssd", data.getHrvRmssd());
+        json.set("hrvSdnn", data.getHrvSdnn());
+        json.set("hrvPnn50", data.getHrvPnn50());
         json.set("temperature", data.getTemp());
         json.set("pressure", data.getPressure());
         json.set("fallDetected", data.getFallDetec());
         json.set("altitude", data.getAltitude());
         json.set("floorsClimbed", data.getFloorsClimbed());
+        json.set("floorsDescended", data.getFloorsDescended());
         json.set("forecast", data.getForecast());
         
         // Optional: Add uptime for debugging
@@ -95,7 +298,8 @@ class FirebaseManager {
         // Used 'updateNode' on path "/sensor"
         // This makes the website gauges move! 
         // (Previous 'pushJSON' creates history logs, which the dashboard can't read easily)
-        if (Firebase.RTDB.updateNode(&fbdo, "/sensor", &json)) {
+        bool ok = Firebase.RTDB.updateNode(&fbdo, "/sensor", &json);
+        if (ok) {
             Serial.print("."); // Success dot
         } else {
             Serial.println("\n❌ Upload Error: " + fbdo.errorReason());
@@ -103,7 +307,51 @@ class FirebaseManager {
         
         // OPTIONAL: If you WANT history logs AND live view, uncomment this:
         // Firebase.RTDB.pushJSON(&fbdo, "/HealthHistory", &json);
+        return ok;
+    }
+
+    // Emergency fields only, so a late retry never puts older vitals back
+    bool sendEmergency(const CloudSnapshot &snapshot) {
+        FirebaseJson json;
+        json.set("fallDetected", snapshot.data.getFallDetec());
+        json.set("emergencyUptime", snapshot.publishedMs / 1000);
+
+        bool ok = Firebase.RTDB.updateNode(&fbdo, "/sensor", &json);
+        if (ok) {
+            Serial.print("!"); // Emergency delivered
+        } else {
+            Serial.println("\n❌ Emergency Upload Error: " + fbdo.errorReason());
+        }
+        return ok;
+    }
+
+    // --- STATS ---
+    bool isTaskActive() { return useTask; }
+    TaskHandle_t getTask() { return task; }
+
+    // Snapshots waiting for the task: unsent emergencies plus a fresh regular one
+    uint8_t getQueueDepth() {
+        uint32_t waiting = emergencyHead - __atomic_load_n(&emergencyTail, __ATOMIC_ACQUIRE);
+        if (hasPendingEmergency) waiting++;
+        if (__atomic_load_n(&readySlot, __ATOMIC_ACQUIRE) & CLOUD_SNAPSHOT_FRESH) waiting++;
+        return (uint8_t)waiting;
+    }
+    uint8_t getMaxQueueDepth() { return maxDepth; }
+    uint32_t getPublished() { return published; }
+    uint32_t getUploads() { return readStat(uploads); }
+    uint32_t getFailures() { return readStat(failures); }
+    uint32_t getCoalesced() { return coalesced; }           // Regular snapshots replaced before upload
+    uint32_t getEmergencyRetries() { return readStat(emergencyRetries); }
+    uint32_t getEmergencyDrops() { return emergencyDrops; } // Expected to stay 0
+    uint32_t getMeanLatencyMs() {
+        portENTER_CRITICAL(&statsLock);
+        uint32_t mean = uploads ? (uint32_t)(latencyTotal / uploads) : 0;
+        portEXIT_CRITICAL(&statsLock);
+        return mean;
     }
+    uint32_t getMaxLatencyMs() { return readStat(maxLatencyMs); }
+    uint32_t getLastCallMs() { return readStat(lastCallMs); }
+    uint32_t getMaxCallMs() { return readStat(maxCallMs); }
 };
 
 #endif
\ No newline at end of file
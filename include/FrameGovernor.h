@@ -0,0 +1,90 @@
+#ifndef FRAMEGOVERNOR_H
+#define FRAMEGOVERNOR_H
+
+#include <Arduino.h>
+
+/*
+  FrameGovernor
+  -------------
+  Decides whether a screen needs to be redrawn this loop.
+  - Each screen hashes the values it displays (its input model) with
+    hashOf() / mix(); an unchanged hash means an unchanged frame
+  - A changed model is drawn at most at the screen's maximum FPS
+  - invalidate() forces the next frame (screen switch, clear, animation end)
+  - Draw / skip counts per screen show how much work was avoided
+*/
+
+#define GOVERNOR_MAX_SCREENS 8
+#define GOVERNOR_FNV_OFFSET 2166136261u
+#define GOVERNOR_FNV_PRIME 16777619u
+
+class FrameGovernor {
+  private:
+    struct Slot {
+        uint32_t hash = 0;
+        unsigned long lastDraw = 0;
+        uint16_t minIntervalMs = 0; // 1000 / max FPS
+        bool valid = false;         // false = draw on the next call
+        uint32_t draws = 0;
+        uint32_t skips = 0;
+    };
+
+    Slot slots[GOVERNOR_MAX_SCREENS];
+
+  public:
+    // --- MODEL HASHING (FNV-1a) ---
+    static uint32_t mix(uint32_t hash, const void *data, size_t length) {
+        const uint8_t *p = (const uint8_t *)data;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= p[i];
+            hash *= GOVERNOR_FNV_PRIME;
+        }
+        return hash;
+    }
+
+    static uint32_t mix(uint32_t hash, const char *text) {
+        return text ? mix(hash, text, strlen(text)) : hash;
+    }
+
+    static uint32_t mix(uint32_t hash, int32_t value) {
+        return mix(hash, &value, sizeof(value));
+    }
+
+    static uint32_t start() { return GOVERNOR_FNV_OFFSET; }
+
+    // --- CONFIGURATION ---
+    void setMaxFps(uint8_t screen, uint8_t fps) {
+        if (screen >= GOVERNOR_MAX_SCREENS) return;
+        slots[screen].minIntervalMs = fps ? 1000 / fps : 0;
+    }
+
+    void invalidate() {
+        for (uint8_t i = 0; i < GOVERNOR_MAX_SCREENS; i++) slots[i].valid = false;
+    }
+
+    // true = draw now (the model changed and the FPS cap allows it)
+    bool shouldDraw(uint8_t screen, uint32_t modelHash) {
+        if (screen >= GOVERNOR_MAX_SCREENS) return true;
+        Slot &s = slots[screen];
+        unsigned long now = millis();
+
+        bool changed = !s.valid || modelHash != s.hash;
+        bool due = !s.valid || now - s.lastDraw >= s.minIntervalMs;
+        if (!changed || !due) {
+            s.skips++;
+            return false;
+        }
+
+        s.hash = modelHash;
+        s.lastDraw = now;
+        s.valid = true;
+        s.draws++;
+        return true;
+    }
+
+    // --- GETTERS ---
+    uint32_t getDraws(uint8_t screen) { return screen < GOVERNOR_MAX_SCREENS ? slots[screen].draws : 0; }
+    uint32_t getSkips(uint8_t screen) { return screen < GOVERNOR_MAX_SCREENS ? slots[screen].skips : 0; }
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef HRVMETRICS_H
+#define HRVMETRICS_H
+
+#include <stdint.h>
+#include <math.h>
+
+/*
+  HRVMetrics
+  ----------
+  Heart-rate variability over the last N RR intervals.
+  - RR intervals (ms) live in a fixed ring; the window length is set in begin()
+  - Sums for mean/SDNN and successive-difference sums for RMSSD/pNN50 are
+    updated when a beat enters or leaves the window: O(1) per beat
+  - Queries are read-only (no state changes, safe to call every frame)
+*/
+
+#define HRV_MAX_BEATS 128
+#define HRV_MIN_RR_MS 300   // Intervals outside this range are artefacts
+#define HRV_MAX_RR_MS 2000
+#define HRV_NN50_MS 50
+
+class HRVMetrics {
+  private:
+    uint16_t rr[HRV_MAX_BEATS];
+    uint16_t window = 64;   // Beats in the window
+    uint16_t head = 0;      // Next write slot
+    uint16_t count = 0;
+
+    // Running sums over the window
+    uint32_t sumRR = 0;
+    uint32_t sumSqRR = 0;
+    uint32_t sumSqDiff = 0; // Successive differences (count - 1 of them)
+    uint16_t nn50 = 0;
+
+    uint16_t at(uint16_t i) const { // 0 = oldest
+        return rr[(head + HRV_MAX_BEATS - count + i) % HRV_MAX_BEATS];
+    }
+
+  public:
+    // beats: window length in RR intervals (2..HRV_MAX_BEATS)
+    void begin(uint16_t beats) {
+        if (beats < 2) beats = 2;
+        if (beats > HRV_MAX_BEATS) beats = HRV_MAX_BEATS;
+        window = beats;
+        reset();
+    }
+
+    void reset() {
+        head = 0;
+        count = 0;
+        sumRR = 0;
+        sumSqRR = 0;
+        sumSqDiff = 0;
+        nn50 = 0;
+    }
+
+    // Add one RR interval; returns false if it was rejected as an artefact
+    bool addInterval(uint16_t rrMs) {
+        if (rrMs < HRV_MIN_RR_MS || rrMs > HRV_MAX_RR_MS) return false;
+
+        // 1. Evict the oldest interval (and its difference to the next one)
+        if (count == window) {
+            uint16_t oldest = at(0);
+            uint16_t next = at(1);
+            int32_t diff = (int32_t)next - oldest;
+            sumRR -= oldest;
+            sumSqRR -= (uint32_t)oldest * oldest;
+            sumSqDiff -= (uint32_t)(diff * diff);
+            if (diff > HRV_NN50_MS || diff < -HRV_NN50_MS) nn50--;
+            count--;
+        }
+
+        // 2. Add the new interval and its difference to the previous one
+        if (count > 0) {
+            int32_t diff = (int32_t)rrMs - at(count - 1);
+            sumSqDiff += (uint32_t)(diff * diff);
+            if (diff > HRV_NN50_MS || diff < -HRV_NN50_MS) nn50++;
+        }
+        rr[head] = rrMs;
+        head = (head + 1) % HRV_MAX_BEATS;
+        count++;
+        sumRR += rrMs;
+        sumSqRR += (uint32_t)rrMs * rrMs;
+        return true;
+    }
+
+    // --- GETTERS ---
+    uint16_t getCount() const { return count; }
+    uint16_t getWindow() const { return window; }
+    bool isFull() const { return count == window; }
+
+    float getMeanRR() const {
+        return count ? (float)sumRR / count : 0;
+    }
+
+    float getMeanHR() const {
+        return sumRR ? 60000.0f * count / sumRR : 0;
+    }
+
+    // Standard deviation of the RR intervals
+    float getSDNN() const {
+        if (count < 2) return 0;
+        // Exact integer variance: (n*sumSq - sum^2) / n^2
+        uint64_t n = count;
+        uint64_t num = n * sumSqRR - (uint64_t)sumRR * sumRR;
+        return sqrtf((float)num / (float)(n * n));
+    }
+
+    // Root mean square of successive differences
+    float getRMSSD() const {
+        if (count < 2) return 0;
+        return sqrtf((float)sumSqDiff / (count - 1));
+    }
+
+    // Percentage of successive differences above 50 ms
+    float getPNN50() const {
+        if (count < 2) return 0;
+        return 100.0f * nn50 / (count - 1);
+    }
+};
+
+#endif
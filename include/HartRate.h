@@ -4,162 +4,349 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <MAX30105.h>
-#include <heartRate.h>
+#include "RingBuffer.h"
+#include "SpO2Estimator.h"
+#include "PPGBeatDetector.h"
+#include "RollingStats.h"
+#include "I2CBus.h"
 
-#define RATE_SIZE 4 // Reduced size for faster feedback
+// --- MAX30102 FIFO ---
+#define MAX30102_ADDR 0x57
+#define MAX30102_I2C_CLOCK 400000
+#define MAX30102_FIFO_WR_PTR 0x04
+#define MAX30102_FIFO_DATA 0x07
+#define MAX30102_FIFO_DEPTH 32
+#define PPG_BYTES_PER_SAMPLE 6 // Red (3 bytes) + IR (3 bytes)
+#define PPG_RING_SIZE 64       // Two full FIFOs of headroom between loops
+#define PPG_MAX_BEATS 8        // Beats reported per processed block
+
+// --- ROLLING BPM WINDOWS ---
+enum BpmWindow : uint8_t {
+  BPM_WINDOW_10S,
+  BPM_WINDOW_1MIN,
+  BPM_WINDOW_3MIN,
+  BPM_WINDOW_15MIN,
+  BPM_WINDOW_COUNT
+};
+#define BPM_MIN_BEATS_SHORT 8  // Beats needed before the 10 s window can raise alerts
+#define BPM_SETTLE_MS 10000    // Sensor-clock time before beats enter the windows
 
 // --- DATA STRUCTURES ---
+enum HeartStatus : uint8_t {
+  HEART_ANALYSING,
+  HEART_NO_FINGER,
+  HEART_CALCULATING,
+  HEART_CRITICAL_LOW,
+  HEART_LOW,
+  HEART_NORMAL,
+  HEART_ELEVATED,
+  HEART_CRITICAL_HIGH
+};
+
+// Display text for each HeartStatus (no String allocation)
+constexpr const char *HEART_STATUS_TEXT[] = {
+  "ANALYSING",
+  "NO FINGER",
+  "CALCULATING",
+  "CRITICAL LOW",
+  "LOW (Warning)",
+  "NORMAL",
+  "ELEVATED",
+  "CRITICAL HIGH"
+};
+
+inline const char *heartStatusText(HeartStatus status) {
+  return HEART_STATUS_TEXT[status];
+}
+
 struct HeartData {
   long irValue;
+  bool fingerPresent; // PPGBeatDetector's DC level check (with hysteresis)
   float currentBpm; 
   float avgBpm;     
   float threeMinAvg; 
-  String status;    
+  HeartStatus status;    
   int alertLevel;   
+  int spo2;          // Percent, 0 = not available
+  int signalQuality; // 0..100
+};
+
+// One timestamped FIFO sample (time is derived from the sensor sample clock)
+struct PPGSample {
+  uint32_t red;
+  uint32_t ir;
+  uint32_t timeMs;
 };
 
 class HartRate {
 private:
     MAX30105 particleSensor;
+    I2CBus *bus = nullptr;
+    uint8_t busDevice = 0;
+
+    // FIFO Acquisition
+    uint8_t fifoBytes[MAX30102_FIFO_DEPTH * PPG_BYTES_PER_SAMPLE];
+    RingBuffer<PPGSample, PPG_RING_SIZE> ppgRing;
+    uint16_t sampleRate = 100;    // Effective samples per second
+    uint32_t sampleIndex = 0;     // Samples produced by the sensor since begin()
+    uint32_t fifoOverflows = 0;   // Samples the sensor discarded (FIFO full)
+    long lastIrValue = 0;
+
+    // Oxygen Saturation
+    SpO2Estimator spo2;
     
-    // Beat Detection
-    long lastBeat = 0;
+    // Beat Detection (one block = everything drained since the last update)
+    PPGBeatDetector detector;
+    uint32_t blockRed[PPG_RING_SIZE];
+    uint32_t blockIr[PPG_RING_SIZE];
+    uint32_t blockTime[PPG_RING_SIZE];
+    uint16_t blockCount = 0;      // Samples in the last block
+    PPGBeat beats[PPG_MAX_BEATS];
     float bpm = 0;
     float avgBpm = 0;
-    byte rates[RATE_SIZE];
-    byte rateSpot = 0;
     
-    // 3-Minute Average Logic
-    float sumBpm3Min = 0;
-    int countBpm3Min = 0;
-    unsigned long periodStartTime = 0;
-    float finalThreeMinAvg = 0;
+    // Rolling BPM statistics (avg BPM x10 per beat, sample-clock time)
+    RollingStats bpmWindows[BPM_WINDOW_COUNT];
     
-    // Timers
-    unsigned long startTime = 0;
     bool isStabilized = false;
 
 public:
-    void begin() {
+    // rate: effective FIFO sample rate in Hz (100, 200 or 400)
+    void begin(I2CBus &i2c, uint16_t rate = 100) {
         // NOTE: Wire.begin() should happen in Main Setup, not here, to avoid conflicts.
-        // If you haven't initialized Wire in main, uncomment the next line:
-        // Wire.begin(); 
+        bus = &i2c;
+        busDevice = bus->addDevice(MAX30102_ADDR, MAX30102_I2C_CLOCK, "max30102");
+        I2CBusLock guard(*bus, busDevice); // Configuration goes through the SparkFun driver
 
         if (!particleSensor.begin(Wire, I2C_SPEED_FAST)) { // Use FAST (400kHz) for better data
             Serial.println("❌ MAX30102 NOT FOUND");
         }
 
-        // Setup sensor for high sensitivity
-        particleSensor.setup(); 
-        particleSensor.setPulseAmplitudeRed(0x0A); // Low Red (visual)
+        // The sensor always converts at 400 sps / 411 us (18-bit); on-chip
+        // averaging brings it down to the requested rate so the IR scale
+        // (and the 50,000 finger threshold) is the same at every rate.
+        byte sampleAverage = 4;
+        if (rate == 200) sampleAverage = 2;
+        else if (rate == 400) sampleAverage = 1;
+        else rate = 100;
+        sampleRate = rate;
+
+        // Red + IR only (ledMode 2), FIFO rollover enabled by setup()
+        // Red stays at the same drive as IR: SpO2 needs a usable red signal
+        particleSensor.setup(0x1F, sampleAverage, 2, 400, 411, 4096);
         particleSensor.setPulseAmplitudeGreen(0);  // Turn off Green
+        particleSensor.clearFIFO();
+
+        ppgRing.clear();
+        sampleIndex = 0;
+        fifoOverflows = 0;
+        detector.begin(sampleRate);
+        spo2.begin(sampleRate);
         
-        startTime = millis();
-        periodStartTime = millis();
+        bpmWindows[BPM_WINDOW_10S].begin(10000);
+        bpmWindows[BPM_WINDOW_1MIN].begin(60000);
+        bpmWindows[BPM_WINDOW_3MIN].begin(180000);
+        bpmWindows[BPM_WINDOW_15MIN].begin(900000);
     }
 
-    HeartData update() {
-        HeartData data;
-        long irValue = particleSensor.getIR();
+    // Drain every pending FIFO sample into the ring buffer.
+    // Pointer registers are read in one 3-byte burst, then all pending
+    // sample data in one bus transaction (split by the bus as needed).
+    // Returns samples read.
+    uint8_t drainFifo() {
+        // FIFO_WR_PTR (0x04), OVF_COUNTER (0x05), FIFO_RD_PTR (0x06)
+        uint8_t ptrs[3];
+        if (bus->readRegisters(busDevice, MAX30102_FIFO_WR_PTR, ptrs, sizeof(ptrs), I2C_PRIO_SENSOR) != I2C_OK) return 0;
+        uint8_t writePtr = ptrs[0] & 0x1F;
+        uint8_t overflow = ptrs[1] & 0x1F;
+        uint8_t readPtr = ptrs[2] & 0x1F;
+
+        uint8_t pending = (writePtr - readPtr) & 0x1F;
+        if (pending == 0 && overflow > 0) pending = MAX30102_FIFO_DEPTH;
+
+        // Lost samples still advance the sample clock so timestamps stay exact
+        fifoOverflows += overflow;
+        sampleIndex += overflow;
+        if (pending == 0) return 0;
+
+        // FIFO_DATA does not auto-increment, so one long read streams samples
+        uint16_t bytes = pending * PPG_BYTES_PER_SAMPLE;
+        if (bus->readRegisters(busDevice, MAX30102_FIFO_DATA, fifoBytes, bytes, I2C_PRIO_SENSOR) != I2C_OK) return 0;
+
+        const uint8_t *p = fifoBytes;
+        for (uint8_t i = 0; i < pending; i++, p += PPG_BYTES_PER_SAMPLE) {
+            PPGSample s;
+            s.red = sample18(p);
+            s.ir = sample18(p + 3);
+            s.timeMs = sampleClockMs();
+            sampleIndex++;
+            ppgRing.push(s);
+        }
+        return pending;
+    }
+
+    // Fills the caller's snapshot in place (no copies of the struct per loop)
+    void update(HeartData &data) {
+
+        // Acquire everything the sensor produced since the last call,
+        // then process the whole block at the sensor's own sample rate.
+        drainFifo();
+        processBlock();
+
+        uint32_t now = sampleClockMs();
+        for (uint8_t w = 0; w < BPM_WINDOW_COUNT; w++) bpmWindows[w].advance(now);
+        const RollingStats &longWindow = bpmWindows[BPM_WINDOW_3MIN];
+        const RollingStats &shortWindow = bpmWindows[BPM_WINDOW_10S];
+        float longAvg = longWindow.getMean() / 10.0f;
         
-        data.irValue = irValue;
+        data.irValue = lastIrValue;
+        data.fingerPresent = detector.isFingerPresent();
         data.currentBpm = bpm;
         data.avgBpm = avgBpm;
         
         // Default safe values
-        data.threeMinAvg = (finalThreeMinAvg > 0) ? finalThreeMinAvg : avgBpm; 
+        data.threeMinAvg = (longAvg > 0) ? longAvg : avgBpm; 
         data.alertLevel = 0;
-        data.status = "ANALYSING"; // Default state
+        data.status = HEART_ANALYSING; // Default state
+        data.spo2 = spo2.getSpO2();
+        data.signalQuality = spo2.getSignalQuality();
 
-        // 1. Check for Finger (Threshold = 50,000)
-        if (irValue < 50000) { 
-            avgBpm = 0;
-            bpm = 0;
-            rateSpot = 0; // Reset smoother
-            data.status = "NO FINGER";
+        // 1. Check for Finger (DC level with hysteresis, see PPGBeatDetector)
+        if (!detector.isFingerPresent()) {
+            data.status = HEART_NO_FINGER;
             data.alertLevel = 0; // Ensure no alert triggers when finger is removed
-            return data;
+            return;
         }
 
-        // 2. Detect Beat
-        if (checkForBeat(irValue)) {
-            long delta = millis() - lastBeat;
-            lastBeat = millis();
-
-            // Filter Noise: Beats must be between 30 and 220 BPM
-            if (delta > 250 && delta < 2000) { 
-                bpm = 60000.0 / delta;
-                
-                // Fill buffer for smoothing
-                rates[rateSpot++] = (byte)bpm;
-                rateSpot %= RATE_SIZE;
-                
-                // Calculate Immediate Average
-                avgBpm = 0;
-                for (byte x = 0; x < RATE_SIZE; x++) avgBpm += rates[x];
-                avgBpm /= RATE_SIZE;
-
-                // --- 3-MINUTE ACCUMULATION ---
-                // Wait 10 seconds (not 1 min) for signal to settle
-                if (millis() - startTime > 10000) {
-                    sumBpm3Min += avgBpm;
-                    countBpm3Min++;
-                }
-            }
+        // 3. Decide which number to use for Status
+        // Grade the rolling 3-minute mean (current average until it has data)
+        float valToGrade = (longAvg > 0) ? longAvg : avgBpm;
+
+        // Only evaluate if we actually have a valid number
+        if (valToGrade > 10) {
+            evaluateStatus(data, valToGrade);
         }
 
-        // 3. Process 3-Minute Cycle
-        if (millis() - periodStartTime > 180000) { // 3 mins passed
-             if (countBpm3Min > 0) {
-                 finalThreeMinAvg = sumBpm3Min / countBpm3Min;
-             }
-             // Reset
-             sumBpm3Min = 0; 
-             countBpm3Min = 0;
-             periodStartTime = millis();
+        // 4. Fast path: a critical 10-second mean alerts without waiting
+        // for the 3-minute mean to catch up
+        if (data.alertLevel < 2 && shortWindow.getCount() >= BPM_MIN_BEATS_SHORT) {
+            HeartData quick = data;
+            evaluateStatus(quick, shortWindow.getMean() / 10.0f);
+            if (quick.alertLevel == 2) data = quick;
         }
+    }
 
-        // 4. Decide which number to use for Status
-        // If we have a long-term average, use it. If not, use the current average.
-        float valToGrade = (finalThreeMinAvg > 0) ? finalThreeMinAvg : avgBpm;
+    // Rolling statistics for one window (values are BPM x10)
+    const RollingStats &getBpmStats(BpmWindow window) {
+        return bpmWindows[window];
+    }
 
-        // Only evaluate if we actually have a valid number
-        if (valToGrade > 10) {
-            evaluateStatus(data, valToGrade);
+    // --- ACQUISITION STATS ---
+    uint16_t getSampleRate() { return sampleRate; }
+    uint32_t getSampleCount() { return sampleIndex; }
+    uint32_t getOverflowCount() { return fifoOverflows; }          // Lost in the sensor FIFO
+    uint32_t getDroppedCount() { return ppgRing.getDropped(); }    // Lost in the ring buffer
+    uint32_t getLostSamples() { return fifoOverflows + ppgRing.getDropped(); }
+
+    // Raw samples processed by the last update() (valid until the next one)
+    uint16_t getLastBlock(const uint32_t *&red, const uint32_t *&ir) {
+        red = blockRed;
+        ir = blockIr;
+        return blockCount;
+    }
+
+  private:
+    // Time of the newest sample on the sensor clock
+    uint32_t sampleClockMs() {
+        return (uint32_t)((uint64_t)sampleIndex * 1000 / sampleRate);
+    }
+
+    // 18-bit sample, MSB first
+    static uint32_t sample18(const uint8_t *p) {
+        uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+        return v & 0x3FFFF;
+    }
+
+    // Move the ring contents into one block and run the detectors over it
+    void processBlock() {
+        uint16_t count = 0;
+        PPGSample sample;
+        while (count < PPG_RING_SIZE && ppgRing.pop(sample)) {
+            blockRed[count] = sample.red;
+            blockIr[count] = sample.ir;
+            blockTime[count] = sample.timeMs;
+            count++;
+        }
+        blockCount = count;
+        if (count == 0) return;
+        lastIrValue = blockIr[count - 1];
+
+        // 2. Detect Beats (intervals come from the sample clock, not millis())
+        uint8_t beatCount = detector.process(blockIr, blockTime, count, beats, PPG_MAX_BEATS);
+
+        if (!detector.isFingerPresent()) {
+            avgBpm = 0;
+            bpm = 0;
+            spo2.reset();
+            return;
         }
 
-        return data;
+        // SpO2 sees every sample; each beat closes its AC window
+        uint8_t b = 0;
+        for (uint16_t n = 0; n < count; n++) {
+            spo2.addSample(blockRed[n], blockIr[n]);
+            while (b < beatCount && beats[b].index == n) {
+                if (beats[b].ibiMs > 0) onBeat(beats[b]);
+                b++;
+            }
+        }
+    }
+
+    void onBeat(const PPGBeat &beat) {
+        spo2.onBeat();
+        bpm = (600000UL / beat.ibiMs) / 10.0f;
+        avgBpm = detector.getAvgBpmX10() / 10.0f;
+
+        // --- ROLLING WINDOWS ---
+        // Wait 10 seconds (not 1 min) for signal to settle, on the same
+        // sample clock as the beat times (a stalled loop does not shorten it)
+        if (beat.timeMs > BPM_SETTLE_MS) {
+            int32_t value = detector.getAvgBpmX10();
+            for (uint8_t w = 0; w < BPM_WINDOW_COUNT; w++) bpmWindows[w].add(value, beat.timeMs);
+        }
     }
 
+  public:
     // Logic from your specific table
     void evaluateStatus(HeartData &data, float avg) {
         data.threeMinAvg = avg;
 
         // SAFETY: Ignore impossibly low readings (Sensor noise often reads as < 10)
         if (avg < 30) {
-            data.status = "CALCULATING"; // Don't alert yet
+            data.status = HEART_CALCULATING; // Don't alert yet
             data.alertLevel = 0;
             return; 
         }
 
         if (avg < 40) {
-            data.status = "CRITICAL LOW";
+            data.status = HEART_CRITICAL_LOW;
             data.alertLevel = 2; 
         }
-        else if (avg >= 40 && avg <= 49) {
-            data.status = "LOW (Warning)";
+        // Contiguous bands: the means are fractional (e.g. 49.5, 90.5)
+        else if (avg < 50) {
+            data.status = HEART_LOW;
             data.alertLevel = 1; 
         }
-        else if (avg >= 50 && avg <= 90) {
-            data.status = "NORMAL";
+        else if (avg <= 90) {
+            data.status = HEART_NORMAL;
             data.alertLevel = 0; 
         }
-        else if (avg >= 91 && avg <= 109) {
-            data.status = "ELEVATED";
+        else if (avg < 110) {
+            data.status = HEART_ELEVATED;
             data.alertLevel = 1; 
         }
-        else if (avg >= 110) {
-            data.status = "CRITICAL HIGH";
+        else {
+            data.status = HEART_CRITICAL_HIGH;
             data.alertLevel = 2; 
         }
     }
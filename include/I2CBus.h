@@ -0,0 +1,323 @@
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+/*
+  I2CBus
+  ------
+  One owner for the shared Wire bus (OLED, MAX30102, MPU6050, BMP280, DS3231).
+  - A bus task runs queued transactions in priority order: sensor FIFO
+    drains go ahead of normal register traffic, which goes ahead of OLED
+    page writes (a long flush yields to a sensor read between pages)
+  - Transactions are asynchronous: submit() returns immediately, the caller
+    blocks in wait() on a task notification (no spinning) or batches
+    several submits and waits once
+  - Each device runs at its own clock; the bus only reprograms the clock
+    when the next device differs
+  - Devices driven through a library (Adafruit, SparkFun, RTClib) take the
+    same bus lock with I2CBusLock around their calls
+  - Per-device bus time, bytes, errors and queue latency are accounted
+    (under statsLock: the bus task writes them, loop reads them)
+  - Without the bus task (creation failed) submit() runs the transaction
+    inline on the caller, under the same bus lock
+*/
+
+#define I2C_BUS_MAX_DEVICES 8
+#define I2C_BUS_QUEUE_DEPTH 16     // Pending transactions per priority
+#define I2C_BUS_TASK_CORE 0
+#define I2C_BUS_TASK_PRIORITY 4    // Below ECG acquisition, above the OLED flush
+
+#define I2C_OK 0
+#define I2C_ERR_NACK 2             // Wire endTransmission / requestFrom failure
+#define I2C_ERR_QUEUE_FULL 10
+#define I2C_ERR_NO_DEVICE 12
+#define I2C_PENDING -1
+
+enum I2CPriority : uint8_t {
+    I2C_PRIO_SENSOR,   // FIFO drains, time-critical reads
+    I2C_PRIO_NORMAL,   // Configuration, slow sensors
+    I2C_PRIO_DISPLAY,  // OLED pages
+    I2C_PRIO_COUNT
+};
+
+// One write (optional register / control byte + data) followed by an
+// optional read. Must stay alive until wait() returns.
+struct I2CTransaction {
+    uint8_t device = 0;
+    bool hasReg = false;
+    uint8_t reg = 0;            // Register address or control byte
+    const uint8_t *tx = nullptr;
+    uint16_t txLen = 0;
+    uint8_t *rx = nullptr;
+    uint16_t rxLen = 0;         // Split into Wire-sized reads by the bus
+
+    // Filled in by the bus
+    TaskHandle_t waiter = nullptr;
+    uint32_t queuedMicros = 0;
+    volatile int8_t result = I2C_PENDING;
+};
+
+class I2CBus {
+  private:
+    struct Device {
+        uint8_t address;
+        uint32_t clockHz;
+        const char *name;
+        // Accounting
+        uint32_t transactions;
+        uint32_t errors;
+        uint32_t bytes;
+        uint64_t busMicros;        // Time holding the bus
+        uint64_t latencyMicros;    // Time queued before starting
+        uint32_t maxLatencyMicros;
+    };
+
+    Device devices[I2C_BUS_MAX_DEVICES];
+    uint8_t deviceCount = 0;
+
+    QueueHandle_t queues[I2C_PRIO_COUNT] = {};
+    SemaphoreHandle_t busLock = nullptr;   // Recursive: held per transaction / library call
+    TaskHandle_t task = nullptr;
+    uint32_t currentClock = 0;             // 0 = unknown (a library changed it)
+    portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+
+    // Library access (outermost lock() / unlock() pair is accounted)
+    uint8_t lockDepth = 0;
+    uint8_t lockDevice = 0;
+    uint32_t lockStart = 0;
+
+    // Consistent copy of a device's counters (the 64-bit sums tear otherwise)
+    Device readStat(uint8_t device) {
+        portENTER_CRITICAL(&statsLock);
+        Device dev = devices[device];
+        portEXIT_CRITICAL(&statsLock);
+        return dev;
+    }
+
+    void applyClock(uint8_t device) {
+        uint32_t clock = devices[device].clockHz;
+        if (clock != currentClock) {
+            Wire.setClock(clock);
+            currentClock = clock;
+        }
+    }
+
+    int8_t execute(I2CTransaction &t) {
+        const Device &dev = devices[t.device];
+
+        // Write phase (register / control byte + data)
+        if (t.hasReg || t.txLen > 0) {
+            Wire.beginTransmission(dev.address);
+            if (t.hasReg) Wire.write(t.reg);
+            if (t.txLen > 0) Wire.write(t.tx, t.txLen);
+            // Repeated start when a read follows
+            if (Wire.endTransmission(t.rxLen == 0) != 0) return I2C_ERR_NACK;
+        }
+
+        // Read phase, in Wire-buffer sized pieces
+        uint16_t done = 0;
+        while (done < t.rxLen) {
+            uint16_t chunk = t.rxLen - done;
+            if (chunk > I2C_BUFFER_LENGTH) chunk = I2C_BUFFER_LENGTH;
+            if (Wire.requestFrom(dev.address, (uint8_t)chunk) != chunk) return I2C_ERR_NACK;
+            for (uint16_t i = 0; i < chunk; i++) t.rx[done + i] = Wire.read();
+            done += chunk;
+        }
+        return I2C_OK;
+    }
+
+    void runOne(I2CTransaction &t) {
+        Device &dev = devices[t.device];
+        uint32_t start = micros();
+        uint32_t latency = start - t.queuedMicros;
+
+        xSemaphoreTakeRecursive(busLock, portMAX_DELAY);
+        applyClock(t.device);
+        int8_t result = execute(t);
+        xSemaphoreGiveRecursive(busLock);
+
+        uint32_t busy = micros() - start;
+        portENTER_CRITICAL(&statsLock);
+        dev.transactions++;
+        dev.bytes += (t.hasReg ? 1 : 0) + t.txLen + t.rxLen;
+        dev.busMicros += busy;
+        dev.latencyMicros += latency;
+        if (latency > dev.maxLatencyMicros) dev.maxLatencyMicros = latency;
+        if (result != I2C_OK) dev.errors++;
+        portEXIT_CRITICAL(&statsLock);
+
+        TaskHandle_t waiter = t.waiter;
+        __atomic_store_n(&t.result, result, __ATOMIC_RELEASE); // 't' may be gone after this
+        if (waiter) xTaskNotifyGive(waiter);
+    }
+
+    // Highest-priority pending transaction, or nullptr
+    I2CTransaction *next() {
+        I2CTransaction *t = nullptr;
+        for (uint8_t p = 0; p < I2C_PRIO_COUNT; p++) {
+            if (xQueueReceive(queues[p], &t, 0) == pdTRUE) return t;
+        }
+        return nullptr;
+    }
+
+    static void taskEntry(void *arg) {
+        I2CBus *self = (I2CBus *)arg;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            // One transaction at a time, re-checking priorities after each
+            I2CTransaction *t;
+            while ((t = self->next()) != nullptr) self->runOne(*t);
+        }
+    }
+
+  public:
+    // Call after Wire.begin(sda, scl). False only without the bus lock (the
+    // bus is unusable); a missing task or queue falls back to inline runs
+    bool begin() {
+        busLock = xSemaphoreCreateRecursiveMutex();
+        if (!busLock) return false;
+        bool queued = true;
+        for (uint8_t p = 0; p < I2C_PRIO_COUNT; p++) {
+            queues[p] = xQueueCreate(I2C_BUS_QUEUE_DEPTH, sizeof(I2CTransaction *));
+            if (!queues[p]) queued = false;
+        }
+        if (!queued || xTaskCreatePinnedToCore(taskEntry, "i2c_bus", 3072, this, I2C_BUS_TASK_PRIORITY,
+                                               &task, I2C_BUS_TASK_CORE) != pdPASS) {
+            task = nullptr;
+            Serial.println("⚠️ I2C bus task failed, transactions run inline");
+        }
+        return true;
+    }
+
+    bool isTaskActive() { return task != nullptr; }
+
+    // Register a device; returns its handle (or -1 if the table is full)
+    int8_t addDevice(uint8_t address, uint32_t clockHz, const char *name) {
+        if (deviceCount >= I2C_BUS_MAX_DEVICES) return -1;
+        Device &dev = devices[deviceCount];
+        memset(&dev, 0, sizeof(dev));
+        dev.address = address;
+        dev.clockHz = clockHz;
+        dev.name = name;
+        return deviceCount++;
+    }
+
+    // --- ASYNC API ---
+
+    // Queue a transaction; completion is signalled to the calling task
+    bool submit(I2CTransaction &t, I2CPriority priority) {
+        if (t.device >= deviceCount) {
+            t.result = I2C_ERR_NO_DEVICE;
+            return false;
+        }
+        t.queuedMicros = micros();
+        t.result = I2C_PENDING;
+        if (!task) {
+            // No bus task: run it now, wait() returns at once
+            t.waiter = nullptr;
+            runOne(t);
+            return true;
+        }
+        t.waiter = xTaskGetCurrentTaskHandle();
+        I2CTransaction *ptr = &t;
+        if (xQueueSend(queues[priority], &ptr, 0) != pdTRUE) {
+            t.result = I2C_ERR_QUEUE_FULL;
+            return false;
+        }
+        xTaskNotifyGive(task);
+        return true;
+    }
+
+    // Block (on a task notification) until 't' has completed. There is no
+    // give-up path: the bus still owns 't' until it completes, and Wire's own
+    // timeout bounds every transaction. The notification may also wake the
+    // task for other reasons, so completion is re-checked each time.
+    int8_t wait(I2CTransaction &t) {
+        while (__atomic_load_n(&t.result, __ATOMIC_ACQUIRE) == I2C_PENDING) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+        }
+        return t.result;
+    }
+
+    // --- SYNC HELPERS (submit + wait) ---
+
+    int8_t readRegisters(uint8_t device, uint8_t reg, uint8_t *buffer, uint16_t length,
+                         I2CPriority priority = I2C_PRIO_NORMAL) {
+        I2CTransaction t;
+        t.device = device;
+        t.hasReg = true;
+        t.reg = reg;
+        t.rx = buffer;
+        t.rxLen = length;
+        if (!submit(t, priority)) return t.result;
+        return wait(t);
+    }
+
+    int8_t writeRegisters(uint8_t device, uint8_t reg, const uint8_t *data, uint16_t length,
+                          I2CPriority priority = I2C_PRIO_NORMAL) {
+        I2CTransaction t;
+        t.device = device;
+        t.hasReg = true;
+        t.reg = reg;
+        t.tx = data;
+        t.txLen = length;
+        if (!submit(t, priority)) return t.result;
+        return wait(t);
+    }
+
+    int8_t writeRegister(uint8_t device, uint8_t reg, uint8_t value,
+                         I2CPriority priority = I2C_PRIO_NORMAL) {
+        return writeRegisters(device, reg, &value, 1, priority);
+    }
+
+    // --- LIBRARY ACCESS ---
+    // Hold the bus (at the device's clock) for a library call
+    void lock(uint8_t device) {
+        xSemaphoreTakeRecursive(busLock, portMAX_DELAY);
+        if (lockDepth++ > 0) return;
+        lockDevice = device;
+        lockStart = micros();
+        if (device < deviceCount) applyClock(device);
+    }
+
+    void unlock() {
+        if (--lockDepth == 0) {
+            currentClock = 0; // The library may have changed it
+            if (lockDevice < deviceCount) {
+                uint32_t busy = micros() - lockStart;
+                portENTER_CRITICAL(&statsLock);
+                devices[lockDevice].transactions++;
+                devices[lockDevice].busMicros += busy;
+                portEXIT_CRITICAL(&statsLock);
+            }
+        }
+        xSemaphoreGiveRecursive(busLock);
+    }
+
+    // --- STATS ---
+    uint8_t getDeviceCount() { return deviceCount; }
+    const char *getName(uint8_t device) { return devices[device].name; }
+    uint32_t getTransactions(uint8_t device) { return readStat(device).transactions; }
+    uint32_t getErrors(uint8_t device) { return readStat(device).errors; }
+    uint32_t getBytes(uint8_t device) { return readStat(device).bytes; }
+    uint32_t getBusMillis(uint8_t device) { return (uint32_t)(readStat(device).busMicros / 1000); }
+    uint32_t getMaxLatencyMicros(uint8_t device) { return readStat(device).maxLatencyMicros; }
+    uint32_t getMeanLatencyMicros(uint8_t device) {
+        Device dev = readStat(device);
+        return dev.transactions ? (uint32_t)(dev.latencyMicros / dev.transactions) : 0;
+    }
+};
+
+// Holds the bus for the lifetime of the guard (library-driven devices)
+class I2CBusLock {
+  private:
+    I2CBus &bus;
+
+  public:
+    I2CBusLock(I2CBus &b, uint8_t device) : bus(b) { bus.lock(device); }
+    ~I2CBusLock() { bus.unlock(); }
+};
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef PPGBEATDETECTOR_H
+#define PPGBEATDETECTOR_H
+
+#include <stdint.h>
+
+/*
+  PPGBeatDetector
+  ---------------
+  Fixed-point pulse detector for the MAX30102 IR channel.
+  - Works on whole blocks (samples + sample-clock timestamps), e.g. one FIFO drain
+  - Band-pass: two integer DC-removal stages (second-order high-pass, so
+    breathing drift larger than the pulse is rejected) + two Q15 one-pole
+    low-pass stages
+  - Adaptive threshold (half the running peak height) with a refractory period
+  - Integer only, no heap, so the same code runs on the host and the ESP32-S3
+*/
+
+#define PPG_REFRACTORY_MS 250   // 240 BPM upper limit
+#define PPG_MAX_IBI_MS 2000     // 30 BPM lower limit
+#define PPG_MIN_THRESHOLD 20    // Noise floor in filtered IR counts
+#define PPG_FINGER_ON 50000     // DC level that means a finger is on the sensor
+#define PPG_FINGER_OFF 40000    // Hysteresis for finger removal
+#define PPG_AVG_SIZE 4          // Intervals in the BPM average
+
+// One detected beat inside a processed block
+struct PPGBeat {
+    uint16_t index;   // Block index of the sample that confirmed the beat
+    uint32_t timeMs;  // Sample-clock time of the pulse peak (may be in an earlier block)
+    uint16_t ibiMs;   // Interval since the previous beat (0 = first beat)
+};
+
+class PPGBeatDetector {
+  private:
+    // Filter configuration (set from the sample rate)
+    uint8_t dcShift = 5;
+    int32_t lpAlpha = 8834; // Q15
+
+    // Filter state
+    int32_t dc = 0;   // Q8
+    int32_t dc2 = 0;  // Q8
+    int32_t lp1 = 0;
+    int32_t lp2 = 0;
+    bool primed = false;
+
+    // Peak tracking
+    int32_t peakAvg = 0;
+    uint8_t peakDecayShift = 8;
+    bool inPulse = false;
+    int32_t pulseMax = 0;
+    uint32_t pulseMaxTime = 0;
+
+    // Beat history
+    uint32_t lastBeatMs = 0;
+    bool haveLastBeat = false;
+    uint16_t intervals[PPG_AVG_SIZE];
+    uint8_t intervalSpot = 0;
+    uint8_t intervalCount = 0;
+    uint16_t lastIbi = 0;
+
+    bool finger = false;
+
+    int32_t q15(int32_t value) {
+        return (int32_t)(((int64_t)value * lpAlpha) >> 15);
+    }
+
+  public:
+    // sampleRate: 100, 200 or 400 Hz (pass band ~0.5-5 Hz at each rate)
+    void begin(uint16_t sampleRate) {
+        if (sampleRate >= 400) {
+            dcShift = 7; lpAlpha = 2474; peakDecayShift = 10;
+        } else if (sampleRate >= 200) {
+            dcShift = 6; lpAlpha = 4765; peakDecayShift = 9;
+        } else {
+            dcShift = 5; lpAlpha = 8834; peakDecayShift = 8;
+        }
+        reset();
+    }
+
+    void reset() {
+        primed = false;
+        lp1 = lp2 = 0;
+        peakAvg = 0;
+        inPulse = false;
+        haveLastBeat = false;
+        intervalSpot = 0;
+        intervalCount = 0;
+        lastIbi = 0;
+    }
+
+    // Process a block. Returns the number of beats written to 'beats'.
+    uint8_t process(const uint32_t *ir, const uint32_t *timeMs, uint16_t count,
+                    PPGBeat *beats, uint8_t maxBeats) {
+        uint8_t found = 0;
+
+        for (uint16_t n = 0; n < count; n++) {
+            int32_t x = (int32_t)ir[n];
+
+            if (!primed) {
+                dc = x << 8;
+                dc2 = 0;
+                primed = true;
+            }
+
+            // 1. Band-pass (high-pass by DC subtraction twice, then 2x low-pass)
+            dc += ((x << 8) - dc) >> dcShift;
+            int32_t hp1 = x - (dc >> 8);
+            dc2 += ((hp1 << 8) - dc2) >> dcShift;
+            int32_t hp = hp1 - (dc2 >> 8);
+            lp1 += q15(hp - lp1);
+            lp2 += q15(lp1 - lp2);
+
+            // 2. Finger presence from the DC level (with hysteresis)
+            int32_t level = dc >> 8;
+            if (finger && level < PPG_FINGER_OFF) {
+                finger = false;
+                reset();
+                primed = true;
+            } else if (!finger && level > PPG_FINGER_ON) {
+                finger = true;
+            }
+            if (!finger) continue;
+
+            // Blood volume rises -> IR falls, so pulses are peaks of -signal
+            int32_t s = -lp2;
+            int32_t threshold = peakAvg >> 1;
+            if (threshold < PPG_MIN_THRESHOLD) threshold = PPG_MIN_THRESHOLD;
+
+            // 3. Peak search above the adaptive threshold
+            if (s > threshold) {
+                if (!inPulse || s > pulseMax) {
+                    pulseMax = s;
+                    pulseMaxTime = timeMs[n];
+                }
+                inPulse = true;
+                continue;
+            }
+
+            // Threshold slowly relaxes between pulses
+            peakAvg -= peakAvg >> peakDecayShift;
+            if (!inPulse) continue;
+            inPulse = false;
+
+            // 4. Pulse finished: refractory and range checks
+            uint32_t ibi = pulseMaxTime - lastBeatMs;
+            if (haveLastBeat && ibi < PPG_REFRACTORY_MS) continue;
+
+            peakAvg += (pulseMax - peakAvg) >> 2;
+            lastBeatMs = pulseMaxTime;
+
+            if (haveLastBeat && ibi < PPG_MAX_IBI_MS) {
+                lastIbi = (uint16_t)ibi;
+                intervals[intervalSpot++] = lastIbi;
+                intervalSpot %= PPG_AVG_SIZE;
+                if (intervalCount < PPG_AVG_SIZE) intervalCount++;
+            } else {
+                ibi = 0;
+            }
+            haveLastBeat = true;
+
+            // The peak may lie in an earlier block; report the confirming
+            // sample so indices stay in [0, count) and in order
+            if (found < maxBeats) {
+                beats[found].index = n;
+                beats[found].timeMs = pulseMaxTime;
+                beats[found].ibiMs = (uint16_t)ibi;
+                found++;
+            }
+        }
+        return found;
+    }
+
+    // --- GETTERS ---
+    bool isFingerPresent() { return finger; }
+
+    // Latest beat-to-beat rate in BPM x10 (integer, 0 = none yet)
+    uint16_t getBpmX10() {
+        return lastIbi ? (uint16_t)(600000UL / lastIbi) : 0;
+    }
+
+    // Rate over the last PPG_AVG_SIZE intervals in BPM x10
+    uint16_t getAvgBpmX10() {
+        if (intervalCount == 0) return 0;
+        uint32_t sum = 0;
+        for (uint8_t i = 0; i < intervalCount; i++) sum += intervals[i];
+        return (uint16_t)(600000UL * intervalCount / sum);
+    }
+};
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef QRSDETECTOR_H
+#define QRSDETECTOR_H
+
+#include <stdint.h>
+
+/*
+  QRSDetector
+  -----------
+  Streaming Pan-Tompkins QRS detector on integer arithmetic.
+  - Band-pass (moving-average low-pass + high-pass), 5-point derivative,
+    squaring and 150 ms moving-window integration (MWI)
+  - Adaptive signal/noise peak levels (SPKI/NPKI) with two thresholds,
+    200 ms refractory period and search-back after 1.66 x mean RR
+  - Processes blocks of samples; beats carry the sample sequence number of
+    the R wave (largest band-passed excursion under the MWI peak) and the
+    RR interval in samples, so timing is exact at the ADC rate
+  - Fixed memory sized for 500 Hz and a constant amount of work per sample
+*/
+
+#define QRS_MAX_RATE 500
+#define QRS_LP_HIST 32    // >= 2 x LP length at 500 Hz
+#define QRS_HP_HIST 128   // >= HP length at 500 Hz
+#define QRS_MWI_HIST 128  // >= 150 ms at 500 Hz
+#define QRS_RR_AVG 8      // RR intervals in the running mean
+#define QRS_LEARN_MS 2000 // Threshold learning phase
+#define QRS_DERIV_MAX 4095 // Derivative clamp before squaring
+
+// One detected QRS complex
+struct QRSBeat {
+    uint32_t seq;        // Sample sequence number of the R wave (delay-compensated)
+    uint16_t rrSamples;  // Interval since the previous QRS (0 = first beat)
+};
+
+class QRSDetector {
+  private:
+    // Configuration (derived from the sample rate)
+    uint16_t fs = 500;
+    uint8_t lpLen = 15;     // Low-pass length (~30 ms)
+    uint8_t lpShift = 8;    // Normalises the LP gain (lpLen^2)
+    uint8_t hpLen = 80;     // High-pass length (~160 ms)
+    uint8_t mwiLen = 75;    // Integration window (150 ms)
+    uint16_t refractory = 100;
+    uint16_t learnSamples = 1000;
+    uint16_t bpDelay = 0;   // Band-pass group delay in samples
+
+    // Filter state
+    int16_t rawHist[QRS_LP_HIST];
+    int32_t lpY1 = 0, lpY2 = 0;
+    int32_t lpHist[QRS_HP_HIST];
+    int32_t hpSum = 0;
+    int32_t derivHist[4];
+    int32_t bpHist[QRS_MWI_HIST]; // Band-passed signal, for locating the R wave
+    uint32_t mwiHist[QRS_MWI_HIST];
+    uint32_t mwiSum = 0;
+    uint32_t n = 0;         // Samples processed since reset
+
+    // Peak detection on the MWI output
+    uint32_t mwiPrev = 0;
+    bool rising = false;
+    uint32_t spki = 0;
+    uint32_t npki = 0;
+    uint32_t learnMax = 0;
+    uint64_t learnSum = 0;
+    bool learning = true;
+
+    // Beat history (lastQrsSeq is the MWI peak, lastRSeq the R wave)
+    bool haveQrs = false;
+    uint32_t lastQrsSeq = 0;
+    uint32_t lastRSeq = 0;
+    uint16_t rrHist[QRS_RR_AVG];
+    uint8_t rrSpot = 0;
+    uint8_t rrCount = 0;
+    uint32_t rrSum = 0;
+
+    // Largest sub-threshold peak since the last QRS (for search-back). Its
+    // R wave is located when it is recorded: by the time search-back fires
+    // (up to 1.66 x RR later) bpHist has been overwritten
+    uint32_t backPeak = 0;
+    uint32_t backSeq = 0;
+    uint32_t backRSeq = 0;
+
+    uint32_t threshold1() { return npki + ((spki - npki) >> 2); }
+
+    uint32_t rrMean() { return rrCount ? rrSum / rrCount : 0; }
+
+    void addRR(uint16_t rr) {
+        if (rrCount == QRS_RR_AVG) rrSum -= rrHist[rrSpot];
+        else rrCount++;
+        rrHist[rrSpot] = rr;
+        rrSum += rr;
+        rrSpot = (rrSpot + 1) % QRS_RR_AVG;
+    }
+
+    // R wave = largest band-passed excursion in the MWI window ending at 'seq'
+    uint32_t locateR(uint32_t seq) {
+        uint32_t best = seq;
+        int32_t bestAbs = -1;
+        for (uint8_t k = 0; k < mwiLen; k++) {
+            int32_t v = bpHist[(seq - k) & (QRS_MWI_HIST - 1)];
+            if (v < 0) v = -v;
+            if (v > bestAbs) {
+                bestAbs = v;
+                best = seq - k;
+            }
+        }
+        return best - bpDelay;
+    }
+
+    // Accept a QRS at MWI peak 'seq' with R wave 'rSeq' (runs once per
+    // beat, not per sample)
+    void acceptQrs(uint32_t peak, uint32_t seq, uint32_t rSeq, bool searchBack,
+                   uint32_t seqBase, QRSBeat *beats, uint8_t &found, uint8_t maxBeats) {
+        if (searchBack) spki = (peak >> 2) + spki - (spki >> 2);
+        else spki = (peak >> 3) + spki - (spki >> 3);
+
+        uint16_t rr = 0;
+        if (haveQrs) {
+            uint32_t gap = rSeq - lastRSeq;
+            rr = (gap > 0xFFFF) ? 0 : (uint16_t)gap;
+            if (rr) addRR(rr);
+        }
+        haveQrs = true;
+        lastQrsSeq = seq;
+        lastRSeq = rSeq;
+        backPeak = 0;
+
+        if (found >= maxBeats) return;
+        beats[found].seq = seqBase + rSeq;
+        beats[found].rrSamples = rr;
+        found++;
+    }
+
+  public:
+    // sampleRate: 250 or 500 Hz
+    void begin(uint16_t sampleRate) {
+        fs = (sampleRate > QRS_MAX_RATE) ? QRS_MAX_RATE : sampleRate;
+        lpLen = (uint8_t)((fs * 30 + 500) / 1000);
+        hpLen = (uint8_t)((fs * 160 + 500) / 1000);
+        mwiLen = (uint8_t)((fs * 150 + 500) / 1000);
+        refractory = (uint16_t)(fs / 5);
+        learnSamples = (uint16_t)((uint32_t)fs * QRS_LEARN_MS / 1000);
+
+        // lpShift ~ log2(lpLen^2)
+        lpShift = 0;
+        while ((1u << (lpShift + 1)) <= (uint32_t)lpLen * lpLen) lpShift++;
+
+        // LP (lpLen - 1) + HP (hpLen / 2)
+        bpDelay = (lpLen - 1) + hpLen / 2;
+        reset();
+    }
+
+    void reset() {
+        for (uint8_t i = 0; i < QRS_LP_HIST; i++) rawHist[i] = 0;
+        for (uint8_t i = 0; i < QRS_HP_HIST; i++) lpHist[i] = 0;
+        for (uint8_t i = 0; i < QRS_MWI_HIST; i++) mwiHist[i] = 0;
+        for (uint8_t i = 0; i < QRS_MWI_HIST; i++) bpHist[i] = 0;
+        for (uint8_t i = 0; i < 4; i++) derivHist[i] = 0;
+        lpY1 = lpY2 = 0;
+        hpSum = 0;
+        mwiSum = 0;
+        n = 0;
+        mwiPrev = 0;
+        rising = false;
+        spki = npki = 0;
+        learnMax = 0;
+        learnSum = 0;
+        learning = true;
+        haveQrs = false;
+        rrSpot = rrCount = 0;
+        rrSum = 0;
+        backPeak = 0;
+    }
+
+    // Process 'count' samples whose first sample has sequence number
+    // 'firstSeq'. Returns the number of beats written to 'beats'.
+    uint8_t process(const int16_t *x, uint16_t count, uint32_t firstSeq,
+                    QRSBeat *beats, uint8_t maxBeats) {
+        uint8_t found = 0;
+        // Internal positions count from reset; map back with this base
+        uint32_t seqBase = firstSeq - n;
+
+        for (uint16_t i = 0; i < count; i++, n++) {
+            // 1. Low-pass: y = 2y1 - y2 + x - 2x[n-L] + x[n-2L]
+            int32_t xn = x[i];
+            int32_t xL = rawHist[(n - lpLen) & (QRS_LP_HIST - 1)];
+            int32_t x2L = rawHist[(n - 2 * lpLen) & (QRS_LP_HIST - 1)];
+            rawHist[n & (QRS_LP_HIST - 1)] = (int16_t)xn;
+            int32_t lp = 2 * lpY1 - lpY2 + xn - 2 * xL + x2L;
+            lpY2 = lpY1;
+            lpY1 = lp;
+            int32_t lpOut = lp >> lpShift;
+
+            // 2. High-pass: delayed sample minus moving average
+            int32_t lpOld = lpHist[(n - hpLen) & (QRS_HP_HIST - 1)];
+            lpHist[n & (QRS_HP_HIST - 1)] = lpOut;
+            hpSum += lpOut - lpOld;
+            int32_t hp = lpHist[(n - hpLen / 2) & (QRS_HP_HIST - 1)] - hpSum / hpLen;
+            bpHist[n & (QRS_MWI_HIST - 1)] = hp;
+
+            // 3. Derivative: (2x[n] + x[n-1] - x[n-3] - 2x[n-4]) / 8
+            int32_t d = (2 * hp + derivHist[0] - derivHist[2] - 2 * derivHist[3]) >> 3;
+            derivHist[3] = derivHist[2];
+            derivHist[2] = derivHist[1];
+            derivHist[1] = derivHist[0];
+            derivHist[0] = hp;
+
+            // 4. Squaring, full resolution (the clamp keeps the window sum
+            // below 2^32: 75 x 4095^2)
+            if (d > QRS_DERIV_MAX) d = QRS_DERIV_MAX;
+            if (d < -QRS_DERIV_MAX) d = -QRS_DERIV_MAX;
+            uint32_t sq = (uint32_t)(d * d);
+
+            // 5. Moving-window integration
+            uint32_t sqOld = mwiHist[(n - mwiLen) & (QRS_MWI_HIST - 1)];
+            mwiHist[n & (QRS_MWI_HIST - 1)] = sq;
+            mwiSum += sq - sqOld;
+            uint32_t mwi = mwiSum / mwiLen;
+
+            // Filters need one full HP window before their output is valid
+            if (n < (uint32_t)hpLen + mwiLen) {
+                mwiPrev = mwi;
+                continue;
+            }
+
+            // 6. Learning phase: initial signal and noise levels
+            if (learning) {
+                if (mwi > learnMax) learnMax = mwi;
+                learnSum += mwi;
+                if (n >= (uint32_t)hpLen + mwiLen + learnSamples) {
+                    spki = learnMax / 3;
+                    npki = (uint32_t)(learnSum / learnSamples) / 2;
+                    learning = false;
+                }
+                mwiPrev = mwi;
+                continue;
+            }
+
+            // 7. Peak = MWI stops rising
+            bool isPeak = rising && mwi < mwiPrev;
+            rising = mwi > mwiPrev || (rising && mwi == mwiPrev);
+            uint32_t peak = mwiPrev;
+            uint32_t peakSeq = n - 1;
+            mwiPrev = mwi;
+
+            if (isPeak) {
+                bool inRefractory = haveQrs && (peakSeq - lastQrsSeq) < refractory;
+                if (!inRefractory && peak > threshold1()) {
+                    acceptQrs(peak, peakSeq, locateR(peakSeq), false, seqBase, beats, found, maxBeats);
+                } else {
+                    npki = (peak >> 3) + npki - (npki >> 3);
+                    if (!inRefractory && peak > backPeak) {
+                        backPeak = peak;
+                        backSeq = peakSeq;
+                        backRSeq = locateR(peakSeq);
+                    }
+                }
+            }
+
+            // 8. Search-back: no QRS for 1.66 x mean RR, take the best
+            // candidate above the lower threshold
+            uint32_t mean = rrMean();
+            if (haveQrs && mean > 0 && (n - lastQrsSeq) > (mean * 166) / 100 &&
+                backPeak > (threshold1() >> 1)) {
+                acceptQrs(backPeak, backSeq, backRSeq, true, seqBase, beats, found, maxBeats);
+            }
+        }
+        return found;
+    }
+
+    // --- GETTERS ---
+    uint16_t getSampleRate() { return fs; }
+    bool isLearning() { return learning; }
+    uint32_t getMeanRRSamples() { return rrMean(); }
+    uint32_t getSignalLevel() { return spki; }
+    uint32_t getNoiseLevel() { return npki; }
+};
+
+#endif
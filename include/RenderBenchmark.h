@@ -0,0 +1,198 @@
+#ifndef RENDERBENCHMARK_H
+#define RENDERBENCHMARK_H
+
+#include <Arduino.h>
+#include "DisplayManager.h"
+
+/*
+  RenderBenchmark
+  ---------------
+  Render cost and golden-frame check for every screen (esp32-s3-renderbench,
+  and the host test in test/test_render).
+  - Each screen and alert animation is rendered into the framebuffer only
+    (no I2C flush) 'frames' times, with sprites and then with the
+    original primitives, and reported as ns/frame and lit pixels
+  - Golden frame: the primitive render is the reference; the sprite render
+    of the same inputs must match it byte for byte. Each frame's hash is
+    kept (getHash()) and printed; the host test asserts them against
+    committed values
+  - runAnimation() does the same check for every frame of an animation
+  - Screens fed from live sensors (ECG trace, weather) can change between
+    the two renders, so a mismatch there is reported but not conclusive
+*/
+
+#define RENDER_BENCH_FRAMES 2000
+#define RENDER_BENCH_CASES 8
+
+class RenderBenchmark {
+  public:
+    enum BenchAnimation { BENCH_SOS, BENCH_FALL, BENCH_HEART };
+
+  private:
+    DisplayManager &dm;
+    uint16_t framesPerCase;
+    uint8_t reference[OLED_BUFFER_BYTES];
+    uint8_t failures = 0;
+
+    const char *caseNames[RENDER_BENCH_CASES];
+    uint32_t caseHashes[RENDER_BENCH_CASES];
+    uint8_t caseCount = 0;
+
+    uint16_t litPixels() {
+        const uint8_t *buffer = dm.display.getBuffer();
+        uint16_t count = 0;
+        for (uint16_t i = 0; i < OLED_BUFFER_BYTES; i++) count += __builtin_popcount(buffer[i]);
+        return count;
+    }
+
+    template <typename RenderFn>
+    uint32_t timeFrames(RenderFn render) {
+        unsigned long start = micros();
+        for (uint16_t i = 0; i < framesPerCase; i++) {
+            dm.governor.invalidate();
+            render();
+        }
+        return (uint32_t)((uint64_t)(micros() - start) * 1000 / framesPerCase);
+    }
+
+    // Primitives first (reference), then sprites; true if they match.
+    // Leaves the sprite render in the framebuffer.
+    template <typename RenderFn>
+    bool golden(RenderFn render) {
+        dm.useSprites = false;
+        dm.governor.invalidate();
+        render();
+        memcpy(reference, dm.display.getBuffer(), OLED_BUFFER_BYTES);
+
+        dm.useSprites = true;
+        dm.governor.invalidate();
+        render();
+        return memcmp(reference, dm.display.getBuffer(), OLED_BUFFER_BYTES) == 0;
+    }
+
+    template <typename RenderFn>
+    void runCase(const char *name, RenderFn render) {
+        bool match = golden(render);
+        if (!match) failures++;
+        uint32_t hash = frameHash(dm.display.getBuffer());
+        uint16_t pixels = litPixels();
+        if (caseCount < RENDER_BENCH_CASES) {
+            caseNames[caseCount] = name;
+            caseHashes[caseCount++] = hash;
+        }
+
+        uint32_t spriteNs = timeFrames(render);
+        dm.useSprites = false;
+        uint32_t primitiveNs = timeFrames(render);
+        dm.useSprites = true;
+
+        Serial.printf("%-8s %8lu ns/frame (primitives %8lu, x%.1f) %4u px  hash %08lx  %s\n",
+                      name, (unsigned long)spriteNs, (unsigned long)primitiveNs,
+                      spriteNs ? (float)primitiveNs / spriteNs : 0.0f, pixels,
+                      (unsigned long)hash, match ? "OK" : "MISMATCH");
+    }
+
+    // One frame of an alert animation, independent of its timing
+    void animationFrame(BenchAnimation anim, int frame, Vibrate &vibrate) {
+        dm.animPhase = DisplayManager::PHASE_RUN;
+        dm.animFrame = frame;
+        switch (anim) {
+        case BENCH_SOS:
+            dm.animation = DisplayManager::ANIM_SOS;
+            dm.stepEmergencyCall(vibrate);
+            break;
+        case BENCH_FALL:
+            dm.animation = DisplayManager::ANIM_FALL;
+            dm.stepFallAlert();
+            break;
+        case BENCH_HEART:
+            dm.animation = DisplayManager::ANIM_HEART;
+            dm.stepHeartAlert(vibrate);
+            break;
+        }
+    }
+
+    void setAlert() {
+        dm.alertStatus = "CRITICAL HIGH";
+        dm.alertBpm = 142;
+        dm.alertLevel = 2;
+    }
+
+    // Back to normal operation
+    void restore() {
+        dm.animation = DisplayManager::ANIM_NONE;
+        dm.setInverted(false);
+        dm.renderOnly = false;
+        dm.clear();
+    }
+
+  public:
+    RenderBenchmark(DisplayManager &display, uint16_t frames = RENDER_BENCH_FRAMES)
+        : dm(display), framesPerCase(frames) {}
+
+    // FNV-1a of a framebuffer (page layout, OLED_BUFFER_BYTES)
+    static uint32_t frameHash(const uint8_t *buffer) {
+        return FrameGovernor::mix(FrameGovernor::start(), buffer, OLED_BUFFER_BYTES);
+    }
+
+    // Frames an animation draws, its final screen included
+    static int animationFrames(BenchAnimation anim) {
+        switch (anim) {
+        case BENCH_SOS:  return DisplayManager::SOS_FRAMES + 1;   // + "CONNECTED"
+        case BENCH_FALL: return DisplayManager::FALL_FRAMES + 1;  // + "SOS SENT!"
+        default:         return DisplayManager::HEART_FRAMES;
+        }
+    }
+
+    // Returns the number of golden-frame mismatches
+    uint8_t run(WeatherManager &weather, ECGManager &ecg, ActivityManager &activity,
+                ActivityClassifier &classifier, Vibrate &vibrate) {
+        HeartData heart = {};
+        heart.irValue = 90000;
+        heart.fingerPresent = true;
+        heart.currentBpm = 72;
+        heart.avgBpm = 71;
+        heart.spo2 = 98;
+
+        Serial.println("--- RENDER BENCHMARK ---");
+        dm.renderOnly = true;
+        failures = 0;
+        caseCount = 0;
+
+        runCase("start", [&]() { dm.showStartScreen("17/10/2026", "12:05 PM"); });
+        runCase("heart", [&]() { dm.showHeartRateScreen(heart); });
+        runCase("weather", [&]() { dm.showWeatherScreen(weather); });
+        runCase("ecg", [&]() { dm.showECGScreen(ecg); });
+        runCase("steps", [&]() { dm.showStepsScreen(activity, classifier); });
+
+        setAlert();
+        runCase("sos", [&]() { animationFrame(BENCH_SOS, 7, vibrate); });
+        runCase("fall", [&]() { animationFrame(BENCH_FALL, 7, vibrate); });
+        runCase("alert", [&]() { animationFrame(BENCH_HEART, 7, vibrate); });
+
+        restore();
+        Serial.printf("--- %u golden mismatches ---\n", failures);
+        return failures;
+    }
+
+    // Golden check of every frame of one animation (heart alert: level 2).
+    // Fills hashes[0 .. animationFrames(anim)), returns the mismatches.
+    uint8_t runAnimation(BenchAnimation anim, Vibrate &vibrate, uint32_t *hashes) {
+        dm.renderOnly = true;
+        setAlert();
+        uint8_t mismatches = 0;
+        for (int i = 0; i < animationFrames(anim); i++) {
+            if (!golden([&]() { animationFrame(anim, i, vibrate); })) mismatches++;
+            hashes[i] = frameHash(dm.display.getBuffer());
+        }
+        restore();
+        return mismatches;
+    }
+
+    // --- RESULTS OF run() ---
+    uint8_t getCaseCount() { return caseCount; }
+    const char *getCaseName(uint8_t i) { return caseNames[i]; }
+    uint32_t getHash(uint8_t i) { return caseHashes[i]; }
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+  RingBuffer
+  ----------
+  Fixed-capacity FIFO used by the sensor acquisition paths.
+  - No heap: storage is a member array sized at compile time
+  - When full, push() overwrites the oldest entry and counts it as dropped
+  - Single producer / single consumer on the same task (not ISR safe)
+*/
+
+template <typename T, size_t N>
+class RingBuffer {
+  private:
+    T items[N];
+    size_t head = 0;   // Next write position
+    size_t count = 0;  // Entries currently stored
+    uint32_t dropped = 0;
+
+  public:
+    // Add one entry (overwrites oldest when full)
+    void push(const T &item) {
+        items[head] = item;
+        head = (head + 1) % N;
+        if (count < N) {
+            count++;
+        } else {
+            dropped++;
+        }
+    }
+
+    // Remove the oldest entry. Returns false if empty.
+    bool pop(T &out) {
+        if (count == 0) return false;
+        out = items[(head + N - count) % N];
+        count--;
+        return true;
+    }
+
+    // Read entry i (0 = oldest) without removing it
+    const T &peek(size_t i) const {
+        return items[(head + N - count + i) % N];
+    }
+
+    size_t size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    bool isFull() const { return count == N; }
+    static constexpr size_t capacity() { return N; }
+
+    uint32_t getDropped() const { return dropped; }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef ROLLINGSTATS_H
+#define ROLLINGSTATS_H
+
+#include <stdint.h>
+#include <math.h>
+
+/*
+  RollingStats
+  ------------
+  Sliding-window statistics built from time buckets (no raw samples kept).
+  - The window is split into ROLLING_BUCKETS buckets of count/sum/sumSq/min/max
+  - add() and expiry are O(1); mean/variance use running totals
+  - min/max scan the fixed bucket array (constant cost, 12 entries)
+  - Values are integers (e.g. BPM x10) so the totals stay exact
+*/
+
+#define ROLLING_BUCKETS 12
+
+class RollingStats {
+  private:
+    struct Bucket {
+        uint32_t id;      // Absolute bucket number (time / bucketMs)
+        uint16_t count;
+        int32_t sum;
+        int64_t sumSq;
+        int32_t min;
+        int32_t max;
+    };
+
+    Bucket buckets[ROLLING_BUCKETS];
+    uint32_t bucketMs = 1000;
+    uint32_t currentId = 0;
+
+    // Running totals over all live buckets
+    uint32_t totalCount = 0;
+    int64_t totalSum = 0;
+    int64_t totalSumSq = 0;
+
+    void evict(Bucket &b) {
+        totalCount -= b.count;
+        totalSum -= b.sum;
+        totalSumSq -= b.sumSq;
+        b.count = 0;
+        b.sum = 0;
+        b.sumSq = 0;
+    }
+
+  public:
+    // windowMs: total window length (split evenly into buckets)
+    void begin(uint32_t windowMs) {
+        bucketMs = windowMs / ROLLING_BUCKETS;
+        if (bucketMs == 0) bucketMs = 1;
+        for (uint8_t i = 0; i < ROLLING_BUCKETS; i++) {
+            buckets[i].id = 0;
+            buckets[i].count = 0;
+            buckets[i].sum = 0;
+            buckets[i].sumSq = 0;
+        }
+        currentId = 0;
+        totalCount = 0;
+        totalSum = 0;
+        totalSumSq = 0;
+    }
+
+    // Expire buckets that have slid out of the window at time 'nowMs'
+    void advance(uint32_t nowMs) {
+        uint32_t id = nowMs / bucketMs;
+        if (id <= currentId) return;
+
+        // At most ROLLING_BUCKETS slots can expire, however long the gap
+        uint32_t steps = id - currentId;
+        if (steps > ROLLING_BUCKETS) steps = ROLLING_BUCKETS;
+        for (uint32_t s = 1; s <= steps; s++) {
+            Bucket &b = buckets[(id - steps + s) % ROLLING_BUCKETS];
+            evict(b);
+            b.id = id - steps + s;
+        }
+        currentId = id;
+    }
+
+    void add(int32_t value, uint32_t nowMs) {
+        advance(nowMs);
+        Bucket &b = buckets[currentId % ROLLING_BUCKETS];
+        if (b.count == 0 || value < b.min) b.min = value;
+        if (b.count == 0 || value > b.max) b.max = value;
+        b.count++;
+        b.sum += value;
+        b.sumSq += (int64_t)value * value;
+
+        totalCount++;
+        totalSum += value;
+        totalSumSq += (int64_t)value * value;
+    }
+
+    // --- QUERIES (call advance() first to expire old data) ---
+    uint32_t getCount() const { return totalCount; }
+
+    float getMean() const {
+        return totalCount ? (float)totalSum / totalCount : 0;
+    }
+
+    float getVariance() const {
+        if (totalCount < 2) return 0;
+        float m = getMean();
+        float v = (float)totalSumSq / totalCount - m * m;
+        return (v > 0) ? v : 0;
+    }
+
+    float getStdDev() const {
+        return sqrtf(getVariance());
+    }
+
+    int32_t getMin() const {
+        int32_t result = 0;
+        bool found = false;
+        for (uint8_t i = 0; i < ROLLING_BUCKETS; i++) {
+            if (buckets[i].count && (!found || buckets[i].min < result)) {
+                result = buckets[i].min;
+                found = true;
+            }
+        }
+        return result;
+    }
+
+    int32_t getMax() const {
+        int32_t result = 0;
+        bool found = false;
+        for (uint8_t i = 0; i < ROLLING_BUCKETS; i++) {
+            if (buckets[i].count && (!found || buckets[i].max > result)) {
+                result = buckets[i].max;
+                found = true;
+            }
+        }
+        return result;
+    }
+};
+
+#endif
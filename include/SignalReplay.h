@@ -0,0 +1,408 @@
+#ifndef SIGNALREPLAY_H
+#define SIGNALREPLAY_H
+
+#include <Arduino.h>
+#include <math.h>
+#include <heartRate.h>
+#include "PPGBeatDetector.h"
+#include "QRSDetector.h"
+#include "EpisodeRecorder.h"
+
+/*
+  SignalReplay
+  ------------
+  Replays PPG and ECG data through the beat detectors (esp32-s3-signalreplay).
+  - Synthetic PPG cases with known pulse times (rest, exercise, low and
+    high perfusion, baseline drift, noise) go through PPGBeatDetector in
+    the 1-3 sample blocks of a FIFO drain, and through the path it replaced:
+    SparkFun checkForBeat, 60000 / delta and the 4-entry average
+  - Synthetic ECG cases with known R waves (rest, exercise, baseline
+    wander, low amplitude, muscle noise) go through QRSDetector and the
+    fixed threshold it replaced (raw > 2800, 300 ms lockout)
+  - Each case reports sensitivity, PPV and ns/sample for the new and the
+    old path; the new detectors must reach SIGNAL_REPLAY_PASS % on both.
+    A pulse is matched from P/4 before to 3P/4 after its peak (P = pulse
+    period, any point of the pulse is a valid detection), an R wave within
+    75 ms (the EC57 150 ms window)
+  - Every recorded episode on LittleFS is replayed as well. Recordings
+    carry no annotations, so the two channels are scored against each
+    other: each pulse should follow an R wave by 100-600 ms (pulse arrival).
+    The old QRS path is scored against the new pulses, the old PPG path
+    against the new R waves
+  - checkForBeat keeps its state inside the library and cannot be reset;
+    its first beats of each case fall in the unscored warm-up
+*/
+
+#define SIGNAL_REPLAY_SECONDS 20
+#define SIGNAL_REPLAY_WARMUP_MS 4000     // Filters and thresholds settle; not scored
+#define SIGNAL_REPLAY_PASS 95            // % sensitivity and PPV for the new detectors
+#define SIGNAL_REPLAY_MAX_BEATS 128
+#define SIGNAL_REPLAY_MAX_EPISODES 32
+#define SIGNAL_REPLAY_PPG_RATE 100
+#define SIGNAL_REPLAY_ECG_RATE 500
+#define SIGNAL_REPLAY_PPG_SAMPLES (SIGNAL_REPLAY_SECONDS * SIGNAL_REPLAY_PPG_RATE)
+#define SIGNAL_REPLAY_ECG_SAMPLES (SIGNAL_REPLAY_SECONDS * SIGNAL_REPLAY_ECG_RATE)
+#define SIGNAL_REPLAY_QRS_TOLERANCE_MS 75
+#define SIGNAL_REPLAY_PAT_MIN_MS 100     // Pulse arrival after the R wave
+#define SIGNAL_REPLAY_PAT_MAX_MS 600
+
+// Previous detectors, kept here only for comparison
+#define LEGACY_PPG_FINGER 50000
+#define LEGACY_PPG_RATE_SIZE 4
+#define LEGACY_ECG_THRESHOLD 2800
+#define LEGACY_ECG_LOCKOUT_MS 300
+
+// Beat times of one trace (ms on the sample clock)
+struct ReplayBeats {
+    uint32_t ms[SIGNAL_REPLAY_MAX_BEATS];
+    uint16_t count;
+
+    void clear() { count = 0; }
+    void add(uint32_t t) {
+        if (count < SIGNAL_REPLAY_MAX_BEATS) ms[count++] = t;
+    }
+};
+
+// Sensitivity / PPV of detections against reference beats
+struct ReplayScore {
+    uint16_t matched;
+    uint16_t reference;   // Reference beats scored
+    uint16_t detected;    // Detections scored
+
+    uint8_t sensitivity() { return reference ? (uint8_t)(100UL * matched / reference) : 100; }
+    uint8_t ppv() { return detected ? (uint8_t)(100UL * matched / detected) : 100; }
+};
+
+class SignalReplay {
+  private:
+    uint32_t ppgIr[SIGNAL_REPLAY_PPG_SAMPLES];
+    uint32_t ppgTime[SIGNAL_REPLAY_PPG_SAMPLES];
+    int16_t ecg[SIGNAL_REPLAY_ECG_SAMPLES];
+    ReplayBeats truth;
+    ReplayBeats found;
+    ReplayBeats legacy;
+    ReplayBeats legacyR;   // Old QRS path on recorded episodes
+    uint32_t seed = 1;
+    uint8_t failures = 0;
+
+    int32_t noise(int32_t amplitude) {
+        seed = seed * 1664525 + 1013904223;
+        return (int32_t)(seed >> 16) % (2 * amplitude + 1) - amplitude;
+    }
+
+    static unsigned long nsPerSample(unsigned long micro, uint32_t samples) {
+        return samples ? (unsigned long)((uint64_t)micro * 1000 / samples) : 0UL;
+    }
+
+    // Detections are matched one-to-one to reference beats in time order: a
+    // detection takes the first unmatched beat whose window
+    // [ms - before, ms + after] holds it. Beats before 'fromMs' are not scored.
+    static ReplayScore score(const ReplayBeats &ref, const ReplayBeats &det,
+                             int32_t before, int32_t after, uint32_t fromMs) {
+        ReplayScore s = { 0, 0, 0 };
+        for (uint16_t i = 0; i < ref.count; i++) {
+            if (ref.ms[i] >= fromMs) s.reference++;
+        }
+        uint16_t r = 0;
+        for (uint16_t d = 0; d < det.count; d++) {
+            int32_t t = (int32_t)det.ms[d];
+            while (r < ref.count && (int32_t)ref.ms[r] + after < t) r++;  // Window passed
+            if (r < ref.count && (int32_t)ref.ms[r] - before <= t) {
+                if (ref.ms[r] >= fromMs) {
+                    s.matched++;
+                    s.detected++;
+                }
+                r++;
+            } else if (det.ms[d] >= fromMs) {
+                s.detected++;
+            }
+        }
+        return s;
+    }
+
+    void report(const char *name, ReplayScore now, unsigned long nowNs, ReplayScore old, unsigned long oldNs) {
+        bool ok = now.sensitivity() >= SIGNAL_REPLAY_PASS && now.ppv() >= SIGNAL_REPLAY_PASS;
+        if (!ok) failures++;
+        Serial.printf("%-9s %3u beats: Se %3u%% PPV %3u%% %5lu ns/sample | old Se %3u%% PPV %3u%% %5lu ns/sample  %s\n",
+                      name, now.reference, now.sensitivity(), now.ppv(), nowNs,
+                      old.sensitivity(), old.ppv(), oldNs, ok ? "OK" : "WRONG");
+    }
+
+    // --- PPG ---
+
+    // IR at 100 Hz: DC 100000, a systolic dip of 'amplitude' counts lasting
+    // 30 % of the period (peak at 15 %), slow drift and noise
+    void makePpg(uint8_t bpm, uint16_t amplitude, uint16_t drift, uint16_t noiseLevel) {
+        float period = 60000.0f / bpm;
+        seed = 1;
+        truth.clear();
+        for (float peak = 0.15f * period; peak < SIGNAL_REPLAY_SECONDS * 1000.0f; peak += period) {
+            truth.add((uint32_t)peak);
+        }
+        for (uint32_t n = 0; n < SIGNAL_REPLAY_PPG_SAMPLES; n++) {
+            uint32_t t = n * 1000 / SIGNAL_REPLAY_PPG_RATE;
+            float phase = fmodf(t / period, 1.0f);
+            float pulse = (phase < 0.3f) ? sinf(phase / 0.3f * PI) : 0;
+            float wander = drift * sinf(2 * PI * 0.2f * t / 1000.0f);
+            ppgIr[n] = (uint32_t)(100000 - amplitude * pulse + wander + noise(noiseLevel));
+            ppgTime[n] = t;
+        }
+    }
+
+    // New path: FIFO-sized blocks, the average read on each beat as HartRate does
+    unsigned long runPpg() {
+        PPGBeatDetector detector;
+        detector.begin(SIGNAL_REPLAY_PPG_RATE);
+        PPGBeat beats[4];
+        found.clear();
+        volatile uint16_t avg = 0;
+        uint8_t cycle = 0;
+
+        unsigned long start = micros();
+        for (uint32_t n = 0; n < SIGNAL_REPLAY_PPG_SAMPLES;) {
+            uint16_t count = (uint16_t)(1 + cycle++ % 3);
+            if (count > SIGNAL_REPLAY_PPG_SAMPLES - n) count = (uint16_t)(SIGNAL_REPLAY_PPG_SAMPLES - n);
+            uint8_t beatCount = detector.process(&ppgIr[n], &ppgTime[n], count, beats, 4);
+            for (uint8_t b = 0; b < beatCount; b++) {
+                found.add(beats[b].timeMs);
+                avg = detector.getAvgBpmX10();
+            }
+            n += count;
+        }
+        (void)avg;
+        return nsPerSample(micros() - start, SIGNAL_REPLAY_PPG_SAMPLES);
+    }
+
+    // Old path, per sample as HartRate::processSample() ran it
+    unsigned long runLegacyPpg() {
+        byte rates[LEGACY_PPG_RATE_SIZE] = {};
+        byte rateSpot = 0;
+        long lastBeat = 0;
+        volatile float avgBpm = 0;
+        legacy.clear();
+
+        unsigned long start = micros();
+        for (uint32_t n = 0; n < SIGNAL_REPLAY_PPG_SAMPLES; n++) {
+            long irValue = ppgIr[n];
+            if (irValue < LEGACY_PPG_FINGER) {
+                rateSpot = 0;
+                continue;
+            }
+            if (checkForBeat(irValue)) {
+                long delta = ppgTime[n] - lastBeat;
+                lastBeat = ppgTime[n];
+                legacy.add(ppgTime[n]);
+                if (delta > 250 && delta < 2000) {
+                    float bpm = 60000.0 / delta;
+                    rates[rateSpot++] = (byte)bpm;
+                    rateSpot %= LEGACY_PPG_RATE_SIZE;
+                    float sum = 0;
+                    for (byte x = 0; x < LEGACY_PPG_RATE_SIZE; x++) sum += rates[x];
+                    avgBpm = sum / LEGACY_PPG_RATE_SIZE;
+                }
+            }
+        }
+        (void)avgBpm;
+        return nsPerSample(micros() - start, SIGNAL_REPLAY_PPG_SAMPLES);
+    }
+
+    void ppgCase(const char *name, uint8_t bpm, uint16_t amplitude, uint16_t drift, uint16_t noiseLevel) {
+        makePpg(bpm, amplitude, drift, noiseLevel);
+        int32_t period = 60000 / bpm;
+        unsigned long nowNs = runPpg();
+        unsigned long oldNs = runLegacyPpg();
+        report(name, score(truth, found, period / 4, period * 3 / 4, SIGNAL_REPLAY_WARMUP_MS), nowNs,
+               score(truth, legacy, period / 4, period * 3 / 4, SIGNAL_REPLAY_WARMUP_MS), oldNs);
+    }
+
+    // --- ECG ---
+
+    // ADC counts at 500 Hz around mid-scale: 40 ms triangular QRS of
+    // 'amplitude', a T wave, baseline wander at 0.3 Hz and noise
+    void makeEcg(uint8_t bpm, uint16_t amplitude, uint16_t wander, uint16_t noiseLevel) {
+        uint32_t rr = (uint32_t)SIGNAL_REPLAY_ECG_RATE * 60 / bpm;
+        uint32_t tOffset = (rr * 2 / 5 < 160) ? rr * 2 / 5 : 160;
+        seed = 1;
+        truth.clear();
+        for (uint32_t n = 0; n < SIGNAL_REPLAY_ECG_SAMPLES; n++) {
+            float t = (float)n / SIGNAL_REPLAY_ECG_RATE;
+            ecg[n] = (int16_t)(2048 + wander * sinf(2 * PI * 0.3f * t) + noise(noiseLevel));
+        }
+        for (uint32_t r = rr / 2; r + tOffset + 40 < SIGNAL_REPLAY_ECG_SAMPLES; r += rr) {
+            truth.add(r * 1000 / SIGNAL_REPLAY_ECG_RATE);
+            for (int32_t k = -10; k <= 10; k++) ecg[r + k] += (int16_t)(amplitude * (10 - abs(k)) / 10);
+            for (int32_t k = -40; k <= 40; k++) {
+                ecg[r + tOffset + k] += (int16_t)(0.15f * amplitude * cosf(k * PI / 80));
+            }
+        }
+    }
+
+    // New path: the 32-sample views ECGManager gets from the acquisition ring
+    unsigned long runEcg(const int16_t *values, uint32_t samples, uint16_t rate, ReplayBeats &out) {
+        QRSDetector detector;
+        detector.begin(rate);
+        QRSBeat beats[8];
+        out.clear();
+
+        unsigned long start = micros();
+        for (uint32_t n = 0; n < samples; n += 32) {
+            uint16_t count = (uint16_t)((samples - n < 32) ? samples - n : 32);
+            uint8_t beatCount = detector.process(&values[n], count, n, beats, 8);
+            for (uint8_t b = 0; b < beatCount; b++) out.add((uint32_t)((uint64_t)beats[b].seq * 1000 / rate));
+        }
+        return nsPerSample(micros() - start, samples);
+    }
+
+    // Old path, per sample as ECGManager::detectBeat() ran it
+    unsigned long runLegacyEcg(const int16_t *values, uint32_t samples, uint16_t rate, ReplayBeats &out) {
+        unsigned long lastPeakTime = 0;
+        volatile long interval = 0;
+        out.clear();
+
+        unsigned long start = micros();
+        for (uint32_t n = 0; n < samples; n++) {
+            unsigned long sampleMs = (unsigned long)((uint64_t)n * 1000 / rate);
+            if (values[n] > LEGACY_ECG_THRESHOLD && sampleMs - lastPeakTime > LEGACY_ECG_LOCKOUT_MS) {
+                interval = sampleMs - lastPeakTime;
+                lastPeakTime = sampleMs;
+                out.add(sampleMs);
+            }
+        }
+        (void)interval;
+        return nsPerSample(micros() - start, samples);
+    }
+
+    void ecgCase(const char *name, uint8_t bpm, uint16_t amplitude, uint16_t wander, uint16_t noiseLevel) {
+        makeEcg(bpm, amplitude, wander, noiseLevel);
+        unsigned long nowNs = runEcg(ecg, SIGNAL_REPLAY_ECG_SAMPLES, SIGNAL_REPLAY_ECG_RATE, found);
+        unsigned long oldNs = runLegacyEcg(ecg, SIGNAL_REPLAY_ECG_SAMPLES, SIGNAL_REPLAY_ECG_RATE, legacy);
+        report(name, score(truth, found, SIGNAL_REPLAY_QRS_TOLERANCE_MS, SIGNAL_REPLAY_QRS_TOLERANCE_MS,
+                           SIGNAL_REPLAY_WARMUP_MS), nowNs,
+               score(truth, legacy, SIGNAL_REPLAY_QRS_TOLERANCE_MS, SIGNAL_REPLAY_QRS_TOLERANCE_MS,
+                     SIGNAL_REPLAY_WARMUP_MS), oldNs);
+    }
+
+    // --- RECORDED EPISODES ---
+
+    // Pulses scored against R waves: 'sensitivity' is the share of R waves
+    // followed by a pulse, 'PPV' the share of pulses that follow one
+    static ReplayScore agreement(const ReplayBeats &rWaves, const ReplayBeats &pulses) {
+        return score(rWaves, pulses, -SIGNAL_REPLAY_PAT_MIN_MS, SIGNAL_REPLAY_PAT_MAX_MS, 0);
+    }
+
+    void episodes() {
+        static int32_t values[EPISODE_PAGE_SIZE * 4];
+        EpisodeReader reader;
+
+        for (uint16_t n = 0; n < SIGNAL_REPLAY_MAX_EPISODES; n++) {
+            if (!reader.open(n)) continue;
+            uint16_t ecgRate = reader.getEcgRate();
+            uint16_t ppgRate = reader.getPpgRate();
+
+            // Channels are decoded into the case buffers (an episode is 30 s,
+            // so the first SIGNAL_REPLAY_SECONDS of each are used)
+            uint32_t ecgLimit = (uint32_t)SIGNAL_REPLAY_SECONDS * ecgRate;
+            uint32_t ppgLimit = (uint32_t)SIGNAL_REPLAY_SECONDS * ppgRate;
+            if (ecgLimit > SIGNAL_REPLAY_ECG_SAMPLES) ecgLimit = SIGNAL_REPLAY_ECG_SAMPLES;
+            if (ppgLimit > SIGNAL_REPLAY_PPG_SAMPLES) ppgLimit = SIGNAL_REPLAY_PPG_SAMPLES;
+            uint32_t ecgCount = 0, ppgCount = 0;
+            uint32_t ecgStart = 0, ppgStart = 0;
+            bool ecgSeen = false, ppgSeen = false;
+
+            EpisodeBlock info;
+            while (reader.next(info, values, sizeof(values) / sizeof(values[0]))) {
+                if (info.channel == EPISODE_CH_ECG && info.width == 1) {
+                    if (!ecgSeen) ecgStart = info.firstSeq;
+                    ecgSeen = true;
+                    for (uint16_t f = 0; f < info.frames; f++) {
+                        uint32_t i = info.firstSeq - ecgStart + f;
+                        if (i < ecgLimit) ecg[i] = (int16_t)values[f];
+                        if (i + 1 > ecgCount && i < ecgLimit) ecgCount = i + 1;
+                    }
+                } else if (info.channel == EPISODE_CH_PPG && info.width == 2) {
+                    if (!ppgSeen) ppgStart = info.firstSeq;
+                    ppgSeen = true;
+                    for (uint16_t f = 0; f < info.frames; f++) {
+                        uint32_t i = info.firstSeq - ppgStart + f;
+                        if (i >= ppgLimit) continue;
+                        ppgIr[i] = (uint32_t)values[f * 2 + 1];
+                        ppgTime[i] = (uint32_t)((uint64_t)i * 1000 / ppgRate);
+                        if (i + 1 > ppgCount) ppgCount = i + 1;
+                    }
+                }
+            }
+            reader.close();
+
+            if (ecgCount == 0 || ppgCount == 0 || ecgRate == 0 || ppgRate == 0) {
+                Serial.printf("ep_%04u  reason %u: needs both ECG and PPG channels\n", n, reader.getReason());
+                continue;
+            }
+
+            ReplayBeats &rWaves = truth;
+            unsigned long qrsNs = runEcg(ecg, ecgCount, ecgRate, rWaves);
+            unsigned long oldQrsNs = runLegacyEcg(ecg, ecgCount, ecgRate, legacyR);
+
+            PPGBeatDetector detector;
+            detector.begin(ppgRate);
+            PPGBeat beats[4];
+            found.clear();
+            unsigned long start = micros();
+            for (uint32_t i = 0; i < ppgCount; i += 4) {
+                uint16_t count = (uint16_t)((ppgCount - i < 4) ? ppgCount - i : 4);
+                uint8_t beatCount = detector.process(&ppgIr[i], &ppgTime[i], count, beats, 4);
+                for (uint8_t b = 0; b < beatCount; b++) found.add(beats[b].timeMs);
+            }
+            unsigned long ppgNs = nsPerSample(micros() - start, ppgCount);
+
+            legacy.clear();
+            start = micros();
+            for (uint32_t i = 0; i < ppgCount; i++) {
+                if ((long)ppgIr[i] >= LEGACY_PPG_FINGER && checkForBeat(ppgIr[i])) legacy.add(ppgTime[i]);
+            }
+            unsigned long oldPpgNs = nsPerSample(micros() - start, ppgCount);
+
+            ReplayScore both = agreement(rWaves, found);
+            ReplayScore oldQrs = agreement(legacyR, found);
+            ReplayScore oldPpg = agreement(rWaves, legacy);
+            Serial.printf("ep_%04u  reason %u: %u R waves (%lu ns/sample, old %u, %lu ns/sample), "
+                          "%u pulses (%lu ns/sample, old %u, %lu ns/sample)\n",
+                          n, reader.getReason(), rWaves.count, qrsNs, legacyR.count, oldQrsNs,
+                          found.count, ppgNs, legacy.count, oldPpgNs);
+            Serial.printf("         R waves with a pulse / pulses after an R wave: %u%% / %u%%, "
+                          "old QRS %u%% / %u%%, old PPG %u%% / %u%%\n",
+                          both.sensitivity(), both.ppv(), oldQrs.sensitivity(), oldQrs.ppv(),
+                          oldPpg.sensitivity(), oldPpg.ppv());
+        }
+    }
+
+  public:
+    // Returns the number of synthetic cases below SIGNAL_REPLAY_PASS
+    uint8_t run() {
+        failures = 0;
+
+        Serial.println("--- SIGNAL REPLAY: PPG beats (new | checkForBeat) ---");
+        ppgCase("rest", 60, 600, 0, 10);
+        ppgCase("normal", 72, 600, 0, 10);
+        ppgCase("exercise", 150, 600, 0, 10);
+        ppgCase("low perf", 72, 120, 0, 10);
+        ppgCase("high perf", 72, 2000, 0, 10);
+        ppgCase("drift", 72, 600, 1500, 10);
+        ppgCase("noise", 72, 600, 0, 60);
+
+        Serial.println("--- SIGNAL REPLAY: QRS (new | fixed threshold) ---");
+        ecgCase("rest", 60, 900, 0, 10);
+        ecgCase("normal", 75, 900, 0, 10);
+        ecgCase("exercise", 150, 900, 0, 10);
+        ecgCase("wander", 75, 900, 400, 10);
+        ecgCase("low amp", 75, 450, 0, 10);
+        ecgCase("noise", 75, 900, 0, 60);
+
+        Serial.println("--- SIGNAL REPLAY: recorded episodes ---");
+        episodes();
+
+        Serial.printf("--- %u cases below %u%% ---\n", failures, SIGNAL_REPLAY_PASS);
+        return failures;
+    }
+};
+
+#endif
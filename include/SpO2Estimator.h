@@ -0,0 +1,138 @@
+#ifndef SPO2ESTIMATOR_H
+#define SPO2ESTIMATOR_H
+
+#include <stdint.h>
+#include <math.h>
+
+/*
+  SpO2Estimator
+  -------------
+  Streaming oxygen saturation from the MAX30102 red/IR channels.
+  - addSample(): O(1) per sample, integer only (DC tracker + AC peak/trough)
+  - The DC tracker's shift comes from the sample rate given to begin(), so
+    its time constant stays ~SPO2_DC_TAU_MS at 100, 200 and 400 Hz
+  - onBeat(): called once per detected beat, computes the ratio of ratios
+  - Fixed memory, no sample buffering, no heap
+*/
+
+#define SPO2_DC_TAU_MS 1280     // DC low-pass time constant (alpha = 1/128 at 100 Hz)
+#define SPO2_DC_SHIFT_MAX 12
+#define SPO2_MIN_PERFUSION 10   // Perfusion index floor, in 0.01 % (0.1 %)
+
+class SpO2Estimator {
+  private:
+    // DC levels in Q8 (value << 8)
+    int32_t dcRed = 0;
+    int32_t dcIr = 0;
+    uint8_t dcShift = 7;
+    bool primed = false;
+
+    // AC extremes seen since the last beat (sample - DC)
+    int32_t maxRed = 0, minRed = 0;
+    int32_t maxIr = 0, minIr = 0;
+
+    // Outputs
+    float ratio = 0;        // Smoothed ratio of ratios (R)
+    int spo2 = 0;           // Percent, 0 = not available yet
+    int quality = 0;        // Signal-quality index 0..100
+    uint8_t goodBeats = 0;  // Consecutive beats that passed the checks
+
+    void resetExtremes() {
+        maxRed = minRed = 0;
+        maxIr = minIr = 0;
+    }
+
+  public:
+    // sampleRate: samples per second fed to addSample()
+    void begin(uint16_t sampleRate) {
+        // Smallest alpha = 1 / 2^shift with 2^shift samples >= SPO2_DC_TAU_MS
+        dcShift = 0;
+        while (dcShift < SPO2_DC_SHIFT_MAX &&
+               ((uint32_t)1000 << dcShift) < (uint32_t)SPO2_DC_TAU_MS * sampleRate) {
+            dcShift++;
+        }
+        reset();
+    }
+
+    void reset() {
+        primed = false;
+        ratio = 0;
+        spo2 = 0;
+        quality = 0;
+        goodBeats = 0;
+        resetExtremes();
+    }
+
+    // Feed one red/IR sample pair
+    void addSample(uint32_t red, uint32_t ir) {
+        int32_t r = (int32_t)red << 8;
+        int32_t i = (int32_t)ir << 8;
+
+        if (!primed) {
+            dcRed = r;
+            dcIr = i;
+            primed = true;
+        }
+
+        dcRed += (r - dcRed) >> dcShift;
+        dcIr += (i - dcIr) >> dcShift;
+
+        int32_t acRed = (r - dcRed) >> 8;
+        int32_t acIr = (i - dcIr) >> 8;
+
+        if (acRed > maxRed) maxRed = acRed;
+        if (acRed < minRed) minRed = acRed;
+        if (acIr > maxIr) maxIr = acIr;
+        if (acIr < minIr) minIr = acIr;
+    }
+
+    // Close the current beat: peak-to-peak AC over DC for each channel
+    void onBeat() {
+        int32_t ppRed = maxRed - minRed;
+        int32_t ppIr = maxIr - minIr;
+        int32_t dcR = dcRed >> 8;
+        int32_t dcI = dcIr >> 8;
+        resetExtremes();
+
+        if (ppRed <= 0 || ppIr <= 0 || dcR <= 0 || dcI <= 0) {
+            goodBeats = 0;
+            quality = 0;
+            return;
+        }
+
+        // Perfusion index (IR) in 0.01 %
+        int32_t perfusion = (int32_t)((int64_t)ppIr * 10000 / dcI);
+
+        // R = (ACred / DCred) / (ACir / DCir)
+        float r = (float)((int64_t)ppRed * dcI) / (float)((int64_t)ppIr * dcR);
+        if (perfusion < SPO2_MIN_PERFUSION || r < 0.2f || r > 2.0f) {
+            goodBeats = 0;
+            quality = quality / 2;
+            return;
+        }
+
+        // Beat-to-beat consistency of R drives half the quality score
+        float deviation = (ratio > 0) ? fabsf(r - ratio) / ratio : 1.0f;
+        ratio = (ratio > 0) ? ratio + (r - ratio) * 0.25f : r;
+
+        // Maxim reference calibration curve
+        float est = -45.060f * ratio * ratio + 30.354f * ratio + 94.845f;
+        if (est > 100) est = 100;
+        if (est < 70) est = 70;
+
+        if (goodBeats < 255) goodBeats++;
+        if (goodBeats >= 3) spo2 = (int)(est + 0.5f);
+
+        int perfusionScore = (perfusion >= 100) ? 50 : (int)(perfusion / 2);
+        int consistencyScore = (deviation >= 0.5f) ? 0 : (int)(50 - deviation * 100);
+        quality = perfusionScore + consistencyScore;
+    }
+
+    // --- GETTERS ---
+    int getSpO2() { return spo2; }
+    int getSignalQuality() { return quality; }
+    float getRatio() { return ratio; }
+    uint8_t getDcShift() { return dcShift; }
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef SPRITECACHE_H
+#define SPRITECACHE_H
+
+#include <Arduino.h>
+
+/*
+  SpriteCache
+  -----------
+  Icons and large glyphs rasterized once (at boot) and blitted per frame.
+  - Sprites are captured straight out of the SH1106 framebuffer after
+    drawing them with the normal GFX primitives, so they are pixel-identical
+    to the primitive version and already in page format (1 byte = 8 rows)
+  - A sprite is 'pages' strips of 'width' bytes; blitting a strip is a
+    straight OR of a contiguous byte run (plus one shift when y is not a
+    multiple of 8), instead of re-running circle / triangle / font code
+  - Sprites are transparent: set bits are drawn white, clear bits leave the
+    frame untouched (the same as drawing white primitives)
+*/
+
+#define SPRITE_POOL_BYTES 1024
+#define SPRITE_FB_WIDTH 128
+#define SPRITE_FB_HEIGHT 64
+
+struct Sprite {
+    int8_t offX = 0;       // Top-left corner relative to the draw anchor
+    int8_t offY = 0;
+    uint8_t width = 0;
+    uint8_t pages = 0;     // Height in 8-pixel strips
+    uint16_t offset = 0;   // Start of the strips in the pool
+};
+
+class SpriteCache {
+  private:
+    uint8_t pool[SPRITE_POOL_BYTES];
+    uint16_t used = 0;
+
+    static bool pixelAt(const uint8_t *buffer, int16_t x, int16_t y) {
+        if (x < 0 || x >= SPRITE_FB_WIDTH || y < 0 || y >= SPRITE_FB_HEIGHT) return false;
+        return buffer[x + (y / 8) * SPRITE_FB_WIDTH] & (1 << (y & 7));
+    }
+
+  public:
+    void clear() { used = 0; }
+    uint16_t getUsedBytes() { return used; }
+
+    // Capture the box (x, y, w, h) of 'buffer'; (anchorX, anchorY) is the
+    // point later passed to blit(). Returns false if the pool is full.
+    bool captureBox(const uint8_t *buffer, int16_t x, int16_t y, uint8_t w, uint8_t h,
+                    int16_t anchorX, int16_t anchorY, Sprite &out) {
+        uint8_t pages = (h + 7) / 8;
+        if (used + (uint16_t)w * pages > SPRITE_POOL_BYTES) return false;
+
+        out.offX = x - anchorX;
+        out.offY = y - anchorY;
+        out.width = w;
+        out.pages = pages;
+        out.offset = used;
+
+        for (uint8_t p = 0; p < pages; p++) {
+            for (uint8_t c = 0; c < w; c++) {
+                uint8_t bits = 0;
+                for (uint8_t b = 0; b < 8 && p * 8 + b < h; b++) {
+                    if (pixelAt(buffer, x + c, y + p * 8 + b)) bits |= 1 << b;
+                }
+                pool[used++] = bits;
+            }
+        }
+        return true;
+    }
+
+    // Capture everything set in 'buffer' (bounding box of the lit pixels)
+    bool capture(const uint8_t *buffer, int16_t anchorX, int16_t anchorY, Sprite &out) {
+        int16_t minX = SPRITE_FB_WIDTH, minY = SPRITE_FB_HEIGHT, maxX = -1, maxY = -1;
+        for (int16_t y = 0; y < SPRITE_FB_HEIGHT; y++) {
+            for (int16_t x = 0; x < SPRITE_FB_WIDTH; x++) {
+                if (!pixelAt(buffer, x, y)) continue;
+                if (x < minX) minX = x;
+                if (x > maxX) maxX = x;
+                if (y < minY) minY = y;
+                if (y > maxY) maxY = y;
+            }
+        }
+        if (maxX < 0) return false; // Nothing drawn
+        return captureBox(buffer, minX, minY, maxX - minX + 1, maxY - minY + 1, anchorX, anchorY, out);
+    }
+
+    // OR the sprite into 'buffer' with its anchor at (x, y), clipped to the screen
+    void blit(uint8_t *buffer, const Sprite &s, int16_t x, int16_t y) const {
+        x += s.offX;
+        y += s.offY;
+
+        int16_t first = (x < 0) ? -x : 0;
+        int16_t last = s.width;
+        if (x + last > SPRITE_FB_WIDTH) last = SPRITE_FB_WIDTH - x;
+        if (first >= last) return;
+
+        int16_t page0 = (y >= 0) ? y / 8 : (y - 7) / 8; // Floor division
+        uint8_t shift = y - page0 * 8;
+        const uint8_t *src = &pool[s.offset];
+
+        for (uint8_t p = 0; p < s.pages; p++, src += s.width) {
+            int16_t upper = page0 + p;   // Strip that receives the low bits
+            int16_t lower = upper + 1;   // Strip that receives the spill-over
+            bool upperOk = upper >= 0 && upper < SPRITE_FB_HEIGHT / 8;
+            bool lowerOk = shift && lower >= 0 && lower < SPRITE_FB_HEIGHT / 8;
+
+            if (upperOk) {
+                uint8_t *dst = &buffer[upper * SPRITE_FB_WIDTH + x];
+                if (shift == 0) {
+                    for (int16_t c = first; c < last; c++) dst[c] |= src[c];
+                } else {
+                    for (int16_t c = first; c < last; c++) dst[c] |= src[c] << shift;
+                }
+            }
+            if (lowerOk) {
+                uint8_t *dst = &buffer[lower * SPRITE_FB_WIDTH + x];
+                for (int16_t c = first; c < last; c++) dst[c] |= src[c] >> (8 - shift);
+            }
+        }
+    }
+};
+
+#endif
@@ -3,6 +3,10 @@
 
 #include <Arduino.h>
 #include <RTClib.h>
+#include "I2CBus.h"
+
+#define DS3231_ADDR 0x68
+#define DS3231_I2C_CLOCK 400000
 
 /*
   TimeManager
@@ -11,21 +15,53 @@
   - Initialization
   - Safe time updating (once per second)
   - Formatted time & date strings for OLED display
+    (formatted once per RTC update into fixed buffers, no heap)
 */
 
 class TimeManager
 {
 private:
   RTC_DS3231 rtc;         // RTC object
+  I2CBus *bus = nullptr;
+  uint8_t busDevice = 0;
   DateTime now;           // Current time snapshot
   unsigned long lastTick; // For 1-second update timing
+  char timeText[10];      // "12:05 PM"
+  char dateText[12];      // "07/01/2026"
+
+  void formatStrings()
+  {
+    int hour = now.hour();
+    int minute = now.minute();
+
+    const char *period = (hour >= 12) ? " PM" : " AM";
+
+    // Convert 24-hour to 12-hour format
+    hour = hour % 12;
+    if (hour == 0)
+      hour = 12;
+
+    snprintf(timeText, sizeof(timeText), "%d:%02d%s", hour, minute, period);
+    snprintf(dateText, sizeof(dateText), "%02d/%02d/%04d",
+             now.day(),
+             now.month(),
+             now.year());
+  }
 
 public:
-  TimeManager() : lastTick(0) {}
+  TimeManager() : lastTick(0)
+  {
+    timeText[0] = '\0';
+    dateText[0] = '\0';
+  }
 
   /* ================= INITIALIZE RTC ================= */
-  void begin()
+  void begin(I2CBus &i2c)
   {
+    bus = &i2c;
+    busDevice = bus->addDevice(DS3231_ADDR, DS3231_I2C_CLOCK, "ds3231");
+    I2CBusLock guard(*bus, busDevice);
+
     if (!rtc.begin())
     {
       Serial.println("❌ RTC NOT FOUND");
@@ -44,6 +80,7 @@ public:
     */
 
     now = rtc.now(); // Get initial time
+    formatStrings();
   }
 
   /* ================= UPDATE TIME ================= */
@@ -53,7 +90,11 @@ public:
     if (millis() - lastTick >= 1000)
     {
       lastTick = millis();
-      now = rtc.now();
+      {
+        I2CBusLock guard(*bus, busDevice);
+        now = rtc.now();
+      }
+      formatStrings();
       return true; // Time updated
     }
     return false; // No update yet
@@ -67,34 +108,16 @@ public:
 
   /* ================= TIME STRING ================= */
   // Returns formatted time like: "12:05 PM"
-  String getTimeString()
+  const char *getTimeString()
   {
-    int hour = now.hour();
-    int minute = now.minute();
-
-    String period = (hour >= 12) ? " PM" : " AM";
-
-    // Convert 24-hour to 12-hour format
-    hour = hour % 12;
-    if (hour == 0)
-      hour = 12;
-
-    char buffer[10];
-    sprintf(buffer, "%d:%02d%s", hour, minute, period.c_str());
-    return String(buffer);
+    return timeText;
   }
 
   /* ================= DATE STRING ================= */
   // Returns formatted date like: "07/01/2026"
-  String getDateString()
+  const char *getDateString()
   {
-    char buffer[12];
-    sprintf(buffer, "%02d/%02d/%04d",
-            now.day(),
-            now.month(),
-            now.year());
-
-    return String(buffer);
+    return dateText;
   }
 };
 
@@ -1,83 +1,330 @@
 #ifndef WEATHERMANAGER_H
 #define WEATHERMANAGER_H
 
-#include <Adafruit_BMP280.h>
+#include <Arduino.h>
+#include <math.h>
+#include "I2CBus.h"
+#include "AltitudeFusion.h"
+
+/*
+  WeatherManager
+  --------------
+  BMP280 temperature / pressure / altitude from a cached snapshot.
+  - The sensor runs in normal mode (pressure x16, temperature x2
+    oversampling, IIR filter 16, 62.5 ms standby), so it converts on its
+    own and the filter smooths door slams and wind gusts on-chip
+  - update() does one 6-byte burst read (0xF7..0xFC) per BMP280_READ_MS
+    and compensates it with the Bosch integer formulas (calibration read
+    once at begin())
+  - Getters return the snapshot without touching the bus; every call that
+    used to be a sensor read is counted as a saved transaction. peek*()
+    return the same values uncounted, for change detection (the display's
+    frame governor) that never read the sensor
+  - Pressure history: the snapshots of each minute are averaged into one
+    uint16 sample (2 Pa steps) in a PRESSURE_HISTORY ring (3.2 h, 384
+    bytes). A least-squares line over the ring is kept with running sums
+    (O(1) per sample) and its slope, as hPa per 3 h, picks the forecast
+  - Floors come from AltitudeFusion: every snapshot's altitude plus the
+    accelerometer batches passed to addAccelBlock()
+*/
+
+#define BMP280_ADDR 0x76 // Standard address for most modules
+#define BMP280_I2C_CLOCK 400000
+
+// Registers
+#define BMP280_REG_CALIB 0x88          // dig_T1 .. dig_P9, 24 bytes
+#define BMP280_REG_ID 0xD0
+#define BMP280_REG_CTRL_MEAS 0xF4
+#define BMP280_REG_CONFIG 0xF5
+#define BMP280_REG_DATA 0xF7           // press msb/lsb/xlsb, temp msb/lsb/xlsb
+#define BMP280_CHIP_ID 0x58
+
+// Register values
+#define BMP280_CTRL_MEAS 0x57          // osrs_t x2, osrs_p x16, normal mode
+#define BMP280_CONFIG 0x30             // t_sb 62.5 ms, IIR filter 16
+#define BMP280_FIRST_CONVERSION_MS 50  // First result after entering normal mode
+
+#define BMP280_READ_MS 100             // Snapshot refresh (the sensor outputs ~10 Hz)
+#define BMP280_SEA_LEVEL_HPA 1013.25f
+
+// Pressure history / forecast
+#define PRESSURE_HISTORY 192            // One sample per minute: 3.2 h
+#define PRESSURE_SAMPLE_MS 60000
+#define PRESSURE_BASE_PA 30000          // History sample = (Pa - base) / 2
+#define PRESSURE_STEP_PA 2
+#define FORECAST_MIN_SAMPLES 30         // Trend needs 30 min of history
+#define FORECAST_STORM_HPA -3.0f        // Tendency per 3 h (WMO: falling quickly)
+#define FORECAST_RAIN_HPA -1.0f
+#define FORECAST_CLEAR_HPA 1.0f
 
 class WeatherManager {
   private:
-    Adafruit_BMP280 bmp;
+    I2CBus *bus = nullptr;
+    uint8_t busDevice = 0;
     bool bmpOK = false;
-    float lastPressure = 0;
-    float initialAltitude = 0;
-    unsigned long lastForecastUpdate = 0;
-    String currentForecast = "Stabilizing...";
+
+    // Calibration (datasheet names)
+    uint16_t digT1 = 0;
+    int16_t digT2 = 0, digT3 = 0;
+    uint16_t digP1 = 0;
+    int16_t digP2 = 0, digP3 = 0, digP4 = 0, digP5 = 0, digP6 = 0, digP7 = 0, digP8 = 0, digP9 = 0;
+
+    // Snapshot
+    float temperature = 0;   // deg C
+    float pressure = 0;      // hPa
+    float altitude = 0;      // m
+    unsigned long lastRead = 0;
+    uint32_t reads = 0;
+    uint32_t readErrors = 0;
+    uint32_t savedTransactions = 0;
+
+    AltitudeFusion fusion;
+
+    // Pressure history ring + least-squares sums (x = 0..count-1, oldest first)
+    uint16_t history[PRESSURE_HISTORY];
+    uint16_t historyPos = 0;
+    uint16_t historyCount = 0;
+    int64_t sumY = 0;
+    int64_t sumXY = 0;
+    int64_t minuteSum = 0;            // Snapshots of the current minute (Pa)
+    uint16_t minuteCount = 0;
+    unsigned long lastHistorySample = 0;
+    float trend = 0;                  // hPa per 3 h
+    const char *currentForecast = "Stabilizing...";
+
+    // Cost of update()
+    uint32_t updates = 0;
+    uint64_t updateMicrosTotal = 0;
+    uint32_t updateMicrosMax = 0;
+
+    static uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+    bool readCalibration() {
+        uint8_t c[24];
+        if (bus->readRegisters(busDevice, BMP280_REG_CALIB, c, sizeof(c)) != I2C_OK) return false;
+        digT1 = get16(c);
+        digT2 = (int16_t)get16(c + 2);
+        digT3 = (int16_t)get16(c + 4);
+        digP1 = get16(c + 6);
+        digP2 = (int16_t)get16(c + 8);
+        digP3 = (int16_t)get16(c + 10);
+        digP4 = (int16_t)get16(c + 12);
+        digP5 = (int16_t)get16(c + 14);
+        digP6 = (int16_t)get16(c + 16);
+        digP7 = (int16_t)get16(c + 18);
+        digP8 = (int16_t)get16(c + 20);
+        digP9 = (int16_t)get16(c + 22);
+        return digP1 != 0; // dig_P1 == 0 would divide by zero
+    }
+
+    // Bosch reference compensation (BMP280 datasheet 8.2): temperature in
+    // 0.01 deg C, pressure in Pa (Q24.8)
+    int32_t compensateTemperature(int32_t adcT, int32_t &tFine) {
+        int32_t var1 = ((((adcT >> 3) - ((int32_t)digT1 << 1))) * ((int32_t)digT2)) >> 11;
+        int32_t var2 = (((((adcT >> 4) - ((int32_t)digT1)) * ((adcT >> 4) - ((int32_t)digT1))) >> 12) *
+                        ((int32_t)digT3)) >> 14;
+        tFine = var1 + var2;
+        return (tFine * 5 + 128) >> 8;
+    }
+
+    uint32_t compensatePressure(int32_t adcP, int32_t tFine) {
+        int64_t var1 = ((int64_t)tFine) - 128000;
+        int64_t var2 = var1 * var1 * (int64_t)digP6;
+        var2 = var2 + ((var1 * (int64_t)digP5) << 17);
+        var2 = var2 + (((int64_t)digP4) << 35);
+        var1 = ((var1 * var1 * (int64_t)digP3) >> 8) + ((var1 * (int64_t)digP2) << 12);
+        var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)digP1) >> 33;
+        if (var1 == 0) return 0;
+        int64_t p = 1048576 - adcP;
+        p = (((p << 31) - var2) * 3125) / var1;
+        var1 = (((int64_t)digP9) * (p >> 13) * (p >> 13)) >> 25;
+        var2 = (((int64_t)digP8) * p) >> 19;
+        p = ((p + var1 + var2) >> 8) + (((int64_t)digP7) << 4);
+        return (uint32_t)p;
+    }
+
+    // One burst read of pressure + temperature into the snapshot
+    bool readSnapshot() {
+        uint8_t d[6];
+        if (bus->readRegisters(busDevice, BMP280_REG_DATA, d, sizeof(d)) != I2C_OK) {
+            readErrors++;
+            return false;
+        }
+        reads++;
+        int32_t adcP = (int32_t)((uint32_t)d[0] << 12 | (uint32_t)d[1] << 4 | d[2] >> 4);
+        int32_t adcT = (int32_t)((uint32_t)d[3] << 12 | (uint32_t)d[4] << 4 | d[5] >> 4);
+        if (adcP == 0x80000) return false; // Pressure skipped / no conversion yet
+
+        int32_t tFine;
+        temperature = compensateTemperature(adcT, tFine) / 100.0f;
+        uint32_t pressureQ8 = compensatePressure(adcP, tFine); // Q24.8 Pa
+        pressure = pressureQ8 / 25600.0f;                       // -> hPa
+        altitude = 44330.0f * (1.0f - powf(pressure / BMP280_SEA_LEVEL_HPA, 0.1903f));
+        minuteSum += pressureQ8 >> 8;
+        minuteCount++;
+        fusion.addBaro(altitude, millis());
+        return true;
+    }
+
+    // Appends one history sample and slides the least-squares sums
+    void addHistory(uint16_t y) {
+        if (historyCount == PRESSURE_HISTORY) {
+            // Drop the oldest and renumber x: every remaining x goes down by one
+            uint16_t oldest = history[historyPos];
+            sumXY -= sumY - oldest;
+            sumY -= oldest;
+            historyCount--;
+        }
+        history[historyPos] = y;
+        historyPos = (historyPos + 1) % PRESSURE_HISTORY;
+        sumXY += (int64_t)historyCount * y;
+        sumY += y;
+        historyCount++;
+    }
+
+    // Slope of the least-squares line, in hPa per 3 h
+    float fitTrend() {
+        int64_t n = historyCount;
+        int64_t sumX = n * (n - 1) / 2;
+        int64_t sumXX = (n - 1) * n * (2 * n - 1) / 6;
+        int64_t den = n * sumXX - sumX * sumX;
+        if (den == 0) return 0;
+        float slope = (float)(n * sumXY - sumX * sumY) / (float)den; // Steps per minute
+        return slope * PRESSURE_STEP_PA * 180 / 100.0f;
+    }
+
+    void updateForecast() {
+        if (historyCount < FORECAST_MIN_SAMPLES) return;
+        trend = fitTrend();
+        if (trend <= FORECAST_STORM_HPA) currentForecast = "Storm Warning!";
+        else if (trend <= FORECAST_RAIN_HPA) currentForecast = "Rain Likely";
+        else if (trend >= FORECAST_CLEAR_HPA) currentForecast = "Clear Skies";
+        else currentForecast = "Stable";
+    }
 
   public:
     WeatherManager() {}
 
     // Initialize the sensor
-    bool begin() {
-        if (bmp.begin(0x76)) { // Standard address for most modules
-            bmpOK = true;
-            initialAltitude = bmp.readAltitude(1013.25);
-            lastPressure = bmp.readPressure() / 100.0F;
-            return true;
-        }
-        return false;
+    bool begin(I2CBus &i2c) {
+        bus = &i2c;
+        busDevice = bus->addDevice(BMP280_ADDR, BMP280_I2C_CLOCK, "bmp280");
+
+        uint8_t id = 0;
+        if (bus->readRegisters(busDevice, BMP280_REG_ID, &id, 1) != I2C_OK || id != BMP280_CHIP_ID) return false;
+        if (!readCalibration()) return false;
+        bus->writeRegister(busDevice, BMP280_REG_CONFIG, BMP280_CONFIG); // Before leaving sleep mode
+        bus->writeRegister(busDevice, BMP280_REG_CTRL_MEAS, BMP280_CTRL_MEAS);
+        delay(BMP280_FIRST_CONVERSION_MS);
+
+        fusion.begin();
+        if (!readSnapshot()) return false;
+        bmpOK = true;
+        lastRead = millis();
+        lastHistorySample = millis();
+        return true;
     }
 
-    // Main update logic (call this in your loop)
+    // Main update logic (call this in your loop, whatever the screen):
+    // refreshes the snapshot once per BMP280_READ_MS and logs one history
+    // sample per minute
     void update() {
         if (!bmpOK) return;
+        unsigned long start = micros();
 
-        // Update forecast every 10 minutes (600,000 ms)
-        if (millis() - lastForecastUpdate > 600000) {
-            float currentPressure = bmp.readPressure() / 100.0F;
-            
-            if (currentPressure < lastPressure - 1.0) {
-                currentForecast = "Storm Warning!";
-            } else if (currentPressure > lastPressure + 1.0) {
-                currentForecast = "Clear Skies";
-            } else {
-                currentForecast = "Stable";
-            }
-            
-            lastPressure = currentPressure;
-            lastForecastUpdate = millis();
+        if (millis() - lastRead >= BMP280_READ_MS) {
+            lastRead = millis();
+            readSnapshot();
         }
+
+        if (millis() - lastHistorySample >= PRESSURE_SAMPLE_MS && minuteCount > 0) {
+            lastHistorySample = millis();
+            int32_t steps = (int32_t)((minuteSum / minuteCount - PRESSURE_BASE_PA) / PRESSURE_STEP_PA);
+            addHistory((uint16_t)(steps < 0 ? 0 : steps > 65535 ? 65535 : steps));
+            minuteSum = 0;
+            minuteCount = 0;
+            updateForecast();
+        }
+
+        uint32_t elapsed = micros() - start;
+        updates++;
+        updateMicrosTotal += elapsed;
+        if (elapsed > updateMicrosMax) updateMicrosMax = elapsed;
     }
 
-    // --- Data Getters ---
+    // --- Data Getters (cached, no bus traffic) ---
 
     float getTemperature() {
-        return bmpOK ? bmp.readTemperature() : 0.0;
+        if (!bmpOK) return 0.0;
+        savedTransactions++;
+        return temperature;
     }
 
     float getPressure() {
-        return bmpOK ? bmp.readPressure() / 100.0F : 0.0;
+        if (!bmpOK) return 0.0;
+        savedTransactions++;
+        return pressure;
     }
 
     float getAltitude() {
-        return bmpOK ? bmp.readAltitude(1013.25) : 0.0;
+        if (!bmpOK) return 0.0;
+        savedTransactions++;
+        return altitude;
+    }
+
+    // Same snapshot, not counted as saved reads
+    float peekTemperature() { return bmpOK ? temperature : 0.0; }
+    float peekPressure() { return bmpOK ? pressure : 0.0; }
+
+    // Baro-inertial altitude (m), smoother than getAltitude()
+    float getFusedAltitude() {
+        if (!bmpOK) return 0.0;
+        return fusion.getAltitude();
     }
 
-    // Decision: Calculate how many floors you've climbed since start
+    // Floors climbed / descended since start (counted separately)
     int getFloorsClimbed() {
         if (!bmpOK) return 0;
-        float currentAlt = getAltitude();
-        float diff = currentAlt - initialAltitude;
-        // Average floor height is ~3 meters
-        int floors = (int)(diff / 3.0);
-        return (floors > 0) ? floors : 0;
+        return fusion.getFloorsUp();
     }
 
-    String getForecast() {
+    int getFloorsDescended() {
+        if (!bmpOK) return 0;
+        return fusion.getFloorsDown();
+    }
+
+    // Accelerometer batch for the altitude fusion (call once per batch)
+    void addAccelBlock(const AccelSample *batch, const AccelBlock &block) {
+        if (bmpOK) fusion.addBlock(batch, block);
+    }
+
+    AltitudeFusion &getFusion() {
+        return fusion;
+    }
+
+    const char *getForecast() {
         return currentForecast;
     }
 
+    // Pressure tendency in hPa per 3 h (0 until FORECAST_MIN_SAMPLES minutes)
+    float getPressureTrend() {
+        return trend;
+    }
+
+    uint16_t getHistoryMinutes() {
+        return historyCount;
+    }
+
     bool isConnected() {
         return bmpOK;
     }
+
+    // --- STATS ---
+    uint32_t getReads() { return reads; }
+    uint32_t getReadErrors() { return readErrors; }
+    uint32_t getSavedTransactions() { return savedTransactions; }
+    float getUpdateMicros() { return updates ? (float)updateMicrosTotal / updates : 0; }
+    uint32_t getMaxUpdateMicros() { return updateMicrosMax; }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -9,10 +9,24 @@
 #include "WeatherManager.h"
 #include "ECGManager.h"
 #include "ActivityManager.h"
+#include "ActivityClassifier.h"
 #include "Vibrate.h"
 #include "DisplayManager.h"
 #include "Firebase/FirebaseManager.h"
 #include "Firebase/FireBaseSndOBJ.h"
+#include "AllocCounter.h"
+#include "I2CBus.h"
+#include "EpisodeRecorder.h"
+#include "RollingStats.h"
+#ifdef RENDER_BENCHMARK
+#include "RenderBenchmark.h"
+#endif
+#ifdef ACCEL_REPLAY
+#include "AccelReplay.h"
+#endif
+#ifdef SIGNAL_REPLAY
+#include "SignalReplay.h"
+#endif
 
 // --- PIN DEFINITIONS ---
 #define SDA_PIN 8
@@ -23,22 +37,33 @@
 #define BTN_MODE 11  // Switch Screens
 #define BTN_SOS 12   // Long Press for Emergency
 
+// Display: flush the OLED from a task on core 0 (false = flush inside loop())
+#define DISPLAY_FLUSH_TASK true
+
+// MPU6050 INT (drives the accelerometer FIFO reads; -1 = poll)
+#define MPU_INT 7
+// Use the MPU6050's free-fall / motion interrupts instead of data ready
+#define ACCEL_HW_EVENTS true
+
 // ECG Pins
 #define ECG_INPUT 36 // VP
 #define ECG_LO_P 38
 #define ECG_LO_N 37
 
 // --- OBJECT INSTANTIATION ---
+I2CBus i2cBus;               // Owns the shared I2C bus (see I2CBus.h)
 TimeManager timeManager;
 HartRate heartMonitor;
 WeatherManager weather;
 ActivityManager activity;
+ActivityClassifier classifier; // Idle / walk / run / stairs, distance and energy
 Vibrate vibrate;
 ECGManager ecg(ECG_INPUT, ECG_LO_P, ECG_LO_N);
 State watchState;            // Handles On/Off state
 DisplayManager displayMgr;   // Handles all OLED drawing
 FirebaseManager firebaseMgr; // Handles Firebase interactions
 FireBaseSndOBJ fireBOBJ;
+EpisodeRecorder recorder;    // Raw waveforms around falls / heart alerts
 
 // --- GLOBAL VARIABLES ---
 int window = 0; // 0=Clock, 1=Pulse, 2=Weather, 3=ECG, 4=Steps
@@ -60,6 +85,23 @@ bool fallReported = false; // Track if fall was already sent to cloud
 // heartrate encapsulated Data
 HeartData hData;
 
+// Heap Allocation Tracking (only counts in the esp32-s3-alloccheck build)
+uint32_t cloudAllocs = 0;          // Allocations inside the Firebase client this loop (no uploader task)
+uint32_t hotPathAllocIters = 0;    // Loop iterations that allocated after boot
+unsigned long lastAllocReport = 0;
+
+// Loop Timing (work time per iteration, excluding the trailing delay; esp32-s3-loopstats)
+RollingStats loopMicros;
+unsigned long lastLoopReport = 0;
+
+// Altitude feed for the activity classifier (stairs)
+unsigned long lastAltitudeSample = 0;
+
+// Sensor samples lost while an alert animation was on screen (target: 0)
+uint32_t alertDroppedSamples = 0;
+uint32_t lastLostSamples = 0;
+bool wasAnimating = false;
+
 /* =================================================================
  * SETUP
  * ================================================================= */
@@ -71,22 +113,53 @@ void setup()
     // 1. Initialize I2C Bus
     // IMPORTANT: Wire.begin must happen before sensors use it
     Wire.begin(SDA_PIN, SCL_PIN);
-    Wire.setClock(100000);
+    // Clock is set per device (400 kHz for all current parts)
+    if (!i2cBus.begin())
+    {
+        Serial.println("❌ I2C BUS FAILED");
+        while (1)
+            ; // Every sensor and the display need the bus
+    }
 
     Serial.println("--- SYSTEM STARTUP ---");
 
     // 2. Initialize Modules
-    displayMgr.begin();
-    timeManager.begin();
+    displayMgr.begin(i2cBus, DISPLAY_FLUSH_TASK);
+    timeManager.begin(i2cBus);
 
-    if (weather.begin())
+    if (weather.begin(i2cBus))
         Serial.println("✅ BMP280 Ready");
     else
         Serial.println("❌ BMP280 FAILED");
 
     ecg.begin();
-    activity.begin();     // Sets up MPU6050
-    heartMonitor.begin(); // Sets up MAX30102
+    activity.begin(i2cBus, MPU_INT, ACCEL_HW_EVENTS); // Sets up MPU6050 (FIFO + interrupts)
+    classifier.begin();
+    heartMonitor.begin(i2cBus); // Sets up MAX30102
+    recorder.begin(ecg.getAcquisition().getSampleRate(), heartMonitor.getSampleRate());
+
+#ifdef ACCEL_KERNEL_BENCHMARK
+    // Accelerometer kernel cycles/sample, scalar vs esp-dsp (esp32-s3-accelbench)
+    activity.getKernel().benchmark();
+#endif
+
+#ifdef RENDER_BENCHMARK
+    // Render cost per screen + golden-frame check (esp32-s3-renderbench)
+    RenderBenchmark benchmark(displayMgr);
+    benchmark.run(weather, ecg, activity, classifier, vibrate);
+#endif
+
+#ifdef ACCEL_REPLAY
+    // Activity classifier on synthetic and recorded accel data (esp32-s3-accelreplay)
+    AccelReplay replay;
+    replay.run();
+#endif
+
+#ifdef SIGNAL_REPLAY
+    // Beat detectors vs the paths they replaced, synthetic and recorded (esp32-s3-signalreplay)
+    static SignalReplay signalReplay; // ~36 KB of trace buffers, too big for the loop task stack
+    signalReplay.run();
+#endif
 
     // 3. Setup Buttons
     pinMode(BTN_POWER, INPUT_PULLUP);
@@ -97,6 +170,8 @@ void setup()
     watchState.setState(false); // Start Powered Off
     vibrate.vibrateFor(200);    // Startup haptic feedback
     firebaseMgr.begin();
+    ignoreAllocsFrom(firebaseMgr.getTask()); // Uploads allocate on their own task
+    loopMicros.begin(10000);
 
     displayMgr.clear();
     Serial.println("🚀 SYSTEM READY");
@@ -166,8 +241,8 @@ void checkSOSButton()
         {
             if ((millis() - sosPressedTime >= 3000) && !sosHandled)
             {
-                // Trigger SOS Animation
-                displayMgr.animateEmergencyCall(vibrate);
+                // Trigger SOS Animation (plays from the loop)
+                displayMgr.startEmergencyCall();
                 sosHandled = true;
             }
         }
@@ -179,19 +254,19 @@ void checkSOSButton()
 }
 
 // Logic: Process Heart Rate Alerts
-void processHeartAlerts(HeartData data)
+void processHeartAlerts(const HeartData &data)
 {
     if (data.threeMinAvg > 0)
     {
         // Critical Level (Flash Screen + Vibrate)
         if (data.alertLevel == 2)
         {
-            displayMgr.showHeartAlert(data.status, data.threeMinAvg, 2, vibrate);
+            displayMgr.startHeartAlert(heartStatusText(data.status), data.threeMinAvg, 2);
         }
         // Warning Level (Static Screen + Vibrate)
         else if (data.alertLevel == 1)
         {
-            displayMgr.showHeartAlert(data.status, data.threeMinAvg, 1, vibrate);
+            displayMgr.startHeartAlert(heartStatusText(data.status), data.threeMinAvg, 1);
         }
     }
 }
@@ -202,10 +277,19 @@ void sendTOCLOUD(bool fallAlet, bool hartAlet) {
     fireBOBJ.setPressure(weather.getPressure());
     fireBOBJ.setAltitude(weather.getAltitude());
     fireBOBJ.setFloorsClimbed(weather.getFloorsClimbed());
+    fireBOBJ.setFloorsDescended(weather.getFloorsDescended());
     fireBOBJ.setForecast(weather.getForecast());
     
     // Vital Stats
     fireBOBJ.setAvgBpm(hData.avgBpm);
+    const RollingStats &bpm3Min = heartMonitor.getBpmStats(BPM_WINDOW_3MIN);
+    const RollingStats &bpm15Min = heartMonitor.getBpmStats(BPM_WINDOW_15MIN);
+    fireBOBJ.setBpmStats(bpm3Min.getMean() / 10.0f, bpm3Min.getStdDev() / 10.0f,
+                         bpm15Min.getMin() / 10, bpm15Min.getMax() / 10);
+    fireBOBJ.setSpo2(hData.spo2);
+    fireBOBJ.setSignalQuality(hData.signalQuality);
+    const HRVMetrics &hrv = ecg.getHRV();
+    fireBOBJ.setHrv(hrv.getRMSSD(), hrv.getSDNN(), hrv.getPNN50(), (int)hrv.getMeanHR());
     fireBOBJ.setFallDetec(fallAlet);
 
     // LOGIC CHANGE:
@@ -214,8 +298,146 @@ void sendTOCLOUD(bool fallAlet, bool hartAlet) {
     bool isEmergency = fallAlet || hartAlet;
 
     // Pass 'isEmergency' to the updated function
-    // If TRUE, it ignores the timer and sends INSTANTLY.
+    // If TRUE, it ignores the timer and is queued ahead of everything else.
+    // (Without the uploader task the Firebase client allocates here; keep
+    // that out of the hot-path count)
+    uint32_t allocBefore = getAllocCount();
     firebaseMgr.update(fireBOBJ, isEmergency);
+    cloudAllocs += getAllocCount() - allocBefore;
+}
+
+// Logic: Classify the accelerometer batch read this loop; altitude once a second
+void updateActivity()
+{
+    const AccelSample *batch;
+    activity.getBatch(batch);
+    classifier.addBlock(batch, activity.getBlock(), activity.getSteps());
+    weather.addAccelBlock(batch, activity.getBlock());
+
+    if (weather.isConnected() && millis() - lastAltitudeSample >= 1000)
+    {
+        lastAltitudeSample = millis();
+        classifier.addAltitude(weather.getFusedAltitude(), millis());
+    }
+    classifier.update();
+}
+
+// Logic: Feed the episode recorder and start an episode on fall / critical heart alert
+void recordEpisodes(const HeartData &data)
+{
+    recorder.addEcg(ecg.getAcquisition());
+
+    const uint32_t *red;
+    const uint32_t *ir;
+    uint16_t count = heartMonitor.getLastBlock(red, ir);
+    recorder.addPpg(red, ir, count);
+
+    const AccelSample *accel;
+    uint8_t accelCount = activity.getBatch(accel);
+    for (uint8_t i = 0; i < accelCount; i++)
+        recorder.addAccel(accel[i].x, accel[i].y, accel[i].z, accel[i].timeMs);
+
+    if (activity.isFallDetected())
+        recorder.trigger(EPISODE_FALL);
+    else if (data.alertLevel == 2)
+        recorder.trigger(EPISODE_HEART);
+
+    recorder.update();
+}
+
+// Logic: Count samples lost (PPG FIFO/ring, ECG ring/DMA, accelerometer FIFO) while an alert is playing
+void trackAlertDrops()
+{
+    uint32_t lost = heartMonitor.getLostSamples() + ecg.getMissedSamples() +
+                    ecg.getAcquisition().getOverrunCount() + activity.getLostSamples();
+    bool animating = displayMgr.isAnimating();
+    if (animating || wasAnimating)
+        alertDroppedSamples += lost - lastLostSamples;
+    lastLostSamples = lost;
+
+    if (wasAnimating && !animating)
+        Serial.printf("Alert finished, %lu samples dropped during alerts\n",
+                      (unsigned long)alertDroppedSamples);
+    wasAnimating = animating;
+}
+
+// Logic: Report loop iterations that touched the heap outside the cloud client
+void checkHotPathAllocs(uint32_t allocStart)
+{
+    uint32_t hotPath = getAllocCount() - allocStart - cloudAllocs;
+    cloudAllocs = 0;
+    if (hotPath > 0 && millis() > 10000) // Ignore boot / first screen setup
+        hotPathAllocIters++;
+
+    if (millis() - lastAllocReport >= 10000)
+    {
+        lastAllocReport = millis();
+#ifdef ALLOC_COUNTER
+        Serial.printf("\nHeap: %lu allocating loop iterations, free %lu\n",
+                      (unsigned long)hotPathAllocIters, (unsigned long)ESP.getFreeHeap());
+#endif
+    }
+}
+
+// Logic: Report loop time, redraws the frame governor avoided and I2C bus usage
+// (only in the esp32-s3-loopstats build)
+void reportLoopStats(unsigned long loopStart)
+{
+#ifdef LOOP_STATS
+    loopMicros.add(micros() - loopStart, millis());
+
+    if (millis() - lastLoopReport >= 10000)
+    {
+        lastLoopReport = millis();
+        loopMicros.advance(millis());
+        FrameGovernor &gov = displayMgr.getGovernor();
+        Serial.printf("Loop: mean %.0f us, max %ld us | screen %d drawn %lu, skipped %lu\n",
+                      loopMicros.getMean(), (long)loopMicros.getMax(), window,
+                      (unsigned long)gov.getDraws(window), (unsigned long)gov.getSkips(window));
+
+        // Bus time and queue latency per I2C device
+        for (uint8_t d = 0; d < i2cBus.getDeviceCount(); d++)
+        {
+            Serial.printf("  I2C %-8s %6lu txn %5lu ms bus, latency mean %lu us max %lu us, %lu errors\n",
+                          i2cBus.getName(d), (unsigned long)i2cBus.getTransactions(d),
+                          (unsigned long)i2cBus.getBusMillis(d), (unsigned long)i2cBus.getMeanLatencyMicros(d),
+                          (unsigned long)i2cBus.getMaxLatencyMicros(d), (unsigned long)i2cBus.getErrors(d));
+        }
+        Serial.printf("  Accel %lu samples, %lu FIFO overflows, %lu lost, %lu/%lu fall candidates rejected\n",
+                      (unsigned long)activity.getSampleCount(), (unsigned long)activity.getOverflowCount(),
+                      (unsigned long)activity.getLostSamples(), (unsigned long)activity.getFallsRejected(),
+                      (unsigned long)activity.getFallCandidates());
+        Serial.printf("  BMP280 %lu burst reads, %lu errors, %lu reads saved by the snapshot\n",
+                      (unsigned long)weather.getReads(), (unsigned long)weather.getReadErrors(),
+                      (unsigned long)weather.getSavedTransactions());
+        Serial.printf("  Weather %s, trend %+.1f hPa/3h over %u min, update mean %.1f us max %lu us\n",
+                      weather.getForecast(), weather.getPressureTrend(), weather.getHistoryMinutes(),
+                      weather.getUpdateMicros(), (unsigned long)weather.getMaxUpdateMicros());
+        AltitudeFusion &fusion = weather.getFusion();
+        Serial.printf("  Altitude %.1f m, %+.2f m/s, floors %u up %u down, %lu cycles/sample max %lu, %lu over budget\n",
+                      fusion.getAltitude(), fusion.getVerticalSpeed(), fusion.getFloorsUp(), fusion.getFloorsDown(),
+                      (unsigned long)fusion.getCyclesPerSample(), (unsigned long)fusion.getMaxCyclesPerSample(),
+                      (unsigned long)fusion.getBudgetOverruns());
+        Serial.printf("  Cloud queue %u (max %u), %lu/%lu uploaded, %lu failed, %lu coalesced, "
+                      "latency mean %lu ms max %lu ms, HTTPS max %lu ms, %lu emergency retries, %lu dropped\n",
+                      firebaseMgr.getQueueDepth(), firebaseMgr.getMaxQueueDepth(),
+                      (unsigned long)firebaseMgr.getUploads(), (unsigned long)firebaseMgr.getPublished(),
+                      (unsigned long)firebaseMgr.getFailures(), (unsigned long)firebaseMgr.getCoalesced(),
+                      (unsigned long)firebaseMgr.getMeanLatencyMs(), (unsigned long)firebaseMgr.getMaxLatencyMs(),
+                      (unsigned long)firebaseMgr.getMaxCallMs(), (unsigned long)firebaseMgr.getEmergencyRetries(),
+                      (unsigned long)firebaseMgr.getEmergencyDrops());
+        Serial.printf("  Activity %s, %u steps/min, %lu ns/sample, max hop %lu us, %lu hops over budget\n",
+                      ActivityClassifier::getName(classifier.getActivity()), classifier.getCadence(),
+                      (unsigned long)classifier.getNanosPerSample(), (unsigned long)classifier.getMaxHopMicros(),
+                      (unsigned long)classifier.getHopOverruns());
+        if (activity.isHardwareEvents())
+            Serial.printf("  Accel events: %lu motion, %lu free-fall, %lu wakeups, %s\n",
+                          (unsigned long)activity.getMotionEvents(), (unsigned long)activity.getFreefallEvents(),
+                          (unsigned long)activity.getWakeups(), activity.isIdle() ? "idle" : "active");
+    }
+#else
+    (void)loopStart;
+#endif
 }
 
 /* =================================================================
@@ -223,13 +445,20 @@ void sendTOCLOUD(bool fallAlet, bool hartAlet) {
  * ================================================================= */
 void loop()
 {
+    uint32_t allocStart = getAllocCount();
+    unsigned long loopStart = micros();
+
     // 1. Always update background sensors (Critical for accurate readings)
     timeManager.update();
+    ecg.update();
+    weather.update(); // Snapshot refresh (one burst read per BMP280_READ_MS)
     activity.update();
+    updateActivity();
     vibrate.update();
 
     // Get latest heart data and check for health alerts
-    hData = heartMonitor.update();
+    heartMonitor.update(hData);
+    recordEpisodes(hData); // Before the alerts, so the trigger sees this loop's samples
     processHeartAlerts(hData);
 
     // 2. Check Global Events (Fall / SOS / Power)
@@ -237,11 +466,15 @@ void loop()
     // Fall Detection
     if (activity.isFallDetected() && !fallReported)
     {
+        const FallEvent &fall = activity.getFallEvent();
+        Serial.printf("Fall at %lu ms, confidence %u%% (free-fall %u, impact %u, orientation %u, still %u)\n",
+                      (unsigned long)fall.timeMs, fall.confidence, fall.freefallScore, fall.impactScore,
+                      fall.orientationScore, fall.inactivityScore);
         sendTOCLOUD(true, false);
         fallReported = true;  // Mark as reported
 
         // If OFF, wake up? Optional. For now, we assume it alerts if ON.
-        displayMgr.animateFallAlert(vibrate, BTN_POWER); // Pass Power Button as Cancel button
+        displayMgr.startFallAlert(BTN_POWER); // Pass Power Button as Cancel button
         
         activity.clearFallDetected();  // Clear the flag after handling
     }
@@ -253,6 +486,17 @@ void loop()
     checkPowerButton();
     checkSOSButton();
 
+    // Alert animations advance one frame per loop and own the screen while active
+    bool animating = displayMgr.updateAnimation(vibrate);
+    if (displayMgr.takeFallCancelPress())
+    {
+        // The press cancelled the fall alert: keep it from counting as a
+        // power long-press until the button is released
+        pwrIsPressing = true;
+        pwrHandled = true;
+    }
+    trackAlertDrops();
+
     // 3. Main UI Logic (Only runs if Watch is "ON")
     if (watchState.getState())
     {
@@ -273,8 +517,8 @@ void loop()
         }
         lastModeBtnState = currentModeBtn;
 
-        // --- Render Active Screen ---
-        switch (window)
+        // --- Render Active Screen (unless an alert animation is playing) ---
+        switch (animating ? -1 : window)
         {
         case 0: // Clock / Home
             displayMgr.showStartScreen(timeManager.getDateString(), timeManager.getTimeString());
@@ -284,8 +528,7 @@ void loop()
             displayMgr.showHeartRateScreen(hData);
             break;
 
-        case 2:               // Weather
-            weather.update(); // Update sensor data before showing
+        case 2: // Weather
             displayMgr.showWeatherScreen(weather);
             break;
 
@@ -294,7 +537,7 @@ void loop()
             break;
 
         case 4: // Steps
-            displayMgr.showStepsScreen(activity);
+            displayMgr.showStepsScreen(activity, classifier);
             break;
         }
     }
@@ -305,6 +548,9 @@ void loop()
         // (You could add deep sleep logic here later)
     }
 
+    checkHotPathAllocs(allocStart);
+    reportLoopStats(loopStart);
+
     // Small delay to stabilize I2C and loop timing
     delay(10);
 }
\ No newline at end of file
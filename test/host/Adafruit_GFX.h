@@ -0,0 +1,386 @@
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+/*
+  Host Adafruit_GFX (native test env)
+  -----------------------------------
+  In-memory rendering with the same primitive algorithms as Adafruit GFX
+  (Bresenham lines, midpoint circles, scanline triangles) and the classic
+  6x8 text cell with its 5x7 font for printable ASCII (other codes draw
+  blank). Frames rendered here are what the golden hashes in
+  test/test_render are taken from.
+*/
+
+class Print {
+  private:
+    size_t printNumber(unsigned long value) {
+        char text[12];
+        snprintf(text, sizeof(text), "%lu", value);
+        return print(text);
+    }
+
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+
+    size_t write(const char *text) {
+        size_t n = 0;
+        while (*text) n += write((uint8_t)*text++);
+        return n;
+    }
+
+    size_t print(const char *text) { return write(text); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned int value) { return printNumber(value); }
+    size_t print(unsigned long value) { return printNumber(value); }
+    size_t print(int value) { return print((long)value); }
+    size_t print(long value) {
+        if (value >= 0) return printNumber((unsigned long)value);
+        return write('-') + printNumber((unsigned long)(-value));
+    }
+
+    // Arduino Print::printFloat: round, integer part, then digit by digit
+    size_t print(double number, int digits = 2) {
+        if (isnan(number)) return print("nan");
+        if (isinf(number)) return print("inf");
+        if (number > 4294967040.0 || number < -4294967040.0) return print("ovf");
+        size_t n = 0;
+        if (number < 0.0) {
+            n += write('-');
+            number = -number;
+        }
+        double rounding = 0.5;
+        for (int i = 0; i < digits; i++) rounding /= 10.0;
+        number += rounding;
+
+        unsigned long whole = (unsigned long)number;
+        double remainder = number - (double)whole;
+        n += printNumber(whole);
+        if (digits > 0) n += write('.');
+        while (digits-- > 0) {
+            remainder *= 10.0;
+            unsigned int digit = (unsigned int)remainder;
+            n += printNumber(digit);
+            remainder -= digit;
+        }
+        return n;
+    }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T value) { return print(value) + println(); }
+};
+
+// 5x7 columns (LSB at the top) for ' ' .. '~'
+static const uint8_t HOST_GFX_FONT[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5F, 0x00, 0x00, 0x00, 0x07, 0x00, 0x07, 0x00,
+    0x14, 0x7F, 0x14, 0x7F, 0x14, 0x24, 0x2A, 0x7F, 0x2A, 0x12, 0x23, 0x13, 0x08, 0x64, 0x62,
+    0x36, 0x49, 0x56, 0x20, 0x50, 0x00, 0x08, 0x07, 0x03, 0x00, 0x00, 0x1C, 0x22, 0x41, 0x00,
+    0x00, 0x41, 0x22, 0x1C, 0x00, 0x2A, 0x1C, 0x7F, 0x1C, 0x2A, 0x08, 0x08, 0x3E, 0x08, 0x08,
+    0x00, 0x80, 0x70, 0x30, 0x00, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x60, 0x60, 0x00,
+    0x20, 0x10, 0x08, 0x04, 0x02, 0x3E, 0x51, 0x49, 0x45, 0x3E, 0x00, 0x42, 0x7F, 0x40, 0x00,
+    0x72, 0x49, 0x49, 0x49, 0x46, 0x21, 0x41, 0x49, 0x4D, 0x33, 0x18, 0x14, 0x12, 0x7F, 0x10,
+    0x27, 0x45, 0x45, 0x45, 0x39, 0x3C, 0x4A, 0x49, 0x49, 0x31, 0x41, 0x21, 0x11, 0x09, 0x07,
+    0x36, 0x49, 0x49, 0x49, 0x36, 0x46, 0x49, 0x49, 0x29, 0x1E, 0x00, 0x00, 0x14, 0x00, 0x00,
+    0x00, 0x40, 0x34, 0x00, 0x00, 0x00, 0x08, 0x14, 0x22, 0x41, 0x14, 0x14, 0x14, 0x14, 0x14,
+    0x00, 0x41, 0x22, 0x14, 0x08, 0x02, 0x01, 0x59, 0x09, 0x06, 0x3E, 0x41, 0x5D, 0x59, 0x4E,
+    0x7C, 0x12, 0x11, 0x12, 0x7C, 0x7F, 0x49, 0x49, 0x49, 0x36, 0x3E, 0x41, 0x41, 0x41, 0x22,
+    0x7F, 0x41, 0x41, 0x41, 0x3E, 0x7F, 0x49, 0x49, 0x49, 0x41, 0x7F, 0x09, 0x09, 0x09, 0x01,
+    0x3E, 0x41, 0x41, 0x51, 0x73, 0x7F, 0x08, 0x08, 0x08, 0x7F, 0x00, 0x41, 0x7F, 0x41, 0x00,
+    0x20, 0x40, 0x41, 0x3F, 0x01, 0x7F, 0x08, 0x14, 0x22, 0x41, 0x7F, 0x40, 0x40, 0x40, 0x40,
+    0x7F, 0x02, 0x1C, 0x02, 0x7F, 0x7F, 0x04, 0x08, 0x10, 0x7F, 0x3E, 0x41, 0x41, 0x41, 0x3E,
+    0x7F, 0x09, 0x09, 0x09, 0x06, 0x3E, 0x41, 0x51, 0x21, 0x5E, 0x7F, 0x09, 0x19, 0x29, 0x46,
+    0x26, 0x49, 0x49, 0x49, 0x32, 0x03, 0x01, 0x7F, 0x01, 0x03, 0x3F, 0x40, 0x40, 0x40, 0x3F,
+    0x1F, 0x20, 0x40, 0x20, 0x1F, 0x3F, 0x40, 0x38, 0x40, 0x3F, 0x63, 0x14, 0x08, 0x14, 0x63,
+    0x03, 0x04, 0x78, 0x04, 0x03, 0x61, 0x59, 0x49, 0x4D, 0x43, 0x00, 0x7F, 0x41, 0x41, 0x41,
+    0x02, 0x04, 0x08, 0x10, 0x20, 0x00, 0x41, 0x41, 0x41, 0x7F, 0x04, 0x02, 0x01, 0x02, 0x04,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x03, 0x07, 0x08, 0x00, 0x20, 0x54, 0x54, 0x78, 0x40,
+    0x7F, 0x28, 0x44, 0x44, 0x38, 0x38, 0x44, 0x44, 0x44, 0x28, 0x38, 0x44, 0x44, 0x28, 0x7F,
+    0x38, 0x54, 0x54, 0x54, 0x18, 0x00, 0x08, 0x7E, 0x09, 0x02, 0x18, 0xA4, 0xA4, 0x9C, 0x78,
+    0x7F, 0x08, 0x04, 0x04, 0x78, 0x00, 0x44, 0x7D, 0x40, 0x00, 0x20, 0x40, 0x40, 0x3D, 0x00,
+    0x7F, 0x10, 0x28, 0x44, 0x00, 0x00, 0x41, 0x7F, 0x40, 0x00, 0x7C, 0x04, 0x78, 0x04, 0x78,
+    0x7C, 0x08, 0x04, 0x04, 0x78, 0x38, 0x44, 0x44, 0x44, 0x38, 0xFC, 0x18, 0x24, 0x24, 0x18,
+    0x18, 0x24, 0x24, 0x18, 0xFC, 0x7C, 0x08, 0x04, 0x04, 0x08, 0x48, 0x54, 0x54, 0x54, 0x24,
+    0x04, 0x04, 0x3F, 0x44, 0x24, 0x3C, 0x40, 0x40, 0x20, 0x7C, 0x1C, 0x20, 0x40, 0x20, 0x1C,
+    0x3C, 0x40, 0x30, 0x40, 0x3C, 0x44, 0x28, 0x10, 0x28, 0x44, 0x4C, 0x90, 0x90, 0x90, 0x7C,
+    0x44, 0x64, 0x54, 0x4C, 0x44, 0x00, 0x08, 0x36, 0x41, 0x00, 0x00, 0x00, 0x77, 0x00, 0x00,
+    0x00, 0x41, 0x36, 0x08, 0x00, 0x02, 0x01, 0x02, 0x04, 0x02
+};
+
+class Adafruit_GFX : public Print {
+  protected:
+    int16_t WIDTH, HEIGHT;
+    int16_t cursorX = 0, cursorY = 0;
+    uint16_t textColor = 0xFFFF, textBgColor = 0xFFFF;
+    uint8_t textSize = 1;
+    bool wrap = true;
+
+    static void swap16(int16_t &a, int16_t &b) {
+        int16_t t = a;
+        a = b;
+        b = t;
+    }
+
+    void fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta,
+                          uint16_t color) {
+        int16_t f = 1 - r;
+        int16_t ddFx = 1;
+        int16_t ddFy = -2 * r;
+        int16_t x = 0;
+        int16_t y = r;
+        int16_t px = x;
+        int16_t py = y;
+
+        delta++; // Avoid some +1's in the loop
+        while (x < y) {
+            if (f >= 0) {
+                y--;
+                ddFy += 2;
+                f += ddFy;
+            }
+            x++;
+            ddFx += 2;
+            f += ddFx;
+            // These checks avoid double-drawing certain lines
+            if (x < (y + 1)) {
+                if (corners & 1) drawFastVLine(x0 + x, y0 - y, 2 * y + delta, color);
+                if (corners & 2) drawFastVLine(x0 - x, y0 - y, 2 * y + delta, color);
+            }
+            if (y != py) {
+                if (corners & 1) drawFastVLine(x0 + py, y0 - px, 2 * px + delta, color);
+                if (corners & 2) drawFastVLine(x0 - py, y0 - px, 2 * px + delta, color);
+                py = y;
+            }
+            px = x;
+        }
+    }
+
+  public:
+    Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    int16_t width() const { return WIDTH; }
+    int16_t height() const { return HEIGHT; }
+
+    // --- LINES ---
+    void writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+        bool steep = abs(y1 - y0) > abs(x1 - x0);
+        if (steep) {
+            swap16(x0, y0);
+            swap16(x1, y1);
+        }
+        if (x0 > x1) {
+            swap16(x0, x1);
+            swap16(y0, y1);
+        }
+
+        int16_t dx = x1 - x0;
+        int16_t dy = abs(y1 - y0);
+        int16_t err = dx / 2;
+        int16_t ystep = (y0 < y1) ? 1 : -1;
+
+        for (; x0 <= x1; x0++) {
+            if (steep) drawPixel(y0, x0, color);
+            else drawPixel(x0, y0, color);
+            err -= dy;
+            if (err < 0) {
+                y0 += ystep;
+                err += dx;
+            }
+        }
+    }
+
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+        writeLine(x, y, x, y + h - 1, color);
+    }
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+        writeLine(x, y, x + w - 1, y, color);
+    }
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+        if (x0 == x1) {
+            if (y0 > y1) swap16(y0, y1);
+            drawFastVLine(x0, y0, y1 - y0 + 1, color);
+        } else if (y0 == y1) {
+            if (x0 > x1) swap16(x0, x1);
+            drawFastHLine(x0, y0, x1 - x0 + 1, color);
+        } else {
+            writeLine(x0, y0, x1, y1, color);
+        }
+    }
+
+    // --- RECTANGLES ---
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        for (int16_t i = x; i < x + w; i++) drawFastVLine(i, y, h, color);
+    }
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        drawFastHLine(x, y, w, color);
+        drawFastHLine(x, y + h - 1, w, color);
+        drawFastVLine(x, y, h, color);
+        drawFastVLine(x + w - 1, y, h, color);
+    }
+
+    void fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
+        int16_t maxRadius = ((w < h) ? w : h) / 2;
+        if (r > maxRadius) r = maxRadius;
+        fillRect(x + r, y, w - 2 * r, h, color);
+        fillCircleHelper(x + w - r - 1, y + r, r, 1, h - 2 * r - 1, color);
+        fillCircleHelper(x + r, y + r, r, 2, h - 2 * r - 1, color);
+    }
+
+    // --- CIRCLES ---
+    void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+        int16_t f = 1 - r;
+        int16_t ddFx = 1;
+        int16_t ddFy = -2 * r;
+        int16_t x = 0;
+        int16_t y = r;
+
+        drawPixel(x0, y0 + r, color);
+        drawPixel(x0, y0 - r, color);
+        drawPixel(x0 + r, y0, color);
+        drawPixel(x0 - r, y0, color);
+
+        while (x < y) {
+            if (f >= 0) {
+                y--;
+                ddFy += 2;
+                f += ddFy;
+            }
+            x++;
+            ddFx += 2;
+            f += ddFx;
+
+            drawPixel(x0 + x, y0 + y, color);
+            drawPixel(x0 - x, y0 + y, color);
+            drawPixel(x0 + x, y0 - y, color);
+            drawPixel(x0 - x, y0 - y, color);
+            drawPixel(x0 + y, y0 + x, color);
+            drawPixel(x0 - y, y0 + x, color);
+            drawPixel(x0 + y, y0 - x, color);
+            drawPixel(x0 - y, y0 - x, color);
+        }
+    }
+
+    void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+        drawFastVLine(x0, y0 - r, 2 * r + 1, color);
+        fillCircleHelper(x0, y0, r, 3, 0, color);
+    }
+
+    // --- TRIANGLES ---
+    void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+                      uint16_t color) {
+        drawLine(x0, y0, x1, y1, color);
+        drawLine(x1, y1, x2, y2, color);
+        drawLine(x2, y2, x0, y0, color);
+    }
+
+    void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+                      uint16_t color) {
+        int16_t a, b, y, last;
+
+        // Sort coordinates by Y order (y2 >= y1 >= y0)
+        if (y0 > y1) { swap16(y0, y1); swap16(x0, x1); }
+        if (y1 > y2) { swap16(y2, y1); swap16(x2, x1); }
+        if (y0 > y1) { swap16(y0, y1); swap16(x0, x1); }
+
+        if (y0 == y2) { // All on the same line
+            a = b = x0;
+            if (x1 < a) a = x1;
+            else if (x1 > b) b = x1;
+            if (x2 < a) a = x2;
+            else if (x2 > b) b = x2;
+            drawFastHLine(a, y0, b - a + 1, color);
+            return;
+        }
+
+        int16_t dx01 = x1 - x0, dy01 = y1 - y0, dx02 = x2 - x0, dy02 = y2 - y0,
+                dx12 = x2 - x1, dy12 = y2 - y1;
+        int32_t sa = 0, sb = 0;
+
+        // Upper part: scanlines y0..y1 (y1 skipped unless the bottom is flat)
+        last = (y1 == y2) ? y1 : y1 - 1;
+        for (y = y0; y <= last; y++) {
+            a = x0 + sa / dy01;
+            b = x0 + sb / dy02;
+            sa += dx01;
+            sb += dx02;
+            if (a > b) swap16(a, b);
+            drawFastHLine(a, y, b - a + 1, color);
+        }
+
+        // Lower part: scanlines y1..y2
+        sa = (int32_t)dx12 * (y - y1);
+        sb = (int32_t)dx02 * (y - y0);
+        for (; y <= y2; y++) {
+            a = x1 + sa / dy12;
+            b = x0 + sb / dy02;
+            sa += dx12;
+            sb += dx02;
+            if (a > b) swap16(a, b);
+            drawFastHLine(a, y, b - a + 1, color);
+        }
+    }
+
+    // --- TEXT ---
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size) {
+        if (x >= WIDTH || y >= HEIGHT || (x + 6 * size - 1) < 0 || (y + 8 * size - 1) < 0) return;
+
+        for (int8_t i = 0; i < 5; i++) {
+            uint8_t line = (c >= ' ' && c <= '~') ? HOST_GFX_FONT[(c - ' ') * 5 + i] : 0;
+            for (int8_t j = 0; j < 8; j++, line >>= 1) {
+                if (line & 1) {
+                    if (size == 1) drawPixel(x + i, y + j, color);
+                    else fillRect(x + i * size, y + j * size, size, size, color);
+                } else if (bg != color) {
+                    if (size == 1) drawPixel(x + i, y + j, bg);
+                    else fillRect(x + i * size, y + j * size, size, size, bg);
+                }
+            }
+        }
+        if (bg != color) { // Spacing column
+            if (size == 1) drawFastVLine(x + 5, y, 8, bg);
+            else fillRect(x + 5 * size, y, size, 8 * size, bg);
+        }
+    }
+
+    size_t write(uint8_t c) override {
+        if (c == '\n') {
+            cursorX = 0;
+            cursorY += textSize * 8;
+        } else if (c != '\r') {
+            if (wrap && (cursorX + textSize * 6 > WIDTH)) {
+                cursorX = 0;
+                cursorY += textSize * 8;
+            }
+            drawChar(cursorX, cursorY, c, textColor, textBgColor, textSize);
+            cursorX += textSize * 6;
+        }
+        return 1;
+    }
+    using Print::write;
+
+    void setCursor(int16_t x, int16_t y) {
+        cursorX = x;
+        cursorY = y;
+    }
+
+    void setTextSize(uint8_t size) { textSize = size ? size : 1; }
+
+    // Background = foreground: transparent text
+    void setTextColor(uint16_t color) { textColor = textBgColor = color; }
+    void setTextColor(uint16_t color, uint16_t bg) {
+        textColor = color;
+        textBgColor = bg;
+    }
+
+    void setTextWrap(bool w) { wrap = w; }
+    int16_t getCursorX() const { return cursorX; }
+    int16_t getCursorY() const { return cursorY; }
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef HOST_ADAFRUIT_SH110X_H
+#define HOST_ADAFRUIT_SH110X_H
+
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+
+/*
+  Host Adafruit_SH110X (native test env)
+  --------------------------------------
+  The 128x64 page-layout framebuffer of the Adafruit driver, talking to
+  HostSH1106Panel over the Wire shim: begin() probes the address,
+  display() sends every page and invertDisplay() sends 0xA6 / 0xA7.
+  - HostSH1106Panel models the controller RAM (132 columns, the panel
+    showing columns 2..129), page / column addressing with auto-increment
+    and the inversion flag, so a test can check what reached the panel
+*/
+
+#define SH110X_BLACK 0
+#define SH110X_WHITE 1
+#define SH110X_INVERSE 2
+
+#define SH1106_RAM_COLUMNS 132
+#define SH1106_PAGES 8
+#define SH1106_COLUMN_OFFSET 2
+
+class HostSH1106Panel : public HostI2CDevice {
+  public:
+    uint8_t ram[SH1106_PAGES][SH1106_RAM_COLUMNS] = {};
+    uint8_t page = 0;
+    uint8_t column = 0;
+    bool inverted = false;
+    uint32_t dataBytes = 0;     // Pixel bytes written
+    uint32_t writes = 0;        // Write transactions
+
+    void receive(const uint8_t *data, size_t length) override {
+        if (length == 0) return;
+        writes++;
+        if (data[0] == 0x40) {  // Data stream
+            for (size_t i = 1; i < length; i++) {
+                if (column < SH1106_RAM_COLUMNS) ram[page][column] = data[i];
+                column++;
+                dataBytes++;
+            }
+            return;
+        }
+        for (size_t i = 1; i < length; i++) { // Command stream
+            uint8_t cmd = data[i];
+            if (cmd <= 0x0F) column = (column & 0xF0) | cmd;
+            else if (cmd <= 0x1F) column = (uint8_t)(((cmd & 0x0F) << 4) | (column & 0x0F));
+            else if (cmd >= 0xB0 && cmd <= 0xB7) page = cmd & 0x07;
+            else if (cmd == 0xA6) inverted = false;
+            else if (cmd == 0xA7) inverted = true;
+        }
+    }
+
+    void request(uint8_t *data, size_t length) override { memset(data, 0, length); }
+
+    // What the panel shows, in the framebuffer's page layout
+    void visible(uint8_t *out, uint8_t width) {
+        for (uint8_t p = 0; p < SH1106_PAGES; p++) {
+            memcpy(&out[p * width], &ram[p][SH1106_COLUMN_OFFSET], width);
+        }
+    }
+};
+
+class Adafruit_SH110X : public Adafruit_GFX {
+  protected:
+    TwoWire *wire;
+    uint8_t address = 0x3C;
+    uint8_t *buffer;
+    uint8_t pageOffset = 0;
+
+    bool command(uint8_t cmd) {
+        wire->beginTransmission(address);
+        wire->write((uint8_t)0x00);
+        wire->write(cmd);
+        return wire->endTransmission() == 0;
+    }
+
+  public:
+    Adafruit_SH110X(uint16_t w, uint16_t h, TwoWire *twi, int8_t)
+        : Adafruit_GFX(w, h), wire(twi) {
+        buffer = new uint8_t[w * ((h + 7) / 8)];
+        clearDisplay();
+    }
+
+    bool begin(uint8_t addr = 0x3C, bool = true) {
+        address = addr;
+        clearDisplay();
+        return command(0xAF); // Display on
+    }
+
+    void clearDisplay() { memset(buffer, 0, WIDTH * ((HEIGHT + 7) / 8)); }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) return;
+        uint8_t &b = buffer[x + (y / 8) * WIDTH];
+        uint8_t bit = 1 << (y & 7);
+        switch (color) {
+        case SH110X_WHITE:   b |= bit; break;
+        case SH110X_BLACK:   b &= ~bit; break;
+        case SH110X_INVERSE: b ^= bit; break;
+        }
+    }
+
+    bool getPixel(int16_t x, int16_t y) {
+        if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) return false;
+        return buffer[x + (y / 8) * WIDTH] & (1 << (y & 7));
+    }
+
+    uint8_t *getBuffer() { return buffer; }
+
+    void display() {
+        for (uint8_t p = 0; p < HEIGHT / 8; p++) {
+            wire->beginTransmission(address);
+            wire->write((uint8_t)0x00);
+            wire->write((uint8_t)(0xB0 | p));
+            wire->write((uint8_t)(0x10 | (pageOffset >> 4)));
+            wire->write((uint8_t)(pageOffset & 0x0F));
+            wire->endTransmission();
+
+            const uint8_t *row = &buffer[p * WIDTH];
+            for (int16_t x = 0; x < WIDTH; x += I2C_BUFFER_LENGTH - 1) {
+                int16_t length = WIDTH - x;
+                if (length > I2C_BUFFER_LENGTH - 1) length = I2C_BUFFER_LENGTH - 1;
+                wire->beginTransmission(address);
+                wire->write((uint8_t)0x40);
+                wire->write(&row[x], length);
+                wire->endTransmission();
+            }
+        }
+    }
+
+    void invertDisplay(bool i) { command(i ? 0xA7 : 0xA6); }
+};
+
+class Adafruit_SH1106G : public Adafruit_SH110X {
+  public:
+    Adafruit_SH1106G(uint16_t w, uint16_t h, TwoWire *twi, int8_t rst)
+        : Adafruit_SH110X(w, h, twi, rst) {
+        pageOffset = SH1106_COLUMN_OFFSET;
+    }
+};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include "HostRTOS.h"
+
+/*
+  Host Arduino shim (native test env)
+  -----------------------------------
+  Just enough of the Arduino core for the header-only modules.
+  - millis() is simulated time: tests set or advance it (delay() advances it)
+  - micros() and ESP.getCycleCount() read the host's steady clock, so cost
+    figures (ns/sample, cycles/sample) are real host measurements
+  - Serial prints to stdout
+  - Pins are an array the test sets (digitalRead) or inspects (digitalWrite);
+    interrupts are never raised
+  - FreeRTOS comes from HostRTOS.h
+*/
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+#define IRAM_ATTR
+#define F(text) (text)
+
+template <typename T> T constrain(T value, T low, T high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+inline uint32_t &hostMillis() {
+    static uint32_t ms = 0;
+    return ms;
+}
+
+inline void setMillis(uint32_t ms) { hostMillis() = ms; }
+inline void advanceMillis(uint32_t ms) { hostMillis() += ms; }
+
+inline unsigned long millis() { return hostMillis(); }
+inline void delay(unsigned long ms) { hostMillis() += (uint32_t)ms; }
+
+inline uint64_t hostNanos() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// --- PINS ---
+#define HOST_PINS 64
+
+inline int *hostPins() {
+    static int pins[HOST_PINS] = {};
+    return pins;
+}
+
+inline void setPin(int pin, int level) { if (pin >= 0 && pin < HOST_PINS) hostPins()[pin] = level; }
+inline void pinMode(int, int) {}
+inline int digitalRead(int pin) { return (pin >= 0 && pin < HOST_PINS) ? hostPins()[pin] : LOW; }
+inline void digitalWrite(int pin, int level) { setPin(pin, level); }
+inline int analogRead(int) { return 0; }
+inline int8_t digitalPinToAnalogChannel(uint8_t) { return -1; }
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterruptArg(int, void (*)(void *), void *, int) {}
+inline void detachInterrupt(int) {}
+
+inline unsigned long micros() { return (unsigned long)(hostNanos() / 1000); }
+inline void delayMicroseconds(unsigned int) {}
+
+// One "cycle" per host nanosecond
+struct HostEsp {
+    uint32_t getCycleCount() { return (uint32_t)hostNanos(); }
+    uint32_t getFreeHeap() { return 0; }
+};
+static HostEsp ESP __attribute__((unused));
+
+struct HostSerial {
+    void begin(unsigned long) {}
+    int printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        int n = vprintf(format, args);
+        va_end(args);
+        return n;
+    }
+    void print(const char *s) { fputs(s, stdout); }
+    void print(long v) { printf("%ld", v); }
+    void print(int v) { printf("%d", v); }
+    void print(unsigned v) { printf("%u", v); }
+    void print(unsigned long v) { printf("%lu", v); }
+    void print(double v) { printf("%.2f", v); }
+    void println() { putchar('\n'); }
+    template <typename T> void println(T v) { print(v); println(); }
+};
+static HostSerial Serial __attribute__((unused));
+
+#endif
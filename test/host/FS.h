@@ -0,0 +1,111 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+  Host FS shim (native test env)
+  ------------------------------
+  A flat in-memory file system behind the Arduino fs::FS / fs::File API.
+  - FILE_WRITE truncates, FILE_APPEND appends, FILE_READ reads from 0
+  - Files live until remove() or the end of the test binary
+  - setCapacity() bounds the total size: a write past it is cut short,
+    as on a full flash
+*/
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+typedef std::shared_ptr<std::vector<uint8_t> > HostFileData;
+
+class FS;
+
+class File {
+  private:
+    HostFileData data;
+    size_t position = 0;
+    FS *owner = nullptr;
+
+  public:
+    File() {}
+    File(HostFileData d, size_t pos, FS *fs) : data(d), position(pos), owner(fs) {}
+
+    size_t write(const uint8_t *buffer, size_t length);
+
+    size_t read(uint8_t *buffer, size_t length) {
+        if (!data) return 0;
+        size_t n = (position + length > data->size()) ? data->size() - position : length;
+        memcpy(buffer, data->data() + position, n);
+        position += n;
+        return n;
+    }
+
+    int available() { return data ? (int)(data->size() - position) : 0; }
+    bool seek(uint32_t pos) {
+        if (!data || pos > data->size()) return false;
+        position = pos;
+        return true;
+    }
+    size_t size() { return data ? data->size() : 0; }
+    void close() { data.reset(); }
+    operator bool() const { return (bool)data; }
+};
+
+class FS {
+  protected:
+    std::map<std::string, HostFileData> files;
+    size_t capacity = (size_t)-1;
+
+  public:
+    File open(const char *path, const char *mode = FILE_READ) {
+        std::map<std::string, HostFileData>::iterator it = files.find(path);
+        if (mode[0] == 'r') return (it == files.end()) ? File() : File(it->second, 0, this);
+        if (it == files.end() || mode[0] == 'w') {
+            files[path] = HostFileData(new std::vector<uint8_t>());
+            it = files.find(path);
+        }
+        return File(it->second, it->second->size(), this);
+    }
+
+    bool exists(const char *path) { return files.count(path) > 0; }
+    bool remove(const char *path) { return files.erase(path) > 0; }
+
+    void setCapacity(size_t bytes) { capacity = bytes; }
+    size_t usedBytes() {
+        size_t used = 0;
+        for (std::map<std::string, HostFileData>::iterator it = files.begin(); it != files.end(); ++it) {
+            used += it->second->size();
+        }
+        return used;
+    }
+    size_t freeBytes() {
+        size_t used = usedBytes();
+        return (capacity > used) ? capacity - used : 0;
+    }
+};
+
+inline size_t File::write(const uint8_t *buffer, size_t length) {
+    if (!data) return 0;
+    if (position + length > data->size()) {
+        size_t grow = position + length - data->size();
+        size_t room = owner ? owner->freeBytes() : grow;
+        if (grow > room) length -= grow - room;
+        data->resize(position + length);
+    }
+    memcpy(data->data() + position, buffer, length);
+    position += length;
+    return length;
+}
+
+} // namespace fs
+
+using fs::File;
+
+#endif
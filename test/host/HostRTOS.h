@@ -0,0 +1,164 @@
+#ifndef HOST_RTOS_H
+#define HOST_RTOS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+  Host FreeRTOS shim (native test env)
+  ------------------------------------
+  The subset the modules use, on std::thread: tasks, task notifications,
+  queues, recursive mutexes and critical sections.
+  - Ticks are milliseconds of real time (not the simulated millis()), so
+    the I2C bus and flush tasks run concurrently with the test as on target
+  - Tasks are detached threads that run until the test process exits
+  - Core affinity and priorities are ignored
+  - hostTaskCreateFails() makes task creation fail (fallback paths)
+*/
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xffffffffu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+struct HostTask {
+    std::mutex lock;
+    std::condition_variable wake;
+    uint32_t notifications = 0;
+};
+typedef HostTask *TaskHandle_t;
+
+struct HostQueue {
+    std::mutex lock;
+    std::deque<std::vector<uint8_t> > items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+};
+typedef HostQueue *QueueHandle_t;
+
+typedef std::recursive_mutex *SemaphoreHandle_t;
+
+// The task the calling thread runs as (the test's own thread included)
+inline TaskHandle_t &hostCurrentTask() {
+    static thread_local TaskHandle_t task = nullptr;
+    return task;
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    TaskHandle_t &task = hostCurrentTask();
+    if (!task) task = new HostTask();
+    return task;
+}
+
+inline bool &hostTaskCreateFails() {
+    static bool fails = false;
+    return fails;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(void (*entry)(void *), const char *, uint32_t, void *arg,
+                                          UBaseType_t, TaskHandle_t *handle, BaseType_t) {
+    if (hostTaskCreateFails()) return pdFAIL;
+    TaskHandle_t task = new HostTask();
+    if (handle) *handle = task;
+    std::thread([entry, arg, task]() {
+        hostCurrentTask() = task;
+        entry(arg);
+    }).detach();
+    return pdPASS;
+}
+
+inline void xTaskNotifyGive(TaskHandle_t task) {
+    if (!task) return;
+    std::lock_guard<std::mutex> guard(task->lock);
+    task->notifications++;
+    task->wake.notify_one();
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> guard(task->lock);
+    if (ticks == portMAX_DELAY) {
+        task->wake.wait(guard, [task]() { return task->notifications > 0; });
+    } else {
+        task->wake.wait_for(guard, std::chrono::milliseconds(ticks),
+                            [task]() { return task->notifications > 0; });
+    }
+    uint32_t count = task->notifications;
+    if (count) task->notifications = clearOnExit ? 0 : count - 1;
+    return count;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline TickType_t xTaskGetTickCount() {
+    return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void vTaskDelayUntil(TickType_t *wake, TickType_t period) {
+    *wake += period;
+    int32_t wait = (int32_t)(*wake - xTaskGetTickCount());
+    if (wait > 0) vTaskDelay(wait);
+}
+
+// --- QUEUES (non-blocking use only) ---
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    QueueHandle_t queue = new HostQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    if (queue->items.size() >= queue->length) return pdFALSE;
+    const uint8_t *bytes = (const uint8_t *)item;
+    queue->items.push_back(std::vector<uint8_t>(bytes, bytes + queue->itemSize));
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    if (queue->items.empty()) return pdFALSE;
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    return pdTRUE;
+}
+
+// --- MUTEXES ---
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return new std::recursive_mutex(); }
+
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t) {
+    mutex->lock();
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex) {
+    mutex->unlock();
+    return pdTRUE;
+}
+
+// --- CRITICAL SECTIONS ---
+struct HostMux {
+    std::mutex lock;
+};
+typedef HostMux portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) (mux)->lock.lock()
+#define portEXIT_CRITICAL(mux) (mux)->lock.unlock()
+
+#endif
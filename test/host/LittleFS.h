@@ -0,0 +1,24 @@
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+#include <FS.h>
+
+/*
+  Host LittleFS (native test env)
+  -------------------------------
+  The in-memory FS shim; begin() always mounts, the size is nominal
+  (HOST_LITTLEFS_BYTES, setCapacity() to shrink it).
+*/
+
+#define HOST_LITTLEFS_BYTES (1024 * 1024)
+
+class LittleFSFS : public fs::FS {
+  public:
+    LittleFSFS() { capacity = HOST_LITTLEFS_BYTES; }
+    bool begin(bool = false) { return true; }
+    size_t totalBytes() { return capacity; }
+};
+
+static LittleFSFS LittleFS __attribute__((unused));
+
+#endif
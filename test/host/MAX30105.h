@@ -0,0 +1,25 @@
+#ifndef HOST_MAX30105_H
+#define HOST_MAX30105_H
+
+#include <Wire.h>
+
+/*
+  Host MAX30105 (native test env)
+  -------------------------------
+  Configuration calls only; samples come through the I2C bus registers.
+*/
+
+#define I2C_SPEED_STANDARD 100000
+#define I2C_SPEED_FAST 400000
+
+class MAX30105 {
+  public:
+    bool begin(TwoWire &, uint32_t = I2C_SPEED_STANDARD, uint8_t = 0x57) { return true; }
+    void setup(byte = 0x1F, byte = 4, byte = 3, int = 400, int = 411, int = 4096) {}
+    void setPulseAmplitudeRed(uint8_t) {}
+    void setPulseAmplitudeIR(uint8_t) {}
+    void setPulseAmplitudeGreen(uint8_t) {}
+    void clearFIFO() {}
+};
+
+#endif
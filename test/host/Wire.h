@@ -0,0 +1,103 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+/*
+  Host Wire shim (native test env)
+  --------------------------------
+  An I2C bus with simulated devices attached by address.
+  - A write is delivered to the device when the transmission ends; an
+    address with no device NACKs, like an unplugged sensor
+  - HostRegisterDevice is a plain register file (auto-incrementing
+    pointer), enough for sensors read with register bursts
+*/
+
+#define I2C_BUFFER_LENGTH 128
+#define HOST_WIRE_ADDRESSES 128
+
+class HostI2CDevice {
+  public:
+    virtual ~HostI2CDevice() {}
+    // One complete write transaction
+    virtual void receive(const uint8_t *data, size_t length) = 0;
+    // Bytes for a read transaction
+    virtual void request(uint8_t *data, size_t length) = 0;
+};
+
+class HostRegisterDevice : public HostI2CDevice {
+  public:
+    uint8_t regs[256] = {};
+    uint8_t pointer = 0;
+
+    void receive(const uint8_t *data, size_t length) override {
+        if (length == 0) return;
+        pointer = data[0];
+        for (size_t i = 1; i < length; i++) regs[pointer++] = data[i];
+    }
+
+    void request(uint8_t *data, size_t length) override {
+        for (size_t i = 0; i < length; i++) data[i] = regs[pointer++];
+    }
+};
+
+class TwoWire {
+  private:
+    HostI2CDevice *devices[HOST_WIRE_ADDRESSES] = {};
+    uint32_t clock = 100000;
+    uint8_t address = 0;
+    uint8_t txBuffer[I2C_BUFFER_LENGTH + 1];
+    size_t txLength = 0;
+    uint8_t rxBuffer[I2C_BUFFER_LENGTH];
+    size_t rxLength = 0;
+    size_t rxIndex = 0;
+
+  public:
+    void attach(uint8_t addr, HostI2CDevice *device) { devices[addr & 0x7F] = device; }
+
+    bool begin(int = -1, int = -1, uint32_t = 0) { return true; }
+    void setClock(uint32_t hz) { clock = hz; }
+    uint32_t getClock() { return clock; }
+
+    void beginTransmission(uint8_t addr) {
+        address = addr & 0x7F;
+        txLength = 0;
+    }
+
+    size_t write(uint8_t value) {
+        if (txLength >= sizeof(txBuffer)) return 0;
+        txBuffer[txLength++] = value;
+        return 1;
+    }
+
+    size_t write(const uint8_t *data, size_t length) {
+        size_t n = 0;
+        while (n < length && write(data[n])) n++;
+        return n;
+    }
+
+    uint8_t endTransmission(bool = true) {
+        HostI2CDevice *device = devices[address];
+        if (!device) return 2;
+        device->receive(txBuffer, txLength);
+        return 0;
+    }
+
+    uint8_t requestFrom(uint8_t addr, uint8_t length, bool = true) {
+        HostI2CDevice *device = devices[addr & 0x7F];
+        rxLength = 0;
+        rxIndex = 0;
+        if (!device) return 0;
+        if (length > I2C_BUFFER_LENGTH) length = I2C_BUFFER_LENGTH;
+        device->request(rxBuffer, length);
+        rxLength = length;
+        return length;
+    }
+
+    int available() { return (int)(rxLength - rxIndex); }
+    int read() { return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1; }
+};
+
+static TwoWire Wire __attribute__((unused));
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef HOST_ESP_DSP_H
+#define HOST_ESP_DSP_H
+
+#include <stdint.h>
+
+/*
+  Host esp-dsp shim (native test env)
+  -----------------------------------
+  The two fixed-point calls AccelKernel uses, as esp-dsp's ANSI reference
+  implementations (dsps_mul_s16_ansi / dsps_add_s16_ansi): 32-bit
+  product or sum, arithmetic shift right, truncated to int16. The PIE
+  versions on the S3 are checked against the scalar path on target by
+  AccelKernel::selfCheck()
+*/
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+inline esp_err_t dsps_mul_s16(const int16_t *input1, const int16_t *input2, int16_t *output, int len,
+                              int step1, int step2, int step_out, int shift) {
+    for (int i = 0; i < len; i++) {
+        int32_t acc = (int32_t)input1[i * step1] * (int32_t)input2[i * step2];
+        output[i * step_out] = (int16_t)(acc >> shift);
+    }
+    return ESP_OK;
+}
+
+inline esp_err_t dsps_add_s16(const int16_t *input1, const int16_t *input2, int16_t *output, int len,
+                              int step1, int step2, int step_out, int shift) {
+    for (int i = 0; i < len; i++) {
+        int32_t acc = (int32_t)input1[i * step1] + (int32_t)input2[i * step2];
+        output[i * step_out] = (int16_t)(acc >> shift);
+    }
+    return ESP_OK;
+}
+
+#endif
@@ -0,0 +1,105 @@
+#include <unity.h>
+#include <Arduino.h>
+#define ACCEL_KERNEL_DSP
+#include "AccelKernel.h"
+
+/*
+  AccelKernel's esp-dsp path (dsps_mul_s16 / dsps_add_s16 from the host
+  shim, esp-dsp's ANSI reference) against the scalar definition: squared
+  magnitudes, all three masks and the energy must be identical for every
+  block length, full-scale corners (+-32768 on all axes) included.
+*/
+
+#define STEP_LSB 18000
+#define LOW_LSB 6000
+#define HIGH_LSB 26000
+
+static uint32_t seed = 1;
+
+static int16_t nextValue() {
+    static const int16_t corners[] = { -32768, 32767, -32767, 0, 1, -1, 16384, -16384 };
+    seed = seed * 1664525 + 1013904223;
+    // One value in four is a corner, so every block length sees them
+    if ((seed >> 30) == 0) return corners[(seed >> 8) & 7];
+    return (int16_t)(seed >> 12);
+}
+
+static void checkBlock(AccelKernel &kernel, const int16_t *x, const int16_t *y, const int16_t *z, uint8_t n) {
+    AccelBlock out;
+    TEST_ASSERT_TRUE(kernel.isDsp()); // Else process() ran the scalar fallback
+    kernel.process(x, y, z, n, out);
+
+    uint16_t step = accelKernelUnits(STEP_LSB), low = accelKernelUnits(LOW_LSB), high = accelKernelUnits(HIGH_LSB);
+    uint64_t above = 0, below = 0, impact = 0;
+    uint32_t energy = 0;
+    char message[48];
+    TEST_ASSERT_EQUAL(n, out.count);
+    for (uint8_t i = 0; i < n; i++) {
+        uint16_t m = (uint16_t)((((int32_t)x[i] * x[i]) >> ACCEL_KERNEL_SHIFT) +
+                                (((int32_t)y[i] * y[i]) >> ACCEL_KERNEL_SHIFT) +
+                                (((int32_t)z[i] * z[i]) >> ACCEL_KERNEL_SHIFT));
+        snprintf(message, sizeof(message), "n %u sample %u (%d, %d, %d)", n, i, x[i], y[i], z[i]);
+        TEST_ASSERT_EQUAL_MESSAGE(m, out.mag2[i], message);
+        if (m > step) above |= (uint64_t)1 << i;
+        if (m < low) below |= (uint64_t)1 << i;
+        if (m > high) impact |= (uint64_t)1 << i;
+        energy += m;
+    }
+    snprintf(message, sizeof(message), "n %u", n);
+    TEST_ASSERT_TRUE_MESSAGE(above == out.aboveStep, message);
+    TEST_ASSERT_TRUE_MESSAGE(below == out.belowLow, message);
+    TEST_ASSERT_TRUE_MESSAGE(impact == out.aboveHigh, message);
+    TEST_ASSERT_EQUAL_MESSAGE(energy, out.energy, message);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_self_check_selects_dsp() {
+    AccelKernel kernel;
+    kernel.begin(STEP_LSB, LOW_LSB, HIGH_LSB);
+    TEST_ASSERT_TRUE(kernel.selfCheck());
+    TEST_ASSERT_TRUE(kernel.isDsp());
+}
+
+void test_dsp_matches_scalar_for_every_length() {
+    AccelKernel kernel;
+    kernel.begin(STEP_LSB, LOW_LSB, HIGH_LSB);
+    int16_t x[ACCEL_KERNEL_MAX_BLOCK], y[ACCEL_KERNEL_MAX_BLOCK], z[ACCEL_KERNEL_MAX_BLOCK];
+    for (uint8_t n = 1; n <= ACCEL_KERNEL_MAX_BLOCK; n++) {
+        for (uint16_t round = 0; round < 50; round++) {
+            for (uint8_t i = 0; i < n; i++) {
+                x[i] = nextValue();
+                y[i] = nextValue();
+                z[i] = nextValue();
+            }
+            checkBlock(kernel, x, y, z, n);
+        }
+    }
+}
+
+// The largest squared magnitude: -32768 on every axis (3 * 8192)
+void test_full_scale_corners() {
+    AccelKernel kernel;
+    kernel.begin(STEP_LSB, LOW_LSB, HIGH_LSB);
+    static const int16_t corners[] = { -32768, 32767 };
+    int16_t x[8], y[8], z[8];
+    for (uint8_t i = 0; i < 8; i++) {
+        x[i] = corners[i & 1];
+        y[i] = corners[(i >> 1) & 1];
+        z[i] = corners[(i >> 2) & 1];
+    }
+    checkBlock(kernel, x, y, z, 8);
+
+    AccelBlock out;
+    kernel.process(x, y, z, 1, out);
+    TEST_ASSERT_EQUAL(3 * 8192, out.mag2[0]);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_self_check_selects_dsp);
+    RUN_TEST(test_dsp_matches_scalar_for_every_length);
+    RUN_TEST(test_full_scale_corners);
+    return UNITY_END();
+}
@@ -0,0 +1,32 @@
+#include <unity.h>
+#include <Arduino.h>
+#include "AccelReplay.h"
+
+/*
+  AccelReplay's synthetic cases on the host (the esp32-s3-accelreplay boot
+  replay without the recorded episodes): activity labels, and FallDetector
+  on forward fall, trip and slow slump against jump, slap, sitting down
+  hard and running.
+*/
+
+static AccelReplay replay;
+
+void setUp() {}
+void tearDown() {}
+
+void test_activity_cases() {
+    TEST_ASSERT_EQUAL(0, replay.runActivity());
+}
+
+void test_fall_cases() {
+    TEST_ASSERT_EQUAL(0, replay.runFalls());
+    TEST_ASSERT_EQUAL(100, replay.getPrecision());
+    TEST_ASSERT_EQUAL(100, replay.getRecall());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_activity_cases);
+    RUN_TEST(test_fall_cases);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+#include <unity.h>
+#include <Arduino.h>
+#include "AltitudeFusion.h"
+
+/*
+  AltitudeFusion on a simulated walk: 100 Hz accelerometer batches every
+  100 ms, BMP280 altitude at 10 Hz with 0.15 m noise, the device tilted
+  30 degrees. Stairs are 0.2 m/s with 1 s speed ramps and step bounce.
+*/
+
+#define ODR_HZ 100
+#define BATCH 10
+
+struct Leg {
+    float start;    // s
+    float end;
+    float speed;    // m/s, up
+};
+
+class Walk {
+  public:
+    const Leg *legs = nullptr;
+    uint8_t legCount = 0;
+    float weatherDrift = 0;     // m/s of apparent altitude from pressure drift
+    float clockError = 0;       // Accelerometer sample clock rate error (0.02 = 2% fast)
+    bool accelIdle = false;     // No batches at all (MPU6050 FIFO stopped)
+    uint32_t seed = 1;
+
+    float speedAt(float t, bool &onStairs) {
+        onStairs = false;
+        for (uint8_t i = 0; i < legCount; i++) {
+            const Leg &l = legs[i];
+            if (t <= l.start || t >= l.end) continue;
+            onStairs = true;
+            float ramp = fminf(fminf(t - l.start, l.end - t), 1.0f);
+            return l.speed * ramp;
+        }
+        return 0;
+    }
+
+    float noise() {
+        seed = seed * 1664525 + 1013904223;
+        return ((int32_t)(seed >> 8) % 2001 - 1000) / 1000.0f;
+    }
+
+    // Runs to 'seconds'; 'probe' is called every 100 ms
+    template <typename Probe> void run(AltitudeFusion &fusion, float seconds, Probe probe) {
+        AccelSample batch[BATCH];
+        AccelBlock block;
+        float height = 0, lastSpeed = 0;
+        uint8_t count = 0;
+        setMillis(0);
+        for (uint32_t i = 0; i < (uint32_t)(seconds * ODR_HZ); i++) {
+            float t = (float)i / ODR_HZ;
+            bool onStairs;
+            float v = speedAt(t, onStairs);
+            float accel = (v - lastSpeed) * ODR_HZ;
+            lastSpeed = v;
+            height += v / ODR_HZ;
+            if (onStairs) accel += 2.0f * sinf(2 * PI * 1.8f * t);
+
+            setMillis(i * 1000 / ODR_HZ);
+            if (i % (ODR_HZ / 10) == 0) fusion.addBaro(100 + height + weatherDrift * t + 0.15f * noise(), millis());
+            if (i % (ODR_HZ / 10) == 0) probe(t, v);
+            if (accelIdle) continue;
+
+            float g = (ALT_G_MS2 + accel) / ALT_G_MS2 * 16384;
+            batch[count].x = (int16_t)(150 * noise());
+            batch[count].y = (int16_t)(g * 0.5f + 150 * noise());
+            batch[count].z = (int16_t)(g * 0.866f + 150 * noise());
+            batch[count].timeMs = (uint32_t)(5000 + t * 1000 * (1 + clockError));
+            if (++count == BATCH) {
+                block.count = count;
+                fusion.addBlock(batch, block);
+                count = 0;
+            }
+        }
+    }
+
+    void run(AltitudeFusion &fusion, float seconds) {
+        run(fusion, seconds, [](float, float) {});
+    }
+};
+
+// 3 floors up, rest, 2 floors down
+static const Leg STAIRS[] = { { 20, 66, 0.2f }, { 100, 131, -0.2f } };
+
+void setUp() {}
+void tearDown() {}
+
+void test_counts_floors_up_and_down() {
+    AltitudeFusion fusion;
+    fusion.begin();
+    Walk walk;
+    walk.legs = STAIRS;
+    walk.legCount = 2;
+    walk.run(fusion, 160);
+    TEST_ASSERT_EQUAL(3, fusion.getFloorsUp());
+    TEST_ASSERT_EQUAL(2, fusion.getFloorsDown());
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 103.0f, fusion.getAltitude());
+    TEST_ASSERT_LESS_THAN(ALT_FUSION_BUDGET_CYCLES * 10, fusion.getCyclesPerSample()); // Host ns, loose
+}
+
+// The accelerometer's sample clock drifts from millis(); the filter must
+// stay fused (speed from the accelerometer) instead of falling back to
+// barometer only
+static void checkFusedUnderClockError(float clockError) {
+    AltitudeFusion fusion;
+    fusion.begin();
+    Walk walk;
+    walk.legs = STAIRS;
+    walk.legCount = 2;
+    walk.clockError = clockError;
+    // Mean over the middle of the climb (the step bounce averages out)
+    float sum = 0;
+    uint16_t n = 0;
+    walk.run(fusion, 160, [&](float t, float) {
+        if (t > 30 && t < 60) {
+            sum += fusion.getVerticalSpeed();
+            n++;
+        }
+    });
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.2f, sum / n);
+    TEST_ASSERT_EQUAL(3, fusion.getFloorsUp());
+    TEST_ASSERT_EQUAL(2, fusion.getFloorsDown());
+}
+
+void test_fused_with_fast_sample_clock() { checkFusedUnderClockError(0.02f); }
+void test_fused_with_slow_sample_clock() { checkFusedUnderClockError(-0.02f); }
+
+// -3 hPa / 3 h is ~25 m of apparent climb: no floors
+void test_weather_drift_counts_no_floors() {
+    AltitudeFusion fusion;
+    fusion.begin();
+    Walk walk;
+    walk.weatherDrift = 25.0f / (3 * 3600);
+    walk.run(fusion, 3 * 3600);
+    TEST_ASSERT_EQUAL(0, fusion.getFloorsUp());
+    TEST_ASSERT_EQUAL(0, fusion.getFloorsDown());
+}
+
+// Elevator while the MPU6050 FIFO is stopped: barometer only
+void test_barometer_only_when_accel_idle() {
+    static const Leg ELEVATOR[] = { { 10, 25, 1.0f } };
+    AltitudeFusion fusion;
+    fusion.begin();
+    Walk walk;
+    walk.legs = ELEVATOR;
+    walk.legCount = 1;
+    walk.accelIdle = true;
+    walk.run(fusion, 60);
+    TEST_ASSERT_EQUAL(4, fusion.getFloorsUp());
+    TEST_ASSERT_EQUAL(0, fusion.getFloorsDown());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_counts_floors_up_and_down);
+    RUN_TEST(test_fused_with_fast_sample_clock);
+    RUN_TEST(test_fused_with_slow_sample_clock);
+    RUN_TEST(test_weather_drift_counts_no_floors);
+    RUN_TEST(test_barometer_only_when_accel_idle);
+    return UNITY_END();
+}
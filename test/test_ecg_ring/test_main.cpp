@@ -0,0 +1,64 @@
+#include <unity.h>
+#include <Arduino.h>
+#include "ECGManager.h"
+
+/*
+  ECGAcquisition's reader guards on the host (timed sampling task at
+  500 Hz, real time): a reader that fell behind resumes ECG_READ_SLACK
+  samples clear of the writer, and overwritten() reports the samples the
+  writer has reached since they were viewed.
+*/
+
+#define WRAP_WAIT_MS 5000
+
+void setUp() {}
+void tearDown() {}
+
+// Real-time wait until the writer has wrapped the ring by 'extra' samples
+static bool waitForWrap(const ECGAcquisition &acq, uint32_t extra) {
+    for (int waited = 0; waited < WRAP_WAIT_MS; waited++) {
+        if (acq.getWriteSeq() >= ECG_RING_SIZE + extra) return true;
+        vTaskDelay(1);
+    }
+    return false;
+}
+
+void test_safe_seq_keeps_slack() {
+    static ECGAcquisition acq(36, 38, 37);
+    TEST_ASSERT_TRUE(acq.begin(500));
+    TEST_ASSERT_TRUE(waitForWrap(acq, 100));
+
+    uint32_t safe = acq.getSafeSeq();
+    uint32_t write = acq.getWriteSeq();
+    TEST_ASSERT_TRUE(write - safe >= ECG_RING_SIZE - ECG_READ_SLACK);
+    TEST_ASSERT_TRUE(safe - acq.getOldestSeq() >= ECG_READ_SLACK - 8); // A few samples may land in between
+    TEST_ASSERT_EQUAL(0, acq.overwritten(safe, 64));
+
+    // The slot the writer fills next already counts as reached
+    write = acq.getWriteSeq();
+    TEST_ASSERT_TRUE(acq.overwritten(write - ECG_RING_SIZE, 4) >= 1);
+    TEST_ASSERT_EQUAL(16, acq.overwritten(0, 16));
+}
+
+// A detector that fell a whole ring behind counts what it skipped
+void test_manager_counts_skipped_samples() {
+    static ECGManager ecg(36, 38, 37);
+    ecg.begin(500);
+    TEST_ASSERT_TRUE(waitForWrap(ecg.getAcquisition(), ECG_READ_SLACK));
+    uint32_t oldest = ecg.getAcquisition().getOldestSeq();
+    ecg.update();
+    // Resumed ECG_READ_SLACK past the oldest sample, not at it
+    TEST_ASSERT_TRUE(ecg.getMissedSamples() >= oldest + ECG_READ_SLACK);
+
+    uint32_t missed = ecg.getMissedSamples();
+    vTaskDelay(pdMS_TO_TICKS(100));
+    ecg.update();
+    TEST_ASSERT_EQUAL(missed, ecg.getMissedSamples());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_safe_seq_keeps_slack);
+    RUN_TEST(test_manager_counts_skipped_samples);
+    return UNITY_END();
+}
@@ -0,0 +1,131 @@
+#include <unity.h>
+#include <Arduino.h>
+#include "EpisodeRecorder.h"
+
+/*
+  EpisodeRecorder on the in-memory LittleFS: accelerometer and PPG at
+  100 Hz, no ECG (its channel closes at the grace timeout).
+  - Rotation: more episodes than slots keep the newest EPISODE_SLOTS, and
+    a new recorder resumes after the newest sequence
+  - Free space: old episodes are dropped until EPISODE_MIN_FREE is free
+  - A short flash write ends the episode early, counted as truncated
+*/
+
+#define STEP_MS 10
+
+void setUp() {
+    for (uint16_t slot = 0; slot < EPISODE_SLOTS; slot++) {
+        char path[20];
+        snprintf(path, sizeof(path), "/ep_%04u.bin", slot);
+        LittleFS.remove(path);
+    }
+    LittleFS.setCapacity(HOST_LITTLEFS_BYTES);
+    setMillis(0);
+}
+
+void tearDown() {}
+
+static void feed(EpisodeRecorder &recorder) {
+    static uint32_t n = 0;
+    n++;
+    recorder.addAccel((int16_t)(n * 37 % 2000), (int16_t)(n * 11 % 500), 16384, millis());
+    uint32_t red = 50000 + n % 300, ir = 90000 + n % 700;
+    recorder.addPpg(&red, &ir, 1);
+}
+
+// Past the cooldown, trigger and run until the episode is closed
+static bool record(EpisodeRecorder &recorder) {
+    advanceMillis(EPISODE_COOLDOWN_MS);
+    if (!recorder.trigger(EPISODE_FALL)) return false;
+    while (recorder.isRecording()) {
+        advanceMillis(STEP_MS);
+        feed(recorder);
+        recorder.update();
+    }
+    return true;
+}
+
+static uint16_t storedSequence(uint16_t slot) {
+    char path[20];
+    snprintf(path, sizeof(path), "/ep_%04u.bin", slot);
+    File file = LittleFS.open(path, FILE_READ);
+    uint8_t header[EPISODE_FILE_HEADER] = {};
+    file.read(header, sizeof(header));
+    return episodeGet16(header + 10);
+}
+
+static size_t slotBytes(uint16_t slot) {
+    char path[20];
+    snprintf(path, sizeof(path), "/ep_%04u.bin", slot);
+    File file = LittleFS.open(path, FILE_READ);
+    return file.size();
+}
+
+void test_episodes_rotate_through_slots() {
+    EpisodeRecorder recorder;
+    TEST_ASSERT_TRUE(recorder.begin(500, 100));
+    for (uint16_t i = 0; i < EPISODE_SLOTS + 3; i++) TEST_ASSERT_TRUE(record(recorder));
+
+    TEST_ASSERT_EQUAL(EPISODE_SLOTS + 3, recorder.getEpisodesWritten());
+    TEST_ASSERT_EQUAL(3, recorder.getEpisodesDropped());
+    TEST_ASSERT_EQUAL(0, recorder.getEpisodesTruncated());
+    for (uint16_t slot = 0; slot < EPISODE_SLOTS; slot++) {
+        uint16_t expected = (slot < 3) ? slot + EPISODE_SLOTS : slot;
+        TEST_ASSERT_EQUAL(expected, storedSequence(slot));
+    }
+
+    EpisodeRecorder resumed;
+    TEST_ASSERT_TRUE(resumed.begin(500, 100));
+    TEST_ASSERT_EQUAL(EPISODE_SLOTS + 3, resumed.getEpisodeCount());
+}
+
+void test_full_flash_drops_oldest_episodes() {
+    EpisodeRecorder recorder;
+    recorder.begin(500, 100);
+    for (uint16_t i = 0; i < EPISODE_SLOTS; i++) TEST_ASSERT_TRUE(record(recorder));
+
+    // Dropping the oldest alone leaves one byte short of the minimum
+    LittleFS.setCapacity(LittleFS.usedBytes() - slotBytes(0) + EPISODE_MIN_FREE - 1);
+    uint32_t dropped = recorder.getEpisodesDropped();
+    TEST_ASSERT_TRUE(record(recorder));
+    TEST_ASSERT_EQUAL(dropped + 2, recorder.getEpisodesDropped());
+    TEST_ASSERT_FALSE(LittleFS.exists("/ep_0001.bin"));
+
+    // Not enough room even with every episode gone
+    LittleFS.setCapacity(EPISODE_MIN_FREE - 1);
+    TEST_ASSERT_FALSE(record(recorder));
+}
+
+void test_short_write_truncates_episode() {
+    EpisodeRecorder recorder;
+    recorder.begin(500, 100);
+    advanceMillis(EPISODE_COOLDOWN_MS);
+    TEST_ASSERT_TRUE(recorder.trigger(EPISODE_FALL));
+
+    // Room for the first page only
+    LittleFS.setCapacity(LittleFS.usedBytes() + EPISODE_PAGE_SIZE);
+    while (recorder.isRecording()) {
+        advanceMillis(STEP_MS);
+        feed(recorder);
+        recorder.update();
+    }
+    TEST_ASSERT_EQUAL(1, recorder.getEpisodesTruncated());
+    TEST_ASSERT_EQUAL(EPISODE_FILE_HEADER + EPISODE_PAGE_SIZE, recorder.getBytesWritten());
+
+    // What made it to flash still decodes
+    EpisodeReader reader;
+    static int32_t values[EPISODE_PAGE_SIZE * 4];
+    EpisodeBlock block;
+    TEST_ASSERT_TRUE(reader.open(0));
+    TEST_ASSERT_TRUE(reader.next(block, values, EPISODE_PAGE_SIZE * 4));
+    TEST_ASSERT_EQUAL(0, reader.getCrcErrors());
+    reader.close();
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_episodes_rotate_through_slots);
+    RUN_TEST(test_full_flash_drops_oldest_episodes);
+    RUN_TEST(test_short_write_truncates_episode);
+    return UNITY_END();
+}
@@ -0,0 +1,57 @@
+#include <unity.h>
+#include <Arduino.h>
+#include "HartRate.h"
+
+/*
+  HartRate::evaluateStatus() on the fractional means it is given (window
+  means are BPM x10 / 10): every value falls into exactly one band, with
+  no gaps at the band edges.
+*/
+
+static HartRate heart;
+
+static HeartData grade(float avg) {
+    HeartData data = {};
+    data.status = HEART_ANALYSING;
+    heart.evaluateStatus(data, avg);
+    return data;
+}
+
+static void checkBand(float avg, HeartStatus status, int alertLevel) {
+    char message[24];
+    snprintf(message, sizeof(message), "%.1f BPM", avg);
+    HeartData data = grade(avg);
+    TEST_ASSERT_EQUAL_MESSAGE(status, data.status, message);
+    TEST_ASSERT_EQUAL_MESSAGE(alertLevel, data.alertLevel, message);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_band_edges() {
+    checkBand(39.9f, HEART_CRITICAL_LOW, 2);
+    checkBand(40.0f, HEART_LOW, 1);
+    checkBand(49.5f, HEART_LOW, 1);
+    checkBand(50.0f, HEART_NORMAL, 0);
+    checkBand(90.0f, HEART_NORMAL, 0);
+    checkBand(90.5f, HEART_ELEVATED, 1);
+    checkBand(109.5f, HEART_ELEVATED, 1);
+    checkBand(110.0f, HEART_CRITICAL_HIGH, 2);
+}
+
+// Every mean from 30 to 200 BPM in 0.1 steps gets a graded status
+void test_no_gaps() {
+    for (int x10 = 300; x10 <= 2000; x10++) {
+        HeartData data = grade(x10 / 10.0f);
+        char message[24];
+        snprintf(message, sizeof(message), "%.1f BPM", x10 / 10.0f);
+        TEST_ASSERT_TRUE_MESSAGE(data.status != HEART_ANALYSING && data.status != HEART_CALCULATING, message);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_band_edges);
+    RUN_TEST(test_no_gaps);
+    return UNITY_END();
+}
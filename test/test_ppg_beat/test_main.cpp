@@ -0,0 +1,148 @@
+#include <unity.h>
+#include <math.h>
+#include "PPGBeatDetector.h"
+
+/*
+  PPGBeatDetector on a synthetic 72 BPM IR trace at 100 Hz, fed in the
+  1-3 sample blocks a MAX30102 FIFO drain produces.
+*/
+
+#define RATE_HZ 100
+#define BPM 72
+#define SECONDS 30
+
+static uint32_t irAt(uint32_t n) {
+    float t = (float)n / RATE_HZ;
+    float phase = fmodf(t * BPM / 60.0f, 1.0f);
+    float pulse = (phase < 0.3f) ? sinf(phase / 0.3f * 3.14159265f) : 0;  // Systolic dip
+    return (uint32_t)(100000 - 600 * pulse);
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Runs the trace in blocks of 1, 2, 3 samples and matches beats to samples
+// the way HartRate::processBlock() does
+static void runTrace(uint32_t &beats, uint32_t &matched) {
+    PPGBeatDetector detector;
+    detector.begin(RATE_HZ);
+    uint32_t ir[4], timeMs[4];
+    PPGBeat found[4];
+    beats = matched = 0;
+
+    uint32_t n = 0;
+    uint8_t cycle = 0;
+    while (n < SECONDS * RATE_HZ) {
+        uint16_t count = (uint16_t)(1 + cycle++ % 3);
+        for (uint16_t i = 0; i < count; i++, n++) {
+            ir[i] = irAt(n);
+            timeMs[i] = n * 1000 / RATE_HZ;
+        }
+        uint8_t beatCount = detector.process(ir, timeMs, count, found, 4);
+        beats += beatCount;
+
+        uint8_t b = 0;
+        for (uint16_t i = 0; i < count; i++) {
+            while (b < beatCount && found[b].index == i) {
+                matched++;
+                b++;
+            }
+        }
+        for (uint8_t k = 1; k < beatCount; k++) TEST_ASSERT_TRUE(found[k].index >= found[k - 1].index);
+    }
+}
+
+void test_beats_match_in_small_blocks() {
+    uint32_t beats, matched;
+    runTrace(beats, matched);
+    TEST_ASSERT_GREATER_THAN(SECONDS * BPM / 60 - 5, beats);   // A few beats of filter warm-up
+    TEST_ASSERT_EQUAL(beats, matched);
+}
+
+// Feeds samples [from, to) as one block
+static uint8_t feed(PPGBeatDetector &detector, uint32_t from, uint32_t to, PPGBeat *found) {
+    static uint32_t ir[SECONDS * RATE_HZ], timeMs[SECONDS * RATE_HZ];
+    for (uint32_t n = from; n < to; n++) {
+        ir[n - from] = irAt(n);
+        timeMs[n - from] = n * 1000 / RATE_HZ;
+    }
+    return detector.process(ir, timeMs, (uint16_t)(to - from), found, 8);
+}
+
+// One pulse whose peak ends block A and which is confirmed in block B
+void test_pulse_across_two_blocks() {
+    PPGBeat found[8];
+
+    // Reference run in one block: where the 10th beat peaks and is confirmed
+    PPGBeatDetector reference;
+    reference.begin(RATE_HZ);
+    uint32_t peak = 0, confirm = 0, beats = 0;
+    for (uint32_t n = 0; n < SECONDS * RATE_HZ && beats < 10; n++) {
+        if (feed(reference, n, n + 1, found)) {
+            beats++;
+            peak = found[0].timeMs * RATE_HZ / 1000;
+            confirm = n;
+        }
+    }
+    TEST_ASSERT_EQUAL(10, beats);
+    TEST_ASSERT_LESS_THAN(confirm, peak);
+
+    // Same trace: block A ends at the peak, block B holds the confirmation
+    PPGBeatDetector detector;
+    detector.begin(RATE_HZ);
+    beats = 0;
+    for (uint32_t n = 0; n < peak + 1; n++) beats += feed(detector, n, n + 1, found);
+    TEST_ASSERT_EQUAL(9, beats);
+    uint16_t countB = (uint16_t)(confirm - peak + 3);
+    uint8_t inB = feed(detector, peak + 1, peak + 1 + countB, found);
+    TEST_ASSERT_EQUAL(1, inB);
+    TEST_ASSERT_LESS_THAN(countB, found[0].index);
+    TEST_ASSERT_EQUAL(confirm - (peak + 1), found[0].index);
+    TEST_ASSERT_EQUAL(peak * 1000 / RATE_HZ, found[0].timeMs);
+}
+
+void test_rate_from_intervals() {
+    PPGBeatDetector detector;
+    detector.begin(RATE_HZ);
+    uint32_t ir[64], timeMs[64];
+    PPGBeat found[8];
+    for (uint32_t n = 0; n < SECONDS * RATE_HZ; n += 64) {
+        for (uint16_t i = 0; i < 64; i++) {
+            ir[i] = irAt(n + i);
+            timeMs[i] = (n + i) * 1000 / RATE_HZ;
+        }
+        detector.process(ir, timeMs, 64, found, 8);
+    }
+    TEST_ASSERT_TRUE(detector.isFingerPresent());
+    TEST_ASSERT_INT_WITHIN(20, BPM * 10, detector.getAvgBpmX10());
+}
+
+// Breathing drift 2.5x the pulse height (0.2 Hz): every beat after
+// warm-up is still found, one per pulse
+void test_rejects_breathing_drift() {
+    PPGBeatDetector detector;
+    detector.begin(RATE_HZ);
+    uint32_t ir[1], timeMs[1];
+    PPGBeat found[4];
+    uint32_t beats = 0;
+    uint32_t lastMs = 0;
+    for (uint32_t n = 0; n < SECONDS * RATE_HZ; n++) {
+        timeMs[0] = n * 1000 / RATE_HZ;
+        ir[0] = (uint32_t)((int32_t)irAt(n) + (int32_t)(1500 * sinf(2 * 3.14159265f * 0.2f * timeMs[0] / 1000)));
+        if (detector.process(ir, timeMs, 1, found, 4) && timeMs[0] >= 5000) {
+            beats++;
+            if (lastMs) TEST_ASSERT_INT_WITHIN(20, 60000 / BPM, found[0].timeMs - lastMs);
+            lastMs = found[0].timeMs;
+        }
+    }
+    TEST_ASSERT_INT_WITHIN(1, (SECONDS - 5) * BPM / 60, beats);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_beats_match_in_small_blocks);
+    RUN_TEST(test_pulse_across_two_blocks);
+    RUN_TEST(test_rate_from_intervals);
+    RUN_TEST(test_rejects_breathing_drift);
+    return UNITY_END();
+}
@@ -0,0 +1,93 @@
+#include <unity.h>
+#include <math.h>
+#include "QRSDetector.h"
+
+/*
+  QRSDetector on a synthetic 500 Hz ECG (~86 BPM, triangular QRS, T waves,
+  noise). One beat is small enough that only search-back can find it.
+*/
+
+#define FS 500
+#define RR 350               // Samples (~86 BPM)
+#define BEATS 40
+#define SMALL_BEAT 20        // Index of the low-amplitude beat
+#define TOLERANCE 10         // Samples (20 ms)
+
+static int16_t ecg[RR * (BEATS + 1)];
+static uint32_t truth[BEATS];
+
+static void makeEcg(float smallGain) {
+    uint32_t seed = 1;
+    for (uint32_t n = 0; n < sizeof(ecg) / sizeof(ecg[0]); n++) {
+        seed = seed * 1664525 + 1013904223;
+        ecg[n] = (int16_t)((int32_t)(seed >> 24) % 21 - 10);
+    }
+    for (uint8_t b = 0; b < BEATS; b++) {
+        uint32_t r = RR / 2 + (uint32_t)b * RR;
+        truth[b] = r;
+        float gain = (b == SMALL_BEAT) ? smallGain : 1.0f;
+        for (int32_t k = -10; k <= 10; k++) ecg[r + k] += (int16_t)(gain * 1000 * (10 - abs(k)) / 10);
+        for (int32_t k = -40; k <= 40; k++) ecg[r + 160 + k] += (int16_t)(150 * cosf(k * 3.14159265f / 80));
+    }
+}
+
+// Runs the trace in blocks; returns beats matched to the truth within TOLERANCE
+static uint8_t detect(uint16_t block, uint8_t &detected, uint32_t &smallR, uint16_t &smallRR) {
+    QRSDetector detector;
+    detector.begin(FS);
+    QRSBeat beats[8];
+    uint8_t matched = 0;
+    detected = 0;
+    smallR = 0;
+    smallRR = 0;
+    uint32_t total = sizeof(ecg) / sizeof(ecg[0]);
+    for (uint32_t n = 0; n < total; n += block) {
+        uint16_t count = (uint16_t)((total - n < block) ? total - n : block);
+        uint8_t found = detector.process(&ecg[n], count, n, beats, 8);
+        for (uint8_t i = 0; i < found; i++) {
+            detected++;
+            for (uint8_t b = 0; b < BEATS; b++) {
+                int32_t error = (int32_t)beats[i].seq - (int32_t)truth[b];
+                if (error >= -TOLERANCE && error <= TOLERANCE) {
+                    matched++;
+                    if (b == SMALL_BEAT) {
+                        smallR = beats[i].seq;
+                        smallRR = beats[i].rrSamples;
+                    }
+                }
+            }
+        }
+    }
+    return matched;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_detects_every_beat_after_learning() {
+    makeEcg(1.0f);
+    uint8_t detected;
+    uint32_t smallR;
+    uint16_t smallRR;
+    uint8_t matched = detect(32, detected, smallR, smallRR);
+    TEST_ASSERT_EQUAL(detected, matched);            // PPV 100%
+    TEST_ASSERT_GREATER_OR_EQUAL(BEATS - 6, matched); // Learning phase + filter warm-up
+}
+
+void test_search_back_locates_r_wave() {
+    makeEcg(0.5f);
+    uint8_t detected;
+    uint32_t smallR;
+    uint16_t smallRR;
+    uint8_t matched = detect(32, detected, smallR, smallRR);
+    TEST_ASSERT_EQUAL(detected, matched);
+    TEST_ASSERT_INT_WITHIN(2, truth[SMALL_BEAT], smallR);   // Same as a normal beat
+    TEST_ASSERT_INT_WITHIN(4, RR, smallRR);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_detects_every_beat_after_learning);
+    RUN_TEST(test_search_back_locates_r_wave);
+    return UNITY_END();
+}
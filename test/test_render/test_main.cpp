@@ -0,0 +1,395 @@
+#include <unity.h>
+#include <Arduino.h>
+#include "RenderBenchmark.h"
+
+/*
+  DisplayManager on the host: the in-memory GFX backend (test/host) draws
+  the frames, the I2C bus task sends them to a simulated SH1106 and a
+  simulated BMP280 feeds the weather screen (datasheet calibration
+  example: 25.08 C, 1006.53 hPa).
+  - Golden frames: every screen and every frame of each alert animation,
+    sprites against primitives and against the committed hashes below.
+    The hashes belong to the host backend; after an intended change to a
+    screen, the failing check prints the new table to paste in
+  - Flush path: what reaches the panel RAM must be the golden frame, and
+    a small change must only send the changed bytes
+  - Frame governor: unchanged models and the FPS cap skip the redraw
+  - I2C bus: without its task, transactions run inline
+*/
+
+#define FALL_CANCEL_PIN 11
+#define TASK_WAIT_MS 2000
+
+// --- GOLDEN FRAMES (RenderBenchmark::frameHash) ---
+static const char *const SCREEN_NAMES[] = { "start", "heart", "weather", "ecg", "steps", "sos", "fall", "alert" };
+static const uint32_t GOLDEN_SCREENS[] = {
+    0xc2560077, 0x39b2d8e0, 0x4647037f, 0x4c00ed80, 0x35099a74, 0xfe10d9b5, 0x5d144442, 0xdb56590f
+};
+
+static const uint32_t GOLDEN_SOS[] = {
+    0x4fec6a2b, 0x38c9edcb, 0xbc91b80b, 0x0351f895, 0xf45769d5, 0x4fd163c5, 0x7bcc5d35, 0xfe10d9b5,
+    0xa0b7f245, 0x2506aa27, 0xd2ea8e4b, 0x9cc8920b, 0x906aaf0b, 0xfd49d8c5, 0xa3ce6905, 0x4f12d305,
+    0xcf6f86c5, 0x19b07185, 0xd089c745, 0x96cffde7, 0x25588f4b, 0xf695f91b, 0x8e2864db, 0xb6d7ae05,
+    0xafc5ab15, 0xb9ac79d5, 0x96cea125, 0xd761f4a5, 0xca32d325, 0x94b48c19, 0x304a263b, 0x27f32cfb,
+    0xc2ec096b, 0x666e55b5, 0x3d3bbcf5, 0x5f0ba7b5, 0x5bff60e5, 0x5e6ca7d5, 0x9e2219d5, 0x0bcadcd9,
+    0xa635a86b, 0x83a341ab, 0x4d61c26b, 0x6c5cd175, 0xe01fb9b5, 0x71703b25, 0x6c33bb55, 0x27010015,
+    0x29c8a4e5, 0xde460287, 0x6dcc2d63
+};
+
+static const uint32_t GOLDEN_FALL[] = {
+    0x7611f4ba, 0x5e92aa35, 0x24052d64, 0x75e9a37b, 0x5a4e5e21, 0xa0753168, 0x10ebfa77, 0x5d144442,
+    0x239a088c, 0x47d6d633, 0xfa25bb26, 0xa66b1b50, 0x48ee372f, 0xe3b226ea, 0xa914c3a5, 0x3272a96b,
+    0xfc64b98e, 0xed498811, 0x0db6d7e7, 0x7c045c72, 0x5164ec7d, 0x1d707f3c, 0x546b5ed6, 0x6757b4a9,
+    0xdae10140, 0x5f4ff5da, 0x7e1be455, 0x3dde9284, 0xa95ad91b, 0xbc54e6c1, 0x87fb3f08, 0x49110597,
+    0xf84405e2, 0x11d1372c, 0xa07a2bd3, 0x9abf5ec6, 0xcb9ba170, 0x5e02e24f, 0x2565330a, 0x2ed6ee45,
+    0xc4adf30b, 0xdaa6f92e, 0x8feb21b1, 0x0f312f87, 0xd239ed12, 0xf515801d, 0x6d939ddc, 0xd3b8ff76,
+    0x0b22e749, 0x9fcc5b60, 0x47ec167a, 0x0e1794f5, 0x95ba4f64, 0x0d0a133b, 0x5a8150a1, 0x6e150ae8,
+    0x13db7277, 0xf1c6cf02, 0x85103e0c, 0x94ff4273, 0xb5b90426, 0x8d746e50, 0xdbeb93af, 0x7371842a,
+    0x20a680e5, 0xad7a302b, 0x91cfe3ce, 0x91ae4bd1, 0xabce3367, 0xec0eba72, 0x1bd61a3d, 0x8a63e5bc,
+    0xa672d516, 0x3848ffe9, 0x5bb7de80, 0x9fd3eb5a, 0x41de3d55, 0xc4c70c44, 0xaf28ce1b, 0xf14bc381,
+    0x09ce5748, 0x30881fd7, 0xfbe86ae2, 0x414bd76c, 0x11dba353, 0x9dabda86, 0x94c540b0, 0xe81a3d0f,
+    0x7527778a, 0x17310a45, 0x33f3fd0b, 0x10579d2e, 0xad4204b1, 0x96b8a347, 0xc83c83d2, 0x6e45829d,
+    0xd6b9ca1c, 0x1269ab76, 0x98edaac9, 0x3e6a9960, 0xaa1fc755
+};
+
+static const uint32_t GOLDEN_ALERT[] = {
+    0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f,
+    0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f,
+    0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f,
+    0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f, 0xdb56590f
+};
+
+static HostSH1106Panel panel;
+static HostRegisterDevice bmp280;
+static I2CBus bus;
+static WeatherManager weather;
+static ECGManager ecg(36, 38, 37);
+static ActivityManager activity;
+static ActivityClassifier classifier;
+static Vibrate vibrate;
+static DisplayManager display;
+
+// BMP280 datasheet (section 3.12) calibration and raw readings
+static void setupBmp280() {
+    static const uint16_t calib[12] = { 27504, 26435, (uint16_t)-1000, 36477, (uint16_t)-10685, 3024,
+                                        2855, 140, (uint16_t)-7, 15500, (uint16_t)-14600, 6000 };
+    for (uint8_t i = 0; i < 12; i++) {
+        bmp280.regs[BMP280_REG_CALIB + 2 * i] = calib[i] & 0xFF;
+        bmp280.regs[BMP280_REG_CALIB + 2 * i + 1] = calib[i] >> 8;
+    }
+    bmp280.regs[BMP280_REG_ID] = BMP280_CHIP_ID;
+    const uint32_t adcP = 415148, adcT = 519888;
+    uint8_t *data = &bmp280.regs[BMP280_REG_DATA];
+    data[0] = (uint8_t)(adcP >> 12); data[1] = (uint8_t)(adcP >> 4); data[2] = (uint8_t)(adcP << 4);
+    data[3] = (uint8_t)(adcT >> 12); data[4] = (uint8_t)(adcT >> 4); data[5] = (uint8_t)(adcT << 4);
+}
+
+static uint32_t panelHash() {
+    uint8_t shown[OLED_BUFFER_BYTES];
+    panel.visible(shown, OLED_WIDTH);
+    return RenderBenchmark::frameHash(shown);
+}
+
+// Asserts a hash table, printing the actual one to paste if it differs
+static void checkHashes(const char *name, const uint32_t *expected, int expectedCount,
+                        const uint32_t *actual, int count) {
+    bool same = expectedCount == count;
+    for (int i = 0; same && i < count; i++) same = expected[i] == actual[i];
+    if (!same) {
+        printf("%s golden hashes:\n", name);
+        for (int i = 0; i < count; i++) printf("0x%08x,%s", actual[i], (i % 8 == 7) ? "\n" : " ");
+        printf("\n");
+    }
+    TEST_ASSERT_EQUAL(count, expectedCount);
+    for (int i = 0; i < count; i++) {
+        char message[32];
+        snprintf(message, sizeof(message), "%s frame %d", name, i);
+        TEST_ASSERT_EQUAL_HEX32_MESSAGE(expected[i], actual[i], message);
+    }
+}
+
+static HeartData benchHeart() {
+    HeartData heart = {};
+    heart.irValue = 90000;
+    heart.fingerPresent = true;
+    heart.currentBpm = 72;
+    heart.avgBpm = 71;
+    heart.spo2 = 98;
+    return heart;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// --- GOLDEN FRAMES ---
+
+void test_screens_match_golden() {
+    RenderBenchmark bench(display, 10);
+    TEST_ASSERT_EQUAL(0, bench.run(weather, ecg, activity, classifier, vibrate));
+    TEST_ASSERT_EQUAL(8, bench.getCaseCount());
+
+    uint32_t hashes[8];
+    for (uint8_t i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL_STRING(SCREEN_NAMES[i], bench.getCaseName(i));
+        hashes[i] = bench.getHash(i);
+    }
+    checkHashes("screen", GOLDEN_SCREENS, 8, hashes, 8);
+}
+
+static void checkAnimation(RenderBenchmark::BenchAnimation anim, const char *name,
+                           const uint32_t *golden, int goldenCount) {
+    RenderBenchmark bench(display, 1);
+    uint32_t hashes[128];
+    int frames = RenderBenchmark::animationFrames(anim);
+    TEST_ASSERT_EQUAL(0, bench.runAnimation(anim, vibrate, hashes));
+    checkHashes(name, golden, goldenCount, hashes, frames);
+}
+
+void test_sos_frames_match_golden() {
+    checkAnimation(RenderBenchmark::BENCH_SOS, "sos", GOLDEN_SOS, sizeof(GOLDEN_SOS) / 4);
+}
+
+void test_fall_frames_match_golden() {
+    checkAnimation(RenderBenchmark::BENCH_FALL, "fall", GOLDEN_FALL, sizeof(GOLDEN_FALL) / 4);
+}
+
+void test_alert_frames_match_golden() {
+    checkAnimation(RenderBenchmark::BENCH_HEART, "alert", GOLDEN_ALERT, sizeof(GOLDEN_ALERT) / 4);
+}
+
+// --- FLUSH ---
+
+void test_flush_sends_only_changed_bytes() {
+    display.clear();
+    advanceMillis(1000);
+    display.showStartScreen("17/10/2026", "12:05 PM");
+    TEST_ASSERT_EQUAL_HEX32(GOLDEN_SCREENS[0], panelHash());
+
+    // Screen switch: the whole changed area goes out once
+    HeartData heart = benchHeart();
+    display.getGovernor().invalidate();
+    display.showHeartRateScreen(heart);
+    TEST_ASSERT_EQUAL_HEX32(GOLDEN_SCREENS[1], panelHash());
+    uint16_t switchBytes = display.getScreenStats(SCREEN_HEART).lastFlushBytes;
+
+    // One digit of the BPM: a few columns of one page
+    uint32_t before = panel.dataBytes;
+    heart.currentBpm = 73;
+    advanceMillis(1000);
+    display.showHeartRateScreen(heart);
+    uint16_t digitBytes = display.getScreenStats(SCREEN_HEART).lastFlushBytes;
+    TEST_ASSERT_GREATER_THAN(0, digitBytes);
+    TEST_ASSERT_LESS_OR_EQUAL(6, digitBytes);
+    TEST_ASSERT_LESS_THAN(switchBytes, digitBytes);
+    TEST_ASSERT_EQUAL(digitBytes, panel.dataBytes - before);
+
+    heart.currentBpm = 72;
+    advanceMillis(1000);
+    display.showHeartRateScreen(heart);
+    TEST_ASSERT_EQUAL_HEX32(GOLDEN_SCREENS[1], panelHash());
+}
+
+// --- FRAME GOVERNOR ---
+
+void test_governor_skips_unchanged_and_capped_frames() {
+    HeartData heart = benchHeart();
+    display.getGovernor().invalidate();
+    advanceMillis(1000);
+    display.showHeartRateScreen(heart);
+
+    FrameGovernor &governor = display.getGovernor();
+    uint32_t draws = governor.getDraws(SCREEN_HEART);
+    uint32_t skips = governor.getSkips(SCREEN_HEART);
+    uint32_t writes = panel.writes;
+
+    // Same model: no redraw, no bus traffic
+    advanceMillis(1000);
+    display.showHeartRateScreen(heart);
+    TEST_ASSERT_EQUAL(draws, governor.getDraws(SCREEN_HEART));
+    TEST_ASSERT_EQUAL(skips + 1, governor.getSkips(SCREEN_HEART));
+    TEST_ASSERT_EQUAL(writes, panel.writes);
+
+    // Changed model: drawn
+    heart.spo2 = 97;
+    display.showHeartRateScreen(heart);
+    TEST_ASSERT_EQUAL(draws + 1, governor.getDraws(SCREEN_HEART));
+    TEST_ASSERT_GREATER_THAN(writes, panel.writes);
+
+    // Changed again inside the 10 FPS interval: held back until it is due
+    writes = panel.writes;
+    heart.spo2 = 96;
+    advanceMillis(50);
+    display.showHeartRateScreen(heart);
+    TEST_ASSERT_EQUAL(draws + 1, governor.getDraws(SCREEN_HEART));
+    TEST_ASSERT_EQUAL(writes, panel.writes);
+
+    advanceMillis(50);
+    display.showHeartRateScreen(heart);
+    TEST_ASSERT_EQUAL(draws + 2, governor.getDraws(SCREEN_HEART));
+    TEST_ASSERT_GREATER_THAN(writes, panel.writes);
+}
+
+// --- ANIMATIONS THROUGH THE FLUSH PATH ---
+
+// Plays an armed animation frame by frame (ANIM_FRAME_MS apart) and
+// checks each frame the panel shows, and its inversion for flashing ones
+static void playAnimation(const char *name, const uint32_t *golden, int frames, bool flashes) {
+    for (int i = 0; i < frames; i++) {
+        TEST_ASSERT_TRUE(display.updateAnimation(vibrate));
+        char message[32];
+        snprintf(message, sizeof(message), "%s panel frame %d", name, i);
+        TEST_ASSERT_EQUAL_HEX32_MESSAGE(golden[i], panelHash(), message);
+        bool inverted = flashes && i < frames - 1 && (i / 5) % 2 == 0;
+        TEST_ASSERT_TRUE_MESSAGE(panel.inverted == inverted, message);
+        advanceMillis(100);
+    }
+}
+
+// Only the drawn frame stands in for sensor reads (temperature + pressure);
+// the governor's change check does not count as saved BMP280 reads
+void test_weather_skip_saves_no_reads() {
+    display.getGovernor().invalidate();
+    advanceMillis(1000);
+    uint32_t saved = weather.getSavedTransactions();
+    display.showWeatherScreen(weather);
+    TEST_ASSERT_EQUAL(saved + 2, weather.getSavedTransactions());
+
+    advanceMillis(1000);
+    display.showWeatherScreen(weather);
+    TEST_ASSERT_EQUAL(saved + 2, weather.getSavedTransactions());
+}
+
+void test_animations_reach_the_panel() {
+    display.startEmergencyCall();
+    playAnimation("sos", GOLDEN_SOS, sizeof(GOLDEN_SOS) / 4, false);
+    advanceMillis(2000);
+    display.updateAnimation(vibrate);
+    TEST_ASSERT_FALSE(display.isAnimating());
+
+    setPin(FALL_CANCEL_PIN, HIGH); // Cancel button released
+    display.startFallAlert(FALL_CANCEL_PIN);
+    playAnimation("fall", GOLDEN_FALL, sizeof(GOLDEN_FALL) / 4, true);
+    advanceMillis(2000);
+    display.updateAnimation(vibrate);
+    TEST_ASSERT_FALSE(display.isAnimating());
+
+    // The heart alert has no final screen: every frame flashes in turn
+    display.startHeartAlert("CRITICAL HIGH", 142, 2);
+    int frames = sizeof(GOLDEN_ALERT) / 4;
+    for (int i = 0; i < frames; i++) {
+        TEST_ASSERT_TRUE(display.updateAnimation(vibrate));
+        TEST_ASSERT_EQUAL_HEX32(GOLDEN_ALERT[i], panelHash());
+        TEST_ASSERT_TRUE(panel.inverted == ((i / 5) % 2 == 0));
+        advanceMillis(100);
+    }
+    TEST_ASSERT_FALSE(display.updateAnimation(vibrate));
+    TEST_ASSERT_FALSE(panel.inverted);
+}
+
+// The cancel press is handed to the caller once, so it is not also taken
+// as a press of its own (the power long-press shares the button)
+void test_fall_cancel_press_is_reported_once() {
+    setPin(FALL_CANCEL_PIN, HIGH);
+    display.startFallAlert(FALL_CANCEL_PIN);
+    TEST_ASSERT_TRUE(display.updateAnimation(vibrate));
+    TEST_ASSERT_FALSE(display.takeFallCancelPress());
+
+    setPin(FALL_CANCEL_PIN, LOW);
+    advanceMillis(100);
+    TEST_ASSERT_TRUE(display.updateAnimation(vibrate));
+    TEST_ASSERT_TRUE(display.takeFallCancelPress());
+    TEST_ASSERT_FALSE(display.takeFallCancelPress());
+
+    setPin(FALL_CANCEL_PIN, HIGH);
+    advanceMillis(1000);
+    display.updateAnimation(vibrate);
+    TEST_ASSERT_FALSE(display.isAnimating());
+    TEST_ASSERT_FALSE(display.takeFallCancelPress());
+}
+
+// --- FLUSH TASK ---
+
+void test_flush_task_shows_newest_frame() {
+    static DisplayManager taskDisplay;
+    taskDisplay.begin(bus, true);
+    TEST_ASSERT_TRUE(taskDisplay.isFlushTaskActive());
+
+    advanceMillis(1000);
+    taskDisplay.showStartScreen("17/10/2026", "12:05 PM");
+    HeartData heart = benchHeart();
+    taskDisplay.showHeartRateScreen(heart);
+
+    // Both frames may reach the panel, or the first may be dropped; the
+    // newest one is what it ends up showing
+    for (int waited = 0; waited < TASK_WAIT_MS && panelHash() != GOLDEN_SCREENS[1]; waited++) vTaskDelay(1);
+    TEST_ASSERT_EQUAL_HEX32(GOLDEN_SCREENS[1], panelHash());
+    const ScreenStats &start = taskDisplay.getScreenStats(SCREEN_START);
+    TEST_ASSERT_EQUAL(1, start.frames);
+}
+
+// Inversion is applied by the flush task with its own frame, never ahead
+// of it: with the bus held, a new inverted frame must not invert the panel
+void test_flush_task_inverts_with_its_frame() {
+    static DisplayManager taskDisplay;
+    taskDisplay.begin(bus, true);
+    TEST_ASSERT_TRUE(taskDisplay.isFlushTaskActive());
+
+    advanceMillis(1000);
+    taskDisplay.showStartScreen("17/10/2026", "12:05 PM");
+    for (int waited = 0; waited < TASK_WAIT_MS && panelHash() != GOLDEN_SCREENS[0]; waited++) vTaskDelay(1);
+    TEST_ASSERT_EQUAL_HEX32(GOLDEN_SCREENS[0], panelHash());
+    TEST_ASSERT_FALSE(panel.inverted);
+
+    {
+        I2CBusLock hold(bus, 0);
+        taskDisplay.startHeartAlert("CRITICAL HIGH", 142, 2);
+        TEST_ASSERT_TRUE(taskDisplay.updateAnimation(vibrate)); // First frame flashes
+        TEST_ASSERT_FALSE(panel.inverted);
+    }
+    for (int waited = 0; waited < TASK_WAIT_MS && panelHash() != GOLDEN_ALERT[0]; waited++) vTaskDelay(1);
+    TEST_ASSERT_EQUAL_HEX32(GOLDEN_ALERT[0], panelHash());
+    TEST_ASSERT_TRUE(panel.inverted);
+}
+
+// --- I2C BUS ---
+
+// Without the bus task, transactions run inline and still complete
+void test_bus_runs_inline_without_task() {
+    static I2CBus inlineBus;
+    hostTaskCreateFails() = true;
+    bool ready = inlineBus.begin();
+    hostTaskCreateFails() = false;
+    TEST_ASSERT_TRUE(ready);
+    TEST_ASSERT_FALSE(inlineBus.isTaskActive());
+
+    int8_t device = inlineBus.addDevice(BMP280_ADDR, 400000, "bmp280");
+    uint8_t id = 0;
+    TEST_ASSERT_EQUAL(I2C_OK, inlineBus.readRegisters(device, BMP280_REG_ID, &id, 1));
+    TEST_ASSERT_EQUAL_HEX8(BMP280_CHIP_ID, id);
+    TEST_ASSERT_EQUAL(1, inlineBus.getTransactions(device));
+    TEST_ASSERT_EQUAL(2, inlineBus.getBytes(device));
+}
+
+int main() {
+    Wire.attach(OLED_ADDR, &panel);
+    setupBmp280();
+    Wire.attach(BMP280_ADDR, &bmp280);
+    bus.begin();
+    weather.begin(bus);
+    display.begin(bus);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_screens_match_golden);
+    RUN_TEST(test_sos_frames_match_golden);
+    RUN_TEST(test_fall_frames_match_golden);
+    RUN_TEST(test_alert_frames_match_golden);
+    RUN_TEST(test_flush_sends_only_changed_bytes);
+    RUN_TEST(test_governor_skips_unchanged_and_capped_frames);
+    RUN_TEST(test_weather_skip_saves_no_reads);
+    RUN_TEST(test_animations_reach_the_panel);
+    RUN_TEST(test_fall_cancel_press_is_reported_once);
+    RUN_TEST(test_flush_task_shows_newest_frame);
+    RUN_TEST(test_flush_task_inverts_with_its_frame);
+    RUN_TEST(test_bus_runs_inline_without_task);
+    return UNITY_END();
+}
@@ -0,0 +1,109 @@
+#include <unity.h>
+#include <Arduino.h>
+#include "SpO2Estimator.h"
+
+/*
+  SpO2Estimator on synthetic red / IR PPG at 72 BPM: IR DC 100000 with a
+  1 % pulse, red DC 80000 with its pulse scaled for a ratio of ratios
+  R = 0.6 (Maxim curve: 96.8 %), plus a slow baseline drift. The same
+  signal is fed at 100, 200 and 400 Hz; onBeat() runs once per pulse.
+  Also the host cost benchmark (ns/sample).
+*/
+
+#define BPM 72
+#define SECONDS 20
+#define RATIO 0.6f
+#define IR_DC 100000.0f
+#define RED_DC 80000.0f
+#define PERFUSION 0.01f
+#define BENCH_SAMPLES 1000000
+
+static float expectedSpO2() {
+    return -45.060f * RATIO * RATIO + 30.354f * RATIO + 94.845f;
+}
+
+// Pulse shape: fast systolic rise, slower decay, range 0..1
+static float pulse(float phase) {
+    return (phase < 0.15f) ? phase / 0.15f : expf(-(phase - 0.15f) * 4.0f);
+}
+
+// Feeds SECONDS of signal; returns the estimator's final SpO2
+static SpO2Estimator run(uint16_t rate) {
+    SpO2Estimator spo2;
+    spo2.begin(rate);
+    float period = 60.0f / BPM;
+    int lastBeat = -1;
+    for (uint32_t n = 0; n < (uint32_t)SECONDS * rate; n++) {
+        float t = (float)n / rate;
+        float wander = 1.0f + 0.001f * sinf(2 * PI * 0.1f * t); // Slow baseline drift
+        float p = pulse(fmodf(t, period) / period);
+        float ir = IR_DC * wander * (1.0f + PERFUSION * p);
+        float red = RED_DC * wander * (1.0f + PERFUSION * RATIO * p);
+        spo2.addSample((uint32_t)red, (uint32_t)ir);
+
+        // Close each beat at its peak
+        int beat = (int)((t - 0.15f * period) / period);
+        if (t >= 0.15f * period && beat != lastBeat) {
+            lastBeat = beat;
+            spo2.onBeat();
+        }
+    }
+    return spo2;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_dc_time_constant_follows_the_rate() {
+    SpO2Estimator spo2;
+    spo2.begin(100);
+    TEST_ASSERT_EQUAL(7, spo2.getDcShift());
+    spo2.begin(200);
+    TEST_ASSERT_EQUAL(8, spo2.getDcShift());
+    spo2.begin(400);
+    TEST_ASSERT_EQUAL(9, spo2.getDcShift());
+}
+
+void test_same_estimate_at_every_rate() {
+    SpO2Estimator reference = run(100);
+    TEST_ASSERT_INT_WITHIN(1, (int)(expectedSpO2() + 0.5f), reference.getSpO2());
+    TEST_ASSERT_GREATER_OR_EQUAL(80, reference.getSignalQuality());
+
+    const uint16_t rates[] = { 200, 400 };
+    for (uint8_t i = 0; i < 2; i++) {
+        SpO2Estimator spo2 = run(rates[i]);
+        TEST_ASSERT_EQUAL(reference.getSpO2(), spo2.getSpO2());
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, reference.getRatio(), spo2.getRatio());
+        TEST_ASSERT_INT_WITHIN(2, reference.getSignalQuality(), spo2.getSignalQuality());
+    }
+}
+
+void test_cost_per_sample() {
+    SpO2Estimator spo2;
+    spo2.begin(100);
+    static uint32_t red[1024], ir[1024];
+    for (uint16_t i = 0; i < 1024; i++) {
+        float p = pulse((i % 83) / 83.0f);
+        ir[i] = (uint32_t)(IR_DC * (1.0f + PERFUSION * p));
+        red[i] = (uint32_t)(RED_DC * (1.0f + PERFUSION * RATIO * p));
+    }
+
+    uint64_t start = hostNanos();
+    for (uint32_t n = 0; n < BENCH_SAMPLES; n++) {
+        spo2.addSample(red[n & 1023], ir[n & 1023]);
+        if ((n & 127) == 127) spo2.onBeat();
+    }
+    uint64_t elapsed = hostNanos() - start;
+    float nsPerSample = (float)elapsed / BENCH_SAMPLES;
+
+    Serial.printf("SpO2Estimator: %.1f ns/sample (addSample + onBeat every 128)\n", nsPerSample);
+    TEST_ASSERT_GREATER_THAN(0, spo2.getSpO2()); // Keeps the loop from being optimised out
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_dc_time_constant_follows_the_rate);
+    RUN_TEST(test_same_estimate_at_every_rate);
+    RUN_TEST(test_cost_per_sample);
+    return UNITY_END();
+}